@@ -0,0 +1,159 @@
+import Foundation
+import CryptoKit
+
+// Executables whose signature and hash were checked and matched no rule,
+// kept across launches so the first scan of a session only re-checks what
+// changed. Entries are keyed by path and hold the file's identity (device,
+// inode, size, mtime and ctime, like the bridge's hash cache), so any write to
+// the file invalidates its entry; a change to the signature/hash rules
+// invalidates all of them. The file is user-writable, and an entry in it
+// skips the signature and hash checks, so it is stored with an HMAC under the
+// warm start key and not trusted unless the MAC checks out.
+final class CleanExecutableCache {
+    struct FileIdentity: Codable, Equatable {
+        let device: UInt64
+        let inode: UInt64
+        let size: Int64
+        let modified: Int64         // nanoseconds since the epoch
+        let changed: Int64
+    }
+    
+    private struct Stored: Codable {
+        let version: Int
+        let rulesFingerprint: UInt64
+        let executables: [String: FileIdentity]
+    }
+    
+    // What is written to disk: the encoded Stored and its HMAC-SHA256
+    private struct Sealed: Codable {
+        let payload: Data
+        let mac: Data
+    }
+    
+    private static let formatVersion = 2
+    
+    private let url: URL?
+    private let capacity: Int
+    private let lock = NSLock()
+    
+    // Only touched under lock
+    private var rulesFingerprint: UInt64
+    private var executables: [String: FileIdentity] = [:]
+    private var isDirty = false
+    
+    init(url: URL?, rulesFingerprint: UInt64, capacity: Int = 8192) {
+        self.url = url
+        self.rulesFingerprint = rulesFingerprint
+        self.capacity = max(capacity, 1)
+    }
+    
+    // Merges the previous session's entries, if they were recorded under the current rules
+    func load() {
+        guard let url = url, let data = try? Data(contentsOf: url) else { return }
+        guard let key = WarmStartKey.key() else {
+            print("🔐 Ignoring clean executable cache: no key to authenticate it")
+            return
+        }
+        guard let sealed = try? JSONDecoder().decode(Sealed.self, from: data) else {
+            print("🔐 Ignoring unreadable clean executable cache")
+            return
+        }
+        guard HMAC<SHA256>.isValidAuthenticationCode(sealed.mac, authenticating: sealed.payload, using: SymmetricKey(data: key)) else {
+            print("🔐 Ignoring clean executable cache: authentication failed")
+            return
+        }
+        guard let stored = try? JSONDecoder().decode(Stored.self, from: sealed.payload), stored.version == Self.formatVersion else {
+            print("🔐 Ignoring unreadable clean executable cache")
+            return
+        }
+        
+        lock.lock()
+        let matchesRules = stored.rulesFingerprint == rulesFingerprint
+        if matchesRules {
+            executables.merge(stored.executables) { current, _ in current }
+        }
+        lock.unlock()
+        
+        if matchesRules {
+            print("🔐 Loaded \(stored.executables.count) known clean executables")
+        } else {
+            print("🔐 Signature/hash rules changed - clean executable cache discarded")
+        }
+    }
+    
+    func save() {
+        guard let url = url, let key = WarmStartKey.key() else { return }
+        
+        lock.lock()
+        guard isDirty else {
+            lock.unlock()
+            return
+        }
+        let stored = Stored(version: Self.formatVersion, rulesFingerprint: rulesFingerprint, executables: executables)
+        isDirty = false
+        lock.unlock()
+        
+        do {
+            try FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+            let payload = try JSONEncoder().encode(stored)
+            let mac = Data(HMAC<SHA256>.authenticationCode(for: payload, using: SymmetricKey(data: key)))
+            try JSONEncoder().encode(Sealed(payload: payload, mac: mac)).write(to: url, options: .atomic)
+        } catch {
+            print("🔐 Failed to save clean executable cache: \(error)")
+        }
+    }
+    
+    // New rules: nothing checked under the old ones counts as clean any more
+    func setRules(fingerprint: UInt64) {
+        lock.lock()
+        if fingerprint != rulesFingerprint {
+            rulesFingerprint = fingerprint
+            executables.removeAll()
+            isDirty = true
+        }
+        lock.unlock()
+    }
+    
+    func isClean(_ path: String) -> Bool {
+        guard let identity = Self.identity(of: path) else { return false }
+        lock.lock()
+        defer { lock.unlock() }
+        return executables[path] == identity
+    }
+    
+    // identity is the file as it was before it was checked; if the file has
+    // changed since, the verdict was for a different binary and is dropped
+    func markClean(_ path: String, checkedAs identity: FileIdentity) {
+        guard Self.identity(of: path) == identity else { return }
+        lock.lock()
+        if executables.count < capacity || executables[path] != nil {
+            executables[path] = identity
+            isDirty = true
+        }
+        lock.unlock()
+    }
+    
+    // Stable across launches (unlike Hasher): FNV-1a over the sorted rules
+    static func fingerprint(of rules: [String]) -> UInt64 {
+        var hash: UInt64 = 0xcbf29ce484222325
+        for rule in rules.sorted() {
+            for byte in rule.utf8 {
+                hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+            }
+            hash = (hash ^ 0x0A) &* 0x100000001b3
+        }
+        return hash
+    }
+    
+    static func identity(of path: String) -> FileIdentity? {
+        var info = stat()
+        guard !path.isEmpty, stat(path, &info) == 0 else { return nil }
+        return FileIdentity(
+            device: UInt64(bitPattern: Int64(info.st_dev)),
+            inode: UInt64(info.st_ino),
+            size: Int64(info.st_size),
+            modified: Int64(info.st_mtimespec.tv_sec) * 1_000_000_000 + Int64(info.st_mtimespec.tv_nsec),
+            changed: Int64(info.st_ctimespec.tv_sec) * 1_000_000_000 + Int64(info.st_ctimespec.tv_nsec)
+        )
+    }
+}
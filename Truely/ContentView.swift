@@ -3,6 +3,8 @@ import Foundation
 import AppKit
 import AVFoundation
 import CoreVideo
+import ScreenCaptureKit
+import UniformTypeIdentifiers
 
 extension Color {
     init(hex: String) {
@@ -194,11 +196,13 @@ struct ContentView: View {
     @State private var isUploadingDesktopCapture: Bool = false
     @State private var automaticScreenshotTimer: Timer?
     @State private var isTestVideoRecording: Bool = false
+    @State private var screenshotPipeline = ScreenshotPipeline()
     
     // MARK: - Startup Video Recording
     @State private var startupVideoRecorder: ScreenRecorder?
     @State private var hasStartedStartupVideo: Bool = false
     @State private var startupVideoTimer: Timer?
+    private let startupVideoSegmentDuration: TimeInterval = 5.0
     
     // MARK: - Session Management
     @State private var currentSessionId: String = ""
@@ -1282,102 +1286,65 @@ struct ContentView: View {
     
     // MARK: - Screen Capture Functions
     
-    private func captureAllDesktops() {
-        guard CGPreflightScreenCaptureAccess() else {
-            print("⚠️ Screen Recording: No screen recording permission for all desktops capture")
-            NotificationCenter.default.post(name: NSNotification.Name("ShowScreenRecordingPermissionAlert"), object: nil)
-            return
-        }
-        
-        let formatter = DateFormatter()
-        formatter.dateFormat = "yyyy-MM-dd_HH-mm-ss"
-        let timestamp = formatter.string(from: Date())
-        
-        let filename = "AllDesktops_\(timestamp).jpg"
-        let filePath = getCurrentFilePath(filename: filename)
-        
-        // Get all screens
-        let screens = NSScreen.screens
-        
+    // Captures the whole virtual desktop at nominal resolution. The raw frame is
+    // kept for change detection; the cursor is only drawn into the upload copy.
+    private func captureDesktopFrames() -> (raw: CGImage, withCursor: CGImage)? {
         // Calculate the total bounds of all screens
-        let totalBounds = screens.reduce(CGRect.null) { result, screen in
+        let totalBounds = NSScreen.screens.reduce(CGRect.null) { result, screen in
             result.union(screen.frame)
         }
         
-        // Capture the entire desktop area at a reasonable resolution
         guard let cgImage = CGWindowListCreateImage(
             totalBounds,
             .optionOnScreenOnly,
             kCGNullWindowID,
             .nominalResolution
         ) else {
-            print("❌ Screen Recording: Failed to capture desktop")
-            statusMessage = "Failed to capture desktop"
-            return
+            return nil
         }
         
-        // Create a new image with cursor overlay
-        let imageWithCursor = addCursorToImage(cgImage: cgImage, bounds: totalBounds)
-        
-        // Create NSImage from CGImage with cursor
-        let image = NSImage(cgImage: imageWithCursor, size: totalBounds.size)
-        
-        // Convert to JPEG with aggressive compression
-        guard let tiffData = image.tiffRepresentation,
-              let bitmapRep = NSBitmapImageRep(data: tiffData) else {
-            print("❌ Screen Recording: Failed to create bitmap representation")
-            statusMessage = "Failed to create image data"
+        return (cgImage, addCursorToImage(cgImage: cgImage, bounds: totalBounds))
+    }
+    
+    private func captureAllDesktops() {
+        guard CGPreflightScreenCaptureAccess() else {
+            print("⚠️ Screen Recording: No screen recording permission for all desktops capture")
+            NotificationCenter.default.post(name: NSNotification.Name("ShowScreenRecordingPermissionAlert"), object: nil)
             return
         }
         
-        // Use JPEG with very aggressive compression for much smaller file sizes
-        let jpegProperties: [NSBitmapImageRep.PropertyKey: Any] = [
-            .compressionFactor: 0.1  // Very aggressive JPEG compression (10% quality)
-        ]
+        let formatter = DateFormatter()
+        formatter.dateFormat = "yyyy-MM-dd_HH-mm-ss"
+        let timestamp = formatter.string(from: Date())
         
-        guard let data = bitmapRep.representation(using: .jpeg, properties: jpegProperties) else {
-            print("❌ Screen Recording: Failed to create JPEG data")
-            statusMessage = "Failed to create JPEG data"
+        guard let frames = captureDesktopFrames() else {
+            print("❌ Screen Recording: Failed to capture desktop")
+            statusMessage = "Failed to capture desktop"
             return
         }
         
-        // Check file size before saving
-        let fileSizeMB = Double(data.count) / (1024 * 1024)
-        print("📊 Screen Recording: Generated image size: \(String(format: "%.2f", fileSizeMB)) MB")
-        
-        // If still too large, try even more aggressive compression
-        if fileSizeMB > 1.0 {
-            print("⚠️ Screen Recording: Image still too large, applying ultra compression...")
+        // Downsampled and encoded once as HEIC off the main thread
+        screenshotPipeline.process(frame: frames.withCursor, skipUnchanged: false) { outcome in
+            guard case .encoded(let screenshot) = outcome else {
+                print("❌ Screen Recording: Failed to encode desktop capture")
+                self.statusMessage = "Failed to create image data"
+                return
+            }
             
-            // Try with even more aggressive compression
-            let ultraCompressionProperties: [NSBitmapImageRep.PropertyKey: Any] = [
-                .compressionFactor: 0.05  // Ultra aggressive compression (5% quality)
-            ]
+            let filename = "AllDesktops_\(timestamp).\(screenshot.fileExtension)"
+            let filePath = self.getCurrentFilePath(filename: filename)
+            let fileSizeMB = Double(screenshot.data.count) / (1024 * 1024)
+            print("📊 Screen Recording: Generated \(screenshot.pixelWidth)x\(screenshot.pixelHeight) image size: \(String(format: "%.2f", fileSizeMB)) MB")
             
-            if let ultraData = bitmapRep.representation(using: .jpeg, properties: ultraCompressionProperties) {
-                let ultraFileSizeMB = Double(ultraData.count) / (1024 * 1024)
-                print("📊 Screen Recording: Ultra compressed size: \(String(format: "%.2f", ultraFileSizeMB)) MB")
-                
-                do {
-                    try ultraData.write(to: URL(fileURLWithPath: filePath))
-                    print("✅ Screen Recording: All desktops captured successfully (ultra compressed): \(filename)")
-                    statusMessage = "All desktops captured (ultra compressed): \(filename)"
-                    return
-                } catch {
-                    print("❌ Screen Recording: Failed to save ultra compressed capture: \(error)")
-                }
+            do {
+                try screenshot.data.write(to: URL(fileURLWithPath: filePath))
+                print("✅ Screen Recording: All desktops captured successfully: \(filename)")
+                self.statusMessage = "All desktops captured: \(filename)"
+            } catch {
+                print("❌ Screen Recording: Failed to save all desktops capture: \(error)")
+                self.statusMessage = "Failed to save all desktops capture"
             }
         }
-        
-        // Save the normally compressed version
-        do {
-            try data.write(to: URL(fileURLWithPath: filePath))
-            print("✅ Screen Recording: All desktops captured successfully: \(filename)")
-            statusMessage = "All desktops captured: \(filename)"
-        } catch {
-            print("❌ Screen Recording: Failed to save all desktops capture: \(error)")
-            statusMessage = "Failed to save all desktops capture"
-        }
     }
     
     private func uploadDesktopCapture() {
@@ -1401,66 +1368,38 @@ struct ContentView: View {
         formatter.dateFormat = "yyyy-MM-dd_HH-mm-ss"
         let timestamp = formatter.string(from: Date())
         
-        let filename = "Manual_AllDesktops_\(timestamp).jpg"
-        let filePath = getCurrentFilePath(filename: filename)
-        
-        // Get all screens
-        let screens = NSScreen.screens
-        let totalBounds = screens.reduce(CGRect.null) { result, screen in
-            result.union(screen.frame)
-        }
-        
-        // Capture the entire desktop area
-        guard let cgImage = CGWindowListCreateImage(
-            totalBounds,
-            .optionOnScreenOnly,
-            kCGNullWindowID,
-            .nominalResolution
-        ) else {
+        guard let frames = captureDesktopFrames() else {
             print("❌ Screen Recording: Failed to capture desktop")
             statusMessage = "Failed to capture desktop"
             isUploadingDesktopCapture = false
             return
         }
         
-        // Create a new image with cursor overlay
-        let imageWithCursor = addCursorToImage(cgImage: cgImage, bounds: totalBounds)
-        
-        // Create NSImage from CGImage with cursor
-        let image = NSImage(cgImage: imageWithCursor, size: totalBounds.size)
-        
-        // Convert to JPEG with compression
-        guard let tiffData = image.tiffRepresentation,
-              let bitmapRep = NSBitmapImageRep(data: tiffData) else {
-            print("❌ Screen Recording: Failed to create bitmap representation")
-            statusMessage = "Failed to create image data"
-            isUploadingDesktopCapture = false
-            return
-        }
-        
-        let jpegProperties: [NSBitmapImageRep.PropertyKey: Any] = [
-            .compressionFactor: 0.1  // 10% quality for small file size
-        ]
-        
-        guard let data = bitmapRep.representation(using: .jpeg, properties: jpegProperties) else {
-            print("❌ Screen Recording: Failed to create JPEG data")
-            statusMessage = "Failed to create JPEG data"
-            isUploadingDesktopCapture = false
-            return
-        }
-        
-        // Save the image locally first
-        do {
-            try data.write(to: URL(fileURLWithPath: filePath))
-            print("✅ Screen Recording: Desktop captured for upload: \(filename)")
+        // A manual capture is always uploaded, changed or not
+        screenshotPipeline.process(frame: frames.withCursor, skipUnchanged: false) { outcome in
+            guard case .encoded(let screenshot) = outcome else {
+                print("❌ Screen Recording: Failed to encode desktop capture")
+                self.statusMessage = "Failed to create image data"
+                self.isUploadingDesktopCapture = false
+                return
+            }
             
-            // Now upload to server
-            uploadDesktopCaptureToServer(filePath: filePath, filename: filename)
+            let filename = "Manual_AllDesktops_\(timestamp).\(screenshot.fileExtension)"
+            let filePath = self.getCurrentFilePath(filename: filename)
             
-        } catch {
-            print("❌ Screen Recording: Failed to save desktop capture: \(error)")
-            statusMessage = "Failed to save desktop capture"
-            isUploadingDesktopCapture = false
+            // Save the image locally first
+            do {
+                try screenshot.data.write(to: URL(fileURLWithPath: filePath))
+                print("✅ Screen Recording: Desktop captured for upload: \(filename)")
+                
+                // Now upload to server
+                self.uploadDesktopCaptureToServer(filePath: filePath, filename: filename)
+                
+            } catch {
+                print("❌ Screen Recording: Failed to save desktop capture: \(error)")
+                self.statusMessage = "Failed to save desktop capture"
+                self.isUploadingDesktopCapture = false
+            }
         }
     }
     
@@ -1497,6 +1436,9 @@ struct ContentView: View {
         // Stop any existing timer
         stopAutomaticScreenshotUploads()
         
+        // The startup screenshot is always uploaded as the new baseline
+        screenshotPipeline.resetChangeTracking()
+        
         // Upload first screenshot after 5 seconds
         DispatchQueue.main.asyncAfter(deadline: .now() + 5.0) {
             self.performAutomaticScreenshotUpload(prefix: "Startup")
@@ -1532,58 +1474,40 @@ struct ContentView: View {
         formatter.dateFormat = "yyyy-MM-dd_HH-mm-ss"
         let timestamp = formatter.string(from: Date())
         
-        let filename = "\(prefix)_AllDesktops_\(timestamp).jpg"
-        let filePath = getCurrentFilePath(filename: filename)
-        
-        // Get all screens
-        let screens = NSScreen.screens
-        let totalBounds = screens.reduce(CGRect.null) { result, screen in
-            result.union(screen.frame)
-        }
-        
-        // Capture the entire desktop area
-        guard let cgImage = CGWindowListCreateImage(
-            totalBounds,
-            .optionOnScreenOnly,
-            kCGNullWindowID,
-            .nominalResolution
-        ) else {
+        guard let frames = captureDesktopFrames() else {
             print("❌ Screen Recording: Failed to capture desktop for automatic upload")
             return
         }
         
-        // Create a new image with cursor overlay
-        let imageWithCursor = addCursorToImage(cgImage: cgImage, bounds: totalBounds)
-        
-        // Create NSImage from CGImage with cursor
-        let image = NSImage(cgImage: imageWithCursor, size: totalBounds.size)
-        
-        // Convert to JPEG with compression
-        guard let tiffData = image.tiffRepresentation,
-              let bitmapRep = NSBitmapImageRep(data: tiffData) else {
-            print("❌ Screen Recording: Failed to create bitmap representation for automatic upload")
-            return
-        }
-        
-        let jpegProperties: [NSBitmapImageRep.PropertyKey: Any] = [
-            .compressionFactor: 0.1  // 10% quality for small file size
-        ]
-        
-        guard let data = bitmapRep.representation(using: .jpeg, properties: jpegProperties) else {
-            print("❌ Screen Recording: Failed to create JPEG data for automatic upload")
-            return
-        }
-        
-        // Save the image locally first
-        do {
-            try data.write(to: URL(fileURLWithPath: filePath))
-            print("✅ Screen Recording: Automatic desktop captured: \(filename)")
-            
-            // Now upload to server
-            uploadAutomaticScreenshotToServer(filePath: filePath, filename: filename, prefix: prefix)
-            
-        } catch {
-            print("❌ Screen Recording: Failed to save automatic desktop capture: \(error)")
+        // Frames whose tiles all match the last upload are skipped (capped, so a
+        // periodic frame still goes out); pointer movement alone doesn't count
+        screenshotPipeline.process(frame: frames.withCursor, reference: frames.raw, skipUnchanged: true) { outcome in
+            switch outcome {
+            case .unchanged(let totalTiles):
+                print("📸 Skipping automatic screenshot - no change in \(totalTiles) tiles since last upload")
+                
+            case .failed:
+                print("❌ Screen Recording: Failed to encode automatic desktop capture")
+                
+            case .encoded(let screenshot):
+                let filename = "\(prefix)_AllDesktops_\(timestamp).\(screenshot.fileExtension)"
+                let filePath = self.getCurrentFilePath(filename: filename)
+                if screenshot.totalTiles > 0 {
+                    print("📸 Automatic screenshot changed \(screenshot.changedTiles)/\(screenshot.totalTiles) tiles")
+                }
+                
+                // Save the image locally first
+                do {
+                    try screenshot.data.write(to: URL(fileURLWithPath: filePath))
+                    print("✅ Screen Recording: Automatic desktop captured: \(filename)")
+                    
+                    // Now upload to server
+                    self.uploadAutomaticScreenshotToServer(filePath: filePath, filename: filename, prefix: prefix)
+                    
+                } catch {
+                    print("❌ Screen Recording: Failed to save automatic desktop capture: \(error)")
+                }
+            }
         }
     }
     
@@ -1784,9 +1708,9 @@ struct ContentView: View {
                 self.stopRecordingTimer()
                 
                 switch result {
-                case .success(let filename):
-                    print("✅ Video Recording: Stopped successfully - \(filename)")
-                    self.statusMessage = "Video recording saved: \(filename)"
+                case .success(let filenames):
+                    print("✅ Video Recording: Stopped successfully - \(filenames)")
+                    self.statusMessage = "Video recording saved: \(filenames.joined(separator: ", "))"
                 case .failure(let error):
                     print("❌ Video Recording: Failed to stop: \(error)")
                     self.statusMessage = "Failed to save video recording"
@@ -1821,8 +1745,18 @@ struct ContentView: View {
         
         print("🎥 Startup Video: Starting 45-second startup video recording...")
         
-        // Create screen recorder
-        startupVideoRecorder = ScreenRecorder()
+        // Create a segmented screen recorder; each fragment is queued for upload
+        // as soon as it closes, so the upload overlaps the recording
+        let recorder = ScreenRecorder(segmentDuration: startupVideoSegmentDuration)
+        let folderName = currentSessionId
+        recorder.onSegmentWritten = { segmentURL in
+            self.logUploadService.uploadVideo(
+                filePath: segmentURL.path,
+                folderName: folderName,
+                fileName: segmentURL.lastPathComponent
+            )
+        }
+        startupVideoRecorder = recorder
         
         // Create custom filename for startup video
         let formatter = DateFormatter()
@@ -1830,11 +1764,8 @@ struct ContentView: View {
         let timestamp = formatter.string(from: Date())
         let customFilename = "StartupVideo_\(timestamp).mp4"
         
-        // Update the ScreenRecorder to use session folder path
-        // We'll need to modify the ScreenRecorder to accept a custom path
-        
         // Start recording with session folder path
-        startupVideoRecorder?.startRecording(customFilename: customFilename, customPath: sessionFolderPath) { result in
+        recorder.startRecording(customFilename: customFilename, customPath: sessionFolderPath) { result in
             DispatchQueue.main.async {
                 switch result {
                 case .success:
@@ -1862,14 +1793,14 @@ struct ContentView: View {
         recorder.stopRecording { result in
             DispatchQueue.main.async {
                 switch result {
-                case .success(let filename):
-                    print("✅ Startup Video: Recording completed: \(filename)")
+                case .success(let filenames):
+                    print("✅ Startup Video: Recording completed: \(filenames)")
                     
-                    // Construct full file path using session folder
-                    let fullFilePath = (self.sessionFolderPath as NSString).appendingPathComponent(filename)
-                    
-                    // Upload the startup video
-                    self.uploadStartupVideoToServer(filePath: fullFilePath)
+                    // Fragments are already queued; each display's playlist goes up after them
+                    for filename in filenames {
+                        let fullFilePath = (self.sessionFolderPath as NSString).appendingPathComponent(filename)
+                        self.uploadStartupVideoToServer(filePath: fullFilePath)
+                    }
                     
                 case .failure(let error):
                     print("❌ Startup Video: Failed to stop: \(error)")
@@ -1926,19 +1857,13 @@ struct ContentView: View {
         // Extract filename from path
         let fileName = (filePath as NSString).lastPathComponent
         
-        print("🎥 Startup Video: Uploading startup video: \(fileName) to folder: \(folderName)")
+        print("🎥 Startup Video: Queueing startup video playlist: \(fileName) to folder: \(folderName)")
         
         logUploadService.uploadVideo(
             filePath: filePath,
             folderName: folderName,
             fileName: fileName
-        ) { success, error in
-            if success {
-                print("✅ Startup Video: Uploaded successfully: \(fileName)")
-            } else {
-                print("❌ Startup Video: Upload failed: \(fileName) - \(error ?? "Unknown error")")
-            }
-        }
+        )
     }
     
     // MARK: - Test Video Recording Functions
@@ -1990,15 +1915,15 @@ struct ContentView: View {
                 self.isTestVideoRecording = false
                 
                 switch result {
-                case .success(let filename):
-                    print("✅ Test Video: Recording completed: \(filename)")
+                case .success(let filenames):
+                    print("✅ Test Video: Recording completed: \(filenames)")
                     self.statusMessage = "Test video recorded, uploading..."
                     
-                    // Construct full file path using session folder
-                    let fullFilePath = (self.sessionFolderPath as NSString).appendingPathComponent(filename)
-                    
-                    // Upload the test video
-                    self.uploadTestVideoToServer(filePath: fullFilePath)
+                    // Upload the test video (one file per display)
+                    for filename in filenames {
+                        let fullFilePath = (self.sessionFolderPath as NSString).appendingPathComponent(filename)
+                        self.uploadTestVideoToServer(filePath: fullFilePath)
+                    }
                     
                 case .failure(let error):
                     print("❌ Test Video: Failed to stop: \(error)")
@@ -2105,26 +2030,33 @@ struct ContentView: View {
 
 // MARK: - Screen Recorder Class
 
-class ScreenRecorder: NSObject {
-    private var assetWriter: AVAssetWriter?
-    private var assetWriterInput: AVAssetWriterInput?
-    private var pixelBufferAdaptor: AVAssetWriterInputPixelBufferAdaptor?
-    private var displayLink: CVDisplayLink?
-    private var outputURL: URL?
+// ScreenCaptureKit delivers IOSurface-backed frames at a fixed rate with the
+// cursor composited by the window server; they are appended to the writer
+// as-is, so recording does no per-frame capture, drawing or allocation.
+// A stream captures one display, so every attached display gets its own
+// stream and writer: the main display under the requested file name, the
+// others as "<name>_display2", "<name>_display3" and so on.
+// With a segment duration the writers emit fMP4 fragments (HLS layout)
+// instead of one file each, and each is handed out as soon as it is on disk.
+class ScreenRecorder {
+    private let framesPerSecond: Int
+    private let segmentDuration: TimeInterval?
+    private var captures: [DisplayCapture] = []
     private var isRecording = false
-    private var frameCount = 0
-    private var startTime: CMTime = .zero
     
-    override init() {
-        super.init()
+    // Writer and stream state of every display is only touched on this queue
+    private let sampleQueue = DispatchQueue(label: "com.truely.screenrecorder", qos: .userInitiated)
+    
+    // Called on the sample queue with each fragment file (initialization segment first)
+    var onSegmentWritten: ((URL) -> Void)?
+    
+    init(framesPerSecond: Int = 15, segmentDuration: TimeInterval? = nil) {
+        self.framesPerSecond = max(framesPerSecond, 1)
+        self.segmentDuration = segmentDuration.map { max($0, 1.0) }
     }
     
+    // Succeeds once at least one display is recording; displays that fail to start are logged and skipped
     func startRecording(customFilename: String? = nil, customPath: String? = nil, completion: @escaping (Result<Void, Error>) -> Void) {
-        guard !isRecording else {
-            completion(.failure(ScreenRecorderError.alreadyRecording))
-            return
-        }
-        
         // Create output file
         let formatter = DateFormatter()
         formatter.dateFormat = "yyyy-MM-dd_HH-mm-ss"
@@ -2132,225 +2064,413 @@ class ScreenRecorder: NSObject {
         
         let basePath = customPath ?? NSSearchPathForDirectoriesInDomains(.desktopDirectory, .userDomainMask, true).first ?? ""
         let filename = customFilename ?? "ScreenRecording_\(timestamp).mp4"
-        outputURL = URL(fileURLWithPath: (basePath as NSString).appendingPathComponent(filename))
+        let outputURL = URL(fileURLWithPath: (basePath as NSString).appendingPathComponent(filename))
         
-        guard let outputURL = outputURL else {
-            completion(.failure(ScreenRecorderError.invalidOutputURL))
-            return
-        }
-        
-        // Get screen dimensions
-        let screens = NSScreen.screens
-        let totalBounds = screens.reduce(CGRect.null) { result, screen in
-            result.union(screen.frame)
+        SCShareableContent.getWithCompletionHandler { content, error in
+            self.sampleQueue.async {
+                guard !self.isRecording else {
+                    completion(.failure(ScreenRecorderError.alreadyRecording))
+                    return
+                }
+                
+                // The main display (the one with the menu bar) first, then the rest
+                guard let displays = content?.displays, !displays.isEmpty else {
+                    completion(.failure(error ?? ScreenRecorderError.noDisplay))
+                    return
+                }
+                let mainDisplayID = CGMainDisplayID()
+                let ordered = displays.filter { $0.displayID == mainDisplayID } + displays.filter { $0.displayID != mainDisplayID }
+                if ordered.count > 1 {
+                    print("🎥 Screen Recorder: \(ordered.count) displays attached - recording each to its own file")
+                }
+                
+                var captures: [DisplayCapture] = []
+                var firstError: Error?
+                for (index, display) in ordered.enumerated() {
+                    let capture = DisplayCapture(
+                        display: display,
+                        outputURL: index == 0 ? outputURL : Self.outputURL(outputURL, displayNumber: index + 1),
+                        framesPerSecond: self.framesPerSecond,
+                        segmentDuration: self.segmentDuration,
+                        sampleQueue: self.sampleQueue
+                    ) { [weak self] segmentURL in
+                        self?.onSegmentWritten?(segmentURL)
+                    }
+                    do {
+                        try capture.prepareWriter()
+                        captures.append(capture)
+                    } catch {
+                        print("❌ Screen Recorder: Cannot record display \(display.displayID): \(error.localizedDescription)")
+                        firstError = firstError ?? error
+                    }
+                }
+                
+                self.isRecording = true
+                self.startStreams(captures, firstError: firstError, completion: completion)
+            }
         }
-        
-        let width = Int(totalBounds.width)
-        let height = Int(totalBounds.height)
-        
-        // Configure video settings for small file size and 2x speed
-        let videoSettings: [String: Any] = [
-            AVVideoCodecKey: AVVideoCodecType.h264,
-            AVVideoWidthKey: width,
-            AVVideoHeightKey: height,
-            AVVideoCompressionPropertiesKey: [
-                AVVideoAverageBitRateKey: 500_000, // 500 kbps for small file size
-                AVVideoMaxKeyFrameIntervalKey: 60, // Key frame every 60 frames (2x more frequent)
-                AVVideoProfileLevelKey: AVVideoProfileLevelH264BaselineAutoLevel
-            ]
-        ]
-        
-        do {
-            assetWriter = try AVAssetWriter(outputURL: outputURL, fileType: .mp4)
-            assetWriterInput = AVAssetWriterInput(mediaType: .video, outputSettings: videoSettings)
-            assetWriterInput?.expectsMediaDataInRealTime = true
-            
-            let sourcePixelBufferAttributes: [String: Any] = [
-                kCVPixelBufferPixelFormatTypeKey as String: kCVPixelFormatType_32ARGB,
-                kCVPixelBufferWidthKey as String: width,
-                kCVPixelBufferHeightKey as String: height
-            ]
-            
-            pixelBufferAdaptor = AVAssetWriterInputPixelBufferAdaptor(
-                assetWriterInput: assetWriterInput!,
-                sourcePixelBufferAttributes: sourcePixelBufferAttributes
-            )
-            
-            if assetWriter?.canAdd(assetWriterInput!) == true {
-                assetWriter?.add(assetWriterInput!)
-            } else {
-                completion(.failure(ScreenRecorderError.cannotAddInput))
+    }
+    
+    // Completes with one file name per recorded display (the playlist when
+    // segmented), main display first
+    func stopRecording(completion: @escaping (Result<[String], Error>) -> Void) {
+        sampleQueue.async {
+            guard self.isRecording else {
+                DispatchQueue.main.async {
+                    completion(.failure(ScreenRecorderError.notRecording))
+                }
                 return
             }
             
-            assetWriter?.startWriting()
-            assetWriter?.startSession(atSourceTime: .zero)
-            
-            isRecording = true
-            startTime = .zero
-            frameCount = 0
+            self.isRecording = false
+            let captures = self.captures
+            self.captures = []
             
-            // Start display link for screen capture
-            startDisplayLink()
-            
-            completion(.success(()))
+            var results = [Result<String, Error>?](repeating: nil, count: captures.count)
+            let group = DispatchGroup()
+            for (index, capture) in captures.enumerated() {
+                group.enter()
+                capture.stop { result in
+                    results[index] = result
+                    group.leave()
+                }
+            }
             
-        } catch {
-            completion(.failure(error))
+            group.notify(queue: self.sampleQueue) {
+                let filenames = results.compactMap { try? $0?.get() }
+                let firstError = results.compactMap { result -> Error? in
+                    guard case .failure(let error)? = result else { return nil }
+                    return error
+                }.first
+                
+                DispatchQueue.main.async {
+                    if filenames.isEmpty {
+                        completion(.failure(firstError ?? ScreenRecorderError.noFramesCaptured))
+                    } else {
+                        completion(.success(filenames))
+                    }
+                }
+            }
         }
     }
     
-    func stopRecording(completion: @escaping (Result<String, Error>) -> Void) {
-        guard isRecording else {
-            completion(.failure(ScreenRecorderError.notRecording))
-            return
-        }
-        
-        isRecording = false
-        stopDisplayLink()
-        
-        assetWriterInput?.markAsFinished()
-        assetWriter?.finishWriting {
-            DispatchQueue.main.async {
-                if let filename = self.outputURL?.lastPathComponent {
-                    completion(.success(filename))
+    // Runs on the sample queue
+    private func startStreams(_ captures: [DisplayCapture], firstError: Error?, completion: @escaping (Result<Void, Error>) -> Void) {
+        var started = [Bool](repeating: false, count: captures.count)
+        var firstError = firstError
+        let group = DispatchGroup()
+        for (index, capture) in captures.enumerated() {
+            group.enter()
+            capture.startStream { error in
+                if let error = error {
+                    print("❌ Screen Recorder: Display \(capture.display.displayID) failed to start: \(error.localizedDescription)")
+                    firstError = firstError ?? error
                 } else {
-                    completion(.failure(ScreenRecorderError.invalidOutputURL))
+                    started[index] = true
                 }
+                group.leave()
             }
         }
-    }
-    
-    private func startDisplayLink() {
-        var displayLink: CVDisplayLink?
-        CVDisplayLinkCreateWithActiveCGDisplays(&displayLink)
         
-        guard let displayLink = displayLink else { return }
-        
-        self.displayLink = displayLink
-        
-        CVDisplayLinkSetOutputCallback(displayLink, { (displayLink, _, _, _, _, displayLinkContext) -> CVReturn in
-            let recorder = Unmanaged<ScreenRecorder>.fromOpaque(displayLinkContext!).takeUnretainedValue()
-            recorder.captureFrame()
-            return kCVReturnSuccess
-        }, Unmanaged.passUnretained(self).toOpaque())
-        
-        CVDisplayLinkStart(displayLink)
-    }
-    
-    private func stopDisplayLink() {
-        if let displayLink = displayLink {
-            CVDisplayLinkStop(displayLink)
-            self.displayLink = nil
+        group.notify(queue: sampleQueue) {
+            self.captures = zip(captures, started).filter { $0.1 }.map { $0.0 }
+            if self.captures.isEmpty {
+                self.isRecording = false
+                completion(.failure(firstError ?? ScreenRecorderError.noDisplay))
+            } else {
+                completion(.success(()))
+            }
         }
     }
     
-    private func captureFrame() {
-        guard isRecording,
-              let assetWriterInput = assetWriterInput,
-              assetWriterInput.isReadyForMoreMediaData else { return }
-        
-        // Capture screen
-        let screens = NSScreen.screens
-        let totalBounds = screens.reduce(CGRect.null) { result, screen in
-            result.union(screen.frame)
+    private static func outputURL(_ url: URL, displayNumber: Int) -> URL {
+        let name = "\(url.deletingPathExtension().lastPathComponent)_display\(displayNumber)"
+        return url.deletingLastPathComponent().appendingPathComponent(name).appendingPathExtension(url.pathExtension)
+    }
+    
+    // MARK: - Display Capture
+    
+    // One display's stream and writer. Everything here runs on the recorder's
+    // sample queue, and completions are called back on it.
+    private final class DisplayCapture: NSObject, SCStreamOutput, SCStreamDelegate, AVAssetWriterDelegate {
+        let display: SCDisplay
+        private let outputURL: URL
+        private let framesPerSecond: Int
+        private let segmentDuration: TimeInterval?
+        private let sampleQueue: DispatchQueue
+        private let onSegmentWritten: (URL) -> Void
+        
+        private var assetWriter: AVAssetWriter?
+        private var assetWriterInput: AVAssetWriterInput?
+        private var stream: SCStream?
+        private var isCapturing = false
+        private var hasStartedSession = false
+        private var frameCount = 0
+        private var segmentIndex = 0
+        private var segmentEntries: [(fileName: String, duration: Double)] = []
+        private var initializationSegmentName: String?
+        
+        init(display: SCDisplay, outputURL: URL, framesPerSecond: Int, segmentDuration: TimeInterval?, sampleQueue: DispatchQueue, onSegmentWritten: @escaping (URL) -> Void) {
+            self.display = display
+            self.outputURL = outputURL
+            self.framesPerSecond = framesPerSecond
+            self.segmentDuration = segmentDuration
+            self.sampleQueue = sampleQueue
+            self.onSegmentWritten = onSegmentWritten
+            super.init()
+        }
+        
+        func stop(completion: @escaping (Result<String, Error>) -> Void) {
+            isCapturing = false
+            let stream = self.stream
+            self.stream = nil
+            
+            guard let activeStream = stream else {
+                finishWriting(completion: completion)
+                return
+            }
+            
+            activeStream.stopCapture { error in
+                if let error = error {
+                    print("⚠️ Screen Recorder: Stream stop reported \(error.localizedDescription)")
+                }
+                self.sampleQueue.async {
+                    self.finishWriting(completion: completion)
+                }
+            }
         }
         
-        guard let cgImage = CGWindowListCreateImage(
-            totalBounds,
-            .optionOnScreenOnly,
-            kCGNullWindowID,
-            .nominalResolution
-        ) else { return }
-        
-        // Add cursor to the captured image
-        let imageWithCursor = addCursorToImage(cgImage: cgImage, bounds: totalBounds)
-        
-        // Convert to pixel buffer
-        let width = Int(totalBounds.width)
-        let height = Int(totalBounds.height)
-        
-        var pixelBuffer: CVPixelBuffer?
-        let status = CVPixelBufferCreate(
-            kCFAllocatorDefault,
-            width,
-            height,
-            kCVPixelFormatType_32ARGB,
-            nil,
-            &pixelBuffer
-        )
-        
-        guard status == kCVReturnSuccess, let pixelBuffer = pixelBuffer else { return }
-        
-        CVPixelBufferLockBaseAddress(pixelBuffer, [])
-        defer { CVPixelBufferUnlockBaseAddress(pixelBuffer, []) }
-        
-        let context = CGContext(
-            data: CVPixelBufferGetBaseAddress(pixelBuffer),
-            width: width,
-            height: height,
-            bitsPerComponent: 8,
-            bytesPerRow: CVPixelBufferGetBytesPerRow(pixelBuffer),
-            space: CGColorSpaceCreateDeviceRGB(),
-            bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue
-        )
-        
-        context?.draw(imageWithCursor, in: CGRect(x: 0, y: 0, width: width, height: height))
-        
-        // Calculate presentation time for 2x speed (60 FPS effective playback)
-        let presentationTime = CMTime(value: CMTimeValue(frameCount), timescale: 60) // 60 FPS for 2x speed
+        // MARK: Writer
         
-        // Append to video
-        if pixelBufferAdaptor?.append(pixelBuffer, withPresentationTime: presentationTime) == true {
-            frameCount += 1
+        func prepareWriter() throws {
+            // Configure video settings for small file size
+            let videoSettings: [String: Any] = [
+                AVVideoCodecKey: AVVideoCodecType.h264,
+                AVVideoWidthKey: display.width,
+                AVVideoHeightKey: display.height,
+                AVVideoCompressionPropertiesKey: [
+                    AVVideoAverageBitRateKey: 500_000, // 500 kbps for small file size
+                    AVVideoMaxKeyFrameIntervalKey: framesPerSecond * 4,
+                    AVVideoProfileLevelKey: AVVideoProfileLevelH264BaselineAutoLevel
+                ]
+            ]
+            
+            let writer: AVAssetWriter
+            if let segmentDuration = segmentDuration {
+                // Fragments are delivered to the delegate rather than written to outputURL
+                guard let contentType = UTType(AVFileType.mp4.rawValue) else {
+                    throw ScreenRecorderError.invalidOutputURL
+                }
+                writer = AVAssetWriter(contentType: contentType)
+                writer.outputFileTypeProfile = .mpeg4AppleHLS
+                writer.preferredOutputSegmentInterval = CMTime(seconds: segmentDuration, preferredTimescale: 600)
+                writer.delegate = self
+            } else {
+                writer = try AVAssetWriter(outputURL: outputURL, fileType: .mp4)
+            }
+            
+            let input = AVAssetWriterInput(mediaType: .video, outputSettings: videoSettings)
+            input.expectsMediaDataInRealTime = true
+            
+            guard writer.canAdd(input) else {
+                throw ScreenRecorderError.cannotAddInput
+            }
+            writer.add(input)
+            
+            // Segmented writers start on the first frame, once initialSegmentStartTime is known
+            if segmentDuration == nil {
+                guard writer.startWriting() else {
+                    throw writer.error ?? ScreenRecorderError.cannotAddInput
+                }
+            }
+            
+            self.assetWriter = writer
+            self.assetWriterInput = input
+            self.hasStartedSession = false
+            self.frameCount = 0
+            self.segmentIndex = 0
+            self.segmentEntries = []
+            self.initializationSegmentName = nil
+        }
+        
+        private func finishWriting(completion: @escaping (Result<String, Error>) -> Void) {
+            guard let writer = assetWriter, hasStartedSession else {
+                assetWriter?.cancelWriting()
+                resetWriter()
+                completion(.failure(ScreenRecorderError.noFramesCaptured))
+                return
+            }
+            
+            assetWriterInput?.markAsFinished()
+            let filename = outputURL.lastPathComponent
+            let frames = frameCount
+            let displayID = display.displayID
+            let isSegmented = segmentDuration != nil
+            writer.finishWriting {
+                print("🎥 Screen Recorder: Wrote \(frames) frames of display \(displayID)")
+                // The last fragment reaches the delegate before this handler runs, and its
+                // bookkeeping was queued first, so the playlist sees every segment
+                self.sampleQueue.async {
+                    var result: Result<String, Error>
+                    if writer.status == .completed {
+                        result = .success(filename)
+                    } else {
+                        result = .failure(writer.error ?? ScreenRecorderError.invalidOutputURL)
+                    }
+                    if isSegmented, case .success = result {
+                        result = Result { try self.writePlaylist() }
+                    }
+                    completion(result)
+                }
+            }
+            resetWriter()
         }
-    }
-    
-    private func addCursorToImage(cgImage: CGImage, bounds: CGRect) -> CGImage {
-        let width = Int(bounds.width)
-        let height = Int(bounds.height)
         
-        // Create a new bitmap context with the cursor
-        let colorSpace = CGColorSpaceCreateDeviceRGB()
-        let context = CGContext(
-            data: nil,
-            width: width,
-            height: height,
-            bitsPerComponent: 8,
-            bytesPerRow: width * 4,
-            space: colorSpace,
-            bitmapInfo: CGImageAlphaInfo.premultipliedLast.rawValue
-        )
-        
-        guard let context = context else { return cgImage }
+        private func resetWriter() {
+            assetWriter = nil
+            assetWriterInput = nil
+            hasStartedSession = false
+        }
         
-        // Draw the original image
-        context.draw(cgImage, in: CGRect(x: 0, y: 0, width: width, height: height))
+        // MARK: Segments
         
-        // Get cursor position and image
-        let cursorPosition = NSEvent.mouseLocation
-        let cursorImage = NSCursor.current.image
+        func assetWriter(_ writer: AVAssetWriter, didOutputSegmentData segmentData: Data, segmentType: AVAssetSegmentType, segmentReport: AVAssetSegmentReport?) {
+            let duration = segmentReport?.trackReports.first?.duration.seconds
+            sampleQueue.async {
+                let baseName = self.outputURL.deletingPathExtension().lastPathComponent
+                
+                let fileName: String
+                switch segmentType {
+                case .initialization:
+                    fileName = "\(baseName)_init.mp4"
+                default:
+                    self.segmentIndex += 1
+                    fileName = String(format: "%@_%05d.m4s", baseName, self.segmentIndex)
+                }
+                
+                let segmentURL = self.outputURL.deletingLastPathComponent().appendingPathComponent(fileName)
+                do {
+                    try segmentData.write(to: segmentURL)
+                } catch {
+                    print("❌ Screen Recorder: Failed to write segment \(fileName): \(error.localizedDescription)")
+                    return
+                }
+                
+                if segmentType == .initialization {
+                    self.initializationSegmentName = fileName
+                } else {
+                    self.segmentEntries.append((fileName, duration ?? self.segmentDuration ?? 0))
+                }
+                self.onSegmentWritten(segmentURL)
+            }
+        }
         
-        // Convert cursor position to image coordinates
-        let cursorX = cursorPosition.x - bounds.origin.x
-        let cursorY = bounds.height - (cursorPosition.y - bounds.origin.y) - cursorImage.size.height
+        // Media playlist over the written fragments so the uploaded set plays back as one video
+        private func writePlaylist() throws -> String {
+            guard let initializationSegmentName = initializationSegmentName else {
+                throw ScreenRecorderError.noFramesCaptured
+            }
+            
+            let targetDuration = Int((segmentEntries.map { $0.duration }.max() ?? segmentDuration ?? 1).rounded(.up))
+            var lines = [
+                "#EXTM3U",
+                "#EXT-X-VERSION:7",
+                "#EXT-X-TARGETDURATION:\(targetDuration)",
+                "#EXT-X-PLAYLIST-TYPE:VOD",
+                "#EXT-X-MAP:URI=\"\(initializationSegmentName)\""
+            ]
+            for entry in segmentEntries {
+                lines.append(String(format: "#EXTINF:%.3f,", entry.duration))
+                lines.append(entry.fileName)
+            }
+            lines.append("#EXT-X-ENDLIST")
+            
+            let playlistURL = outputURL.deletingPathExtension().appendingPathExtension("m3u8")
+            try (lines.joined(separator: "\n") + "\n").write(to: playlistURL, atomically: true, encoding: .utf8)
+            return playlistURL.lastPathComponent
+        }
+        
+        // MARK: Capture Stream
+        
+        func startStream(completion: @escaping (Error?) -> Void) {
+            let configuration = SCStreamConfiguration()
+            configuration.width = display.width
+            configuration.height = display.height
+            configuration.minimumFrameInterval = CMTime(value: 1, timescale: CMTimeScale(framesPerSecond))
+            // NV12 is what the hardware H.264 encoder consumes, so no color conversion either
+            configuration.pixelFormat = kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange
+            configuration.showsCursor = true
+            // Surfaces held by the encoder come back to the stream's own pool
+            configuration.queueDepth = 6
+            
+            let filter = SCContentFilter(display: display, excludingWindows: [])
+            let stream = SCStream(filter: filter, configuration: configuration, delegate: self)
+            do {
+                try stream.addStreamOutput(self, type: .screen, sampleHandlerQueue: sampleQueue)
+            } catch {
+                assetWriter?.cancelWriting()
+                resetWriter()
+                completion(error)
+                return
+            }
+            
+            self.stream = stream
+            self.isCapturing = true
+            
+            stream.startCapture { error in
+                self.sampleQueue.async {
+                    if let error = error {
+                        self.isCapturing = false
+                        self.stream = nil
+                        self.assetWriter?.cancelWriting()
+                        self.resetWriter()
+                    } else {
+                        print("🎥 Screen Recorder: Capturing display \(self.display.displayID) at \(self.framesPerSecond) fps")
+                    }
+                    completion(error)
+                }
+            }
+        }
         
-        // Draw cursor if it's within the capture bounds
-        if cursorX >= 0 && cursorY >= 0 && 
-           cursorX + cursorImage.size.width <= bounds.width && 
-           cursorY + cursorImage.size.height <= bounds.height {
+        func stream(_ stream: SCStream, didOutputSampleBuffer sampleBuffer: CMSampleBuffer, of type: SCStreamOutputType) {
+            guard type == .screen, isCapturing, sampleBuffer.isValid,
+                  let writer = assetWriter, let input = assetWriterInput else { return }
             
-            if let cursorCGImage = cursorImage.cgImage(forProposedRect: nil, context: nil, hints: nil) {
-                context.draw(cursorCGImage, in: CGRect(
-                    x: cursorX,
-                    y: cursorY,
-                    width: cursorImage.size.width,
-                    height: cursorImage.size.height
-                ))
+            // Idle/blank frames carry no image; the encoder just holds the previous one
+            guard let attachments = CMSampleBufferGetSampleAttachmentsArray(sampleBuffer, createIfNecessary: false) as? [[SCStreamFrameInfo: Any]],
+                  let statusValue = attachments.first?[.status] as? Int,
+                  SCFrameStatus(rawValue: statusValue) == .complete else { return }
+            
+            if !hasStartedSession {
+                let startTime = sampleBuffer.presentationTimeStamp
+                if segmentDuration != nil {
+                    // Fragment boundaries are counted from here, so it must precede startWriting
+                    writer.initialSegmentStartTime = startTime
+                    guard writer.startWriting() else {
+                        print("❌ Screen Recorder: Failed to start segmented writer: \(writer.error?.localizedDescription ?? "unknown error")")
+                        assetWriter = nil
+                        return
+                    }
+                }
+                writer.startSession(atSourceTime: startTime)
+                hasStartedSession = true
+            }
+            
+            // Dropped rather than queued when the encoder falls behind
+            guard input.isReadyForMoreMediaData else { return }
+            if input.append(sampleBuffer) {
+                frameCount += 1
             }
         }
         
-        return context.makeImage() ?? cgImage
+        func stream(_ stream: SCStream, didStopWithError error: Error) {
+            print("❌ Screen Recorder: Stream of display \(display.displayID) stopped: \(error.localizedDescription)")
+            sampleQueue.async {
+                if self.stream === stream {
+                    self.stream = nil
+                }
+            }
+        }
     }
 }
 
@@ -2361,6 +2481,8 @@ enum ScreenRecorderError: Error, LocalizedError {
     case notRecording
     case invalidOutputURL
     case cannotAddInput
+    case noDisplay
+    case noFramesCaptured
     
     var errorDescription: String? {
         switch self {
@@ -2372,6 +2494,10 @@ enum ScreenRecorderError: Error, LocalizedError {
             return "Invalid output URL"
         case .cannotAddInput:
             return "Cannot add video input"
+        case .noDisplay:
+            return "No display available for capture"
+        case .noFramesCaptured:
+            return "No frames were captured"
         }
     }
 }
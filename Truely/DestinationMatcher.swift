@@ -0,0 +1,189 @@
+import Foundation
+import Darwin
+
+// Classification rules for network destinations, compiled once so a lookup
+// costs O(labels in the host name) or O(log ranges) however many rules exist.
+// Domain rules match the domain itself and any subdomain; address rules are
+// CIDR ranges (IPv4 or IPv6).
+final class DestinationMatcher {
+    enum Category: Int, Comparable {
+        case suspicious = 1     // AI/ML related service
+        case definitive = 2     // Known LLM API endpoint
+        
+        static func < (lhs: Category, rhs: Category) -> Bool {
+            lhs.rawValue < rhs.rawValue
+        }
+    }
+    
+    struct Match {
+        let category: Category
+        let rule: String        // the domain or CIDR that matched
+    }
+    
+    // MARK: - Domain Trie
+    
+    // Labels are stored right to left ("api.openai.com" -> com, openai, api)
+    private struct TrieNode {
+        var children: [Substring: Int] = [:]
+        var match: Match?
+    }
+    
+    private var nodes: [TrieNode] = [TrieNode()]
+    
+    // MARK: - Address Ranges
+    
+    // 128-bit address; IPv4 is stored IPv4-mapped (::ffff:a.b.c.d)
+    private struct Address: Comparable {
+        let high: UInt64
+        let low: UInt64
+        
+        static func < (lhs: Address, rhs: Address) -> Bool {
+            lhs.high != rhs.high ? lhs.high < rhs.high : lhs.low < rhs.low
+        }
+    }
+    
+    private struct AddressRange {
+        let start: Address
+        let end: Address
+        let match: Match
+    }
+    
+    private var ranges: [AddressRange] = []     // sorted by start
+    private var rangeMaxEnd: [Address] = []     // running max of end, for overlap scans
+    
+    init(domains: [(String, Category)] = [], ranges cidrs: [(String, Category)] = []) {
+        for (domain, category) in domains {
+            insertDomain(domain, category: category)
+        }
+        
+        for (cidr, category) in cidrs {
+            if let range = Self.parseCIDR(cidr, match: Match(category: category, rule: cidr)) {
+                ranges.append(range)
+            } else {
+                print("🌐 Ignoring invalid address rule: \(cidr)")
+            }
+        }
+        ranges.sort { $0.start < $1.start }
+        
+        var maxEnd = Address(high: 0, low: 0)
+        rangeMaxEnd = ranges.map { range in
+            maxEnd = max(maxEnd, range.end)
+            return maxEnd
+        }
+    }
+    
+    var ruleCount: Int {
+        nodes.filter { $0.match != nil }.count + ranges.count
+    }
+    
+    // Longest matching domain suffix wins (api.openai.com over openai.com)
+    func match(host: String) -> Match? {
+        let lowerHost = host.lowercased()
+        var trimmed = Substring(lowerHost)
+        if trimmed.hasSuffix(".") {
+            trimmed = trimmed.dropLast()
+        }
+        
+        var node = 0
+        var best: Match?
+        for label in trimmed.split(separator: ".", omittingEmptySubsequences: false).reversed() {
+            guard let next = nodes[node].children[label] else { break }
+            node = next
+            if let match = nodes[node].match {
+                best = match
+            }
+        }
+        return best
+    }
+    
+    // Narrowest matching range wins
+    func match(ip: String) -> Match? {
+        guard !ranges.isEmpty, let address = Self.parseAddress(ip) else { return nil }
+        
+        // Last range starting at or before the address
+        var low = 0
+        var high = ranges.count
+        while low < high {
+            let middle = (low + high) / 2
+            if ranges[middle].start <= address {
+                low = middle + 1
+            } else {
+                high = middle
+            }
+        }
+        
+        var best: AddressRange?
+        var index = low - 1
+        while index >= 0 && rangeMaxEnd[index] >= address {
+            let range = ranges[index]
+            if range.end >= address && (best == nil || range.start > best!.start) {
+                best = range
+            }
+            index -= 1
+        }
+        return best?.match
+    }
+    
+    // MARK: - Building
+    
+    private func insertDomain(_ domain: String, category: Category) {
+        let lowerDomain = domain.lowercased().trimmingCharacters(in: CharacterSet(charactersIn: ". "))
+        guard !lowerDomain.isEmpty else { return }
+        
+        var node = 0
+        for label in lowerDomain.split(separator: ".").reversed() {
+            if let next = nodes[node].children[label] {
+                node = next
+            } else {
+                nodes.append(TrieNode())
+                nodes[node].children[label] = nodes.count - 1
+                node = nodes.count - 1
+            }
+        }
+        
+        // The stronger category wins when a domain is listed twice
+        if let existing = nodes[node].match, existing.category >= category {
+            return
+        }
+        nodes[node].match = Match(category: category, rule: lowerDomain)
+    }
+    
+    private static func parseAddress(_ string: String) -> Address? {
+        var address4 = in_addr()
+        if inet_pton(AF_INET, string, &address4) == 1 {
+            return Address(high: 0, low: 0x0000_ffff_0000_0000 | UInt64(UInt32(bigEndian: address4.s_addr)))
+        }
+        
+        var address6 = in6_addr()
+        if inet_pton(AF_INET6, string, &address6) == 1 {
+            return withUnsafeBytes(of: &address6) { bytes in
+                var high: UInt64 = 0
+                var low: UInt64 = 0
+                for i in 0..<8 {
+                    high = high << 8 | UInt64(bytes[i])
+                    low = low << 8 | UInt64(bytes[i + 8])
+                }
+                return Address(high: high, low: low)
+            }
+        }
+        return nil
+    }
+    
+    private static func parseCIDR(_ cidr: String, match: Match) -> AddressRange? {
+        let parts = cidr.split(separator: "/", maxSplits: 1)
+        guard let first = parts.first, let base = parseAddress(String(first)) else { return nil }
+        
+        let isIPv4 = !first.contains(":")
+        let maxPrefix = isIPv4 ? 32 : 128
+        guard let prefix = parts.count == 2 ? Int(parts[1]) : maxPrefix, prefix >= 0, prefix <= maxPrefix else { return nil }
+        
+        // Host bits below the prefix, counted in the 128-bit space
+        let hostBits = maxPrefix - prefix
+        let highMask: UInt64 = hostBits > 64 ? (hostBits >= 128 ? UInt64.max : (1 << UInt64(hostBits - 64)) - 1) : 0
+        let lowMask: UInt64 = hostBits >= 64 ? UInt64.max : (1 << UInt64(hostBits)) - 1
+        
+        let start = Address(high: base.high & ~highMask, low: base.low & ~lowMask)
+        let end = Address(high: base.high | highMask, low: base.low | lowMask)
+        return AddressRange(start: start, end: end, match: match)
+    }
+}
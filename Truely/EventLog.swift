@@ -0,0 +1,137 @@
+import Foundation
+
+// Append-only NDJSON log of monitoring events. Each record is one compact
+// JSON line, written once when the event is first seen; uploads read the
+// bytes past the last acknowledged offset and send them as an LZFSE chunk,
+// so what goes up per tick depends on what happened, not on session length.
+// The acknowledged offset is kept next to the log, so a reopened log (after
+// a crash, or from the upload queue) resumes where the server left off.
+final class EventLog {
+    struct Chunk {
+        let startOffset: UInt64
+        let endOffset: UInt64
+        let recordCount: Int
+        let data: Data                  // LZFSE-compressed NDJSON
+    }
+    
+    let url: URL
+    private let offsetURL: URL
+    private let queue = DispatchQueue(label: "com.truely.eventlog")
+    private let encoder = JSONEncoder()
+    private let newline = Data([0x0A])
+    private let maxChunkBytes: Int
+    
+    // Only touched on queue
+    private var fileHandle: FileHandle?
+    private var endOffset: UInt64 = 0
+    private var acknowledgedOffset: UInt64 = 0
+    private var chunkInFlight = false
+    
+    init?(url: URL, maxChunkBytes: Int = 256 * 1024) {
+        self.url = url
+        self.offsetURL = url.appendingPathExtension("offset")
+        self.maxChunkBytes = max(maxChunkBytes, 4096)
+        
+        do {
+            try FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+            if !FileManager.default.fileExists(atPath: url.path) {
+                FileManager.default.createFile(atPath: url.path, contents: nil)
+            }
+            let handle = try FileHandle(forUpdating: url)
+            endOffset = handle.seekToEndOfFile()
+            fileHandle = handle
+            
+            if let saved = try? String(contentsOf: offsetURL, encoding: .utf8),
+               let offset = UInt64(saved.trimmingCharacters(in: .whitespacesAndNewlines)) {
+                acknowledgedOffset = min(offset, endOffset)
+            }
+        } catch {
+            print("📤 EventLog: Failed to open \(url.lastPathComponent): \(error)")
+            return nil
+        }
+    }
+    
+    deinit {
+        try? fileHandle?.close()
+    }
+    
+    func append<Record: Encodable>(_ records: [Record]) {
+        guard !records.isEmpty else { return }
+        
+        queue.sync {
+            guard let handle = fileHandle else { return }
+            var lines = Data()
+            for record in records {
+                guard let line = try? encoder.encode(record) else { continue }
+                lines.append(line)
+                lines.append(newline)
+            }
+            
+            handle.seekToEndOfFile()
+            handle.write(lines)
+            endOffset += UInt64(lines.count)
+        }
+    }
+    
+    // Unacknowledged bytes as one compressed chunk, cut at a record boundary.
+    // Only one chunk is out at a time; finish(_:uploaded:) releases it.
+    func nextChunk() -> Chunk? {
+        queue.sync {
+            guard !chunkInFlight, endOffset > acknowledgedOffset, let handle = fileHandle else { return nil }
+            
+            handle.seek(toFileOffset: acknowledgedOffset)
+            let available = Int(min(endOffset - acknowledgedOffset, UInt64(maxChunkBytes)))
+            var bytes = handle.readData(ofLength: available)
+            handle.seekToEndOfFile()
+            
+            // A record longer than the chunk limit still goes out whole, on its
+            // own: read on from the cut up to its newline and no further
+            let pending = endOffset - acknowledgedOffset
+            if let lastNewline = bytes.lastIndex(of: 0x0A) {
+                bytes = bytes.prefix(through: lastNewline)
+            } else if UInt64(available) < pending {
+                handle.seek(toFileOffset: acknowledgedOffset + UInt64(available))
+                while UInt64(bytes.count) < pending {
+                    let block = handle.readData(ofLength: Int(min(pending - UInt64(bytes.count), UInt64(maxChunkBytes))))
+                    guard !block.isEmpty else { break }
+                    if let newline = block.firstIndex(of: 0x0A) {
+                        bytes.append(block.prefix(through: newline))
+                        break
+                    }
+                    bytes.append(block)
+                }
+                handle.seekToEndOfFile()
+            }
+            guard !bytes.isEmpty, let compressed = try? (bytes as NSData).compressed(using: .lzfse) else { return nil }
+            
+            chunkInFlight = true
+            return Chunk(
+                startOffset: acknowledgedOffset,
+                endOffset: acknowledgedOffset + UInt64(bytes.count),
+                recordCount: bytes.reduce(0) { $0 + ($1 == 0x0A ? 1 : 0) },
+                data: compressed as Data
+            )
+        }
+    }
+    
+    func finish(_ chunk: Chunk, uploaded: Bool) {
+        queue.sync {
+            chunkInFlight = false
+            if uploaded, chunk.startOffset == acknowledgedOffset {
+                acknowledgedOffset = chunk.endOffset
+                try? String(acknowledgedOffset).write(to: offsetURL, atomically: true, encoding: .utf8)
+            }
+        }
+    }
+    
+    var hasPendingBytes: Bool {
+        queue.sync { endOffset > acknowledgedOffset }
+    }
+    
+    func close() {
+        queue.sync {
+            try? fileHandle?.close()
+            fileHandle = nil
+        }
+    }
+}
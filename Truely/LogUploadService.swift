@@ -3,7 +3,7 @@ import Combine
 
 class LogUploadService: ObservableObject {
     private let baseURL = "https://api.true-ly.com"
-    private var uploadTimer: Timer?
+    private let scheduler = MonitoringScheduler.shared
     private var isActive = false
     private var organization: String = "default"
     private var sessionId: String = ""
@@ -18,6 +18,37 @@ class LogUploadService: ObservableObject {
     private var suspiciousDetector: SuspiciousProcessDetector?
     private var sessionFolderName: String?
     
+    // Session event log: detections are appended once and uploads send only
+    // the bytes after the last acknowledged offset
+    private static let timestampFormatter = ISO8601DateFormatter()
+    // The open log and its bookkeeping are used from main (start/stop), the
+    // scheduler's tick and the upload queue, so they are only touched under eventLock
+    private let eventLock = NSLock()
+    private var eventLog: EventLog?
+    private var loggedEventKeys = Set<String>()
+    private var loggedScores: [pid_t: Int] = [:]
+    
+    // Every upload (log chunks, screenshots, video fragments) goes through one
+    // persistent queue, paced to the link quality NetworkMonitor reports
+    private lazy var uploadQueue: UploadQueue = {
+        let manifestURL = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first?
+            .appendingPathComponent("Truely", isDirectory: true)
+            .appendingPathComponent("upload-queue.json")
+        return UploadQueue(
+            manifestURL: manifestURL,
+            bytesPerSecond: { [weak self] in
+                (self?.networkMonitor?.linkQuality ?? .wifi).uploadBytesPerSecond
+            },
+            performer: { [weak self] job, completion in
+                guard let self = self else {
+                    completion(false, "Upload service released")
+                    return
+                }
+                self.performUpload(job, completion: completion)
+            }
+        )
+    }()
+    
     // Published properties for UI updates
     @Published var lastUploadTime: Date?
     @Published var uploadStatus: UploadStatus = .idle
@@ -56,89 +87,182 @@ class LogUploadService: ObservableObject {
         
         print("📤 Log upload service started - uploading every 60 seconds")
         
-        // Upload immediately on start
-        uploadLogs()
+        // Pending uploads from a previous run start going out right away
+        networkMonitor?.onLinkQualityChange = { [weak self] _ in
+            self?.uploadQueue.resume()
+        }
+        networkMonitor?.startLinkMonitoring()
+        uploadQueue.resume()
         
-        // Set up timer for every 60 seconds
-        uploadTimer = Timer.scheduledTimer(withTimeInterval: 60.0, repeats: true) { _ in
-            DispatchQueue.global(qos: .utility).async {
-                self.uploadLogs()
-            }
+        openEventLog()
+        
+        // Upload immediately on start, then every 60 seconds on the shared
+        // scheduler (fixed cadence, staggered against the detection scans)
+        uploadLogs()
+        scheduler.register("upload", interval: 60.0, initialDelay: 60.0, expensive: true, adaptive: false) { _ in
+            self.uploadLogs()
         }
     }
     
     func stopUploadService() {
         isActive = false
-        uploadTimer?.invalidate()
-        uploadTimer = nil
+        scheduler.unregister("upload")
+        
+        // Queue whatever was logged since the last tick; the queued job reopens
+        // the log by path, so it can be closed now
+        eventLock.lock()
+        let openLog = eventLog
+        eventLog = nil
+        eventLock.unlock()
+        
+        if let log = openLog {
+            appendNewEvents(to: log)
+            enqueueLogUpload(log, folderName: sessionFolderName)
+            log.close()
+        }
         print("📤 Log upload service stopped")
     }
     
     private func uploadLogs() {
-        guard isActive else { return }
+        guard isActive, let log = currentEventLog() else { return }
         
-        DispatchQueue.main.async {
-            self.uploadStatus = .uploading
+        appendNewEvents(to: log)
+        enqueueLogUpload(log, folderName: sessionFolderName)
+    }
+    
+    // MARK: - Event Log
+    
+    private func openEventLog() {
+        guard let supportDirectory = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first else {
+            print("📤 Event log unavailable: no Application Support directory")
+            return
         }
         
-        // Collect current log data
-        let logData = collectLogData()
+        let logName = (sessionId.isEmpty ? "session_\(Int(sessionStartTime.timeIntervalSince1970))" : sessionId)
+            .replacingOccurrences(of: "/", with: "_")
+        let url = supportDirectory
+            .appendingPathComponent("Truely", isDirectory: true)
+            .appendingPathComponent("EventLogs", isDirectory: true)
+            .appendingPathComponent("\(logName).ndjson")
         
-        // Create JSON file
-        guard let jsonData = createJSONFile(logData: logData) else {
-            DispatchQueue.main.async {
-                self.uploadStatus = .failed
-                self.lastUploadError = "Failed to create JSON data"
+        eventLock.lock()
+        loggedEventKeys.removeAll()
+        loggedScores.removeAll()
+        eventLock.unlock()
+        
+        guard let log = EventLog(url: url) else { return }
+        eventLock.lock()
+        eventLog = log
+        eventLock.unlock()
+        
+        let sessionInfo = SessionInfo(
+            sessionId: sessionId,
+            meetingLink: meetingLink,
+            platform: platform,
+            startTime: Self.timestampFormatter.string(from: sessionStartTime),
+            monitoringActive: processMonitor?.isMonitoringActive ?? false
+        )
+        log.append([LogEventRecord(kind: .session, timestampMs: Self.epochMilliseconds(), session: sessionInfo)])
+        print("📤 Event log: \(url.path)")
+    }
+    
+    private func currentEventLog() -> EventLog? {
+        eventLock.lock()
+        defer { eventLock.unlock() }
+        return eventLog
+    }
+    
+    // Writes detections not yet in the log; scores are re-logged only when they
+    // change. Every tick also logs the scan cost since the previous one.
+    private func appendNewEvents(to log: EventLog) {
+        let now = Self.epochMilliseconds()
+        let networkConnections = collectNetworkConnections()
+        let suspicionScores = collectSuspicionScores()
+        let forbiddenApps = processMonitor?.detectedForbiddenApps ?? []
+        var records: [LogEventRecord] = []
+        
+        eventLock.lock()
+        for connection in networkConnections {
+            let key = "net|\(connection.pid)|\(connection.destinationDomain)|\(connection.destinationPort)|\(connection.connectionProtocol)|\(connection.confidence)"
+            if loggedEventKeys.insert(key).inserted {
+                records.append(LogEventRecord(kind: .networkConnection, timestampMs: now, networkConnection: connection))
+            }
+        }
+        
+        for score in suspicionScores {
+            if loggedScores[score.pid] != score.score {
+                loggedScores[score.pid] = score.score
+                records.append(LogEventRecord(kind: .suspicionScore, timestampMs: now, suspicionScore: score))
             }
+        }
+        
+        for app in forbiddenApps where loggedEventKeys.insert("app|\(app)").inserted {
+            records.append(LogEventRecord(kind: .forbiddenApp, timestampMs: now, forbiddenApp: app))
+        }
+        eventLock.unlock()
+        
+        records.append(LogEventRecord(kind: .scanMetrics, timestampMs: now, scanMetrics: ScanTelemetry.shared.takeMetrics()))
+        
+        log.append(records)
+    }
+    
+    // One pending log job per log file: a queued job sends everything past the
+    // acknowledged offset when it runs, so later ticks coalesce into it
+    private func enqueueLogUpload(_ log: EventLog, folderName: String?) {
+        guard log.hasPendingBytes else { return }
+        uploadQueue.enqueue(
+            .log,
+            filePath: log.url.path,
+            folderName: folderName ?? "",
+            fileName: log.url.lastPathComponent,
+            coalesceKey: "log|\(log.url.path)"
+        )
+    }
+    
+    private func uploadEventLogChunk(_ job: UploadQueue.Job, completion: @escaping (Bool, String?) -> Void) {
+        let openLog = currentEventLog().flatMap { $0.url.path == job.filePath ? $0 : nil }
+        guard let log = openLog ?? EventLog(url: URL(fileURLWithPath: job.filePath)) else {
+            completion(false, "Event log unavailable: \(job.fileName)")
+            return
+        }
+        guard let chunk = log.nextChunk() else {
+            // Nothing past the acknowledged offset
+            completion(true, nil)
             return
         }
         
-        // Mock upload to S3 (API calls removed)
-        uploadToS3Mock(jsonData: jsonData, folderName: sessionFolderName) { success, error in
+        DispatchQueue.main.async {
+            self.uploadStatus = .uploading
+        }
+        
+        let fileName = String(format: "events_%012llu.ndjson.lzfse", chunk.startOffset)
+        uploadToS3Mock(jsonData: chunk.data, folderName: job.folderName.isEmpty ? nil : job.folderName, fileName: fileName) { success, error in
+            log.finish(chunk, uploaded: success)
+            
             DispatchQueue.main.async {
                 if success {
                     self.uploadStatus = .success
                     self.lastUploadTime = Date()
                     self.lastUploadError = nil
-                    print("📤 Logs uploaded successfully (mock)")
+                    print("📤 Logs uploaded successfully (mock): \(chunk.recordCount) events, \(chunk.endOffset - chunk.startOffset) bytes as \(chunk.data.count)")
                 } else {
                     self.uploadStatus = .failed
                     self.lastUploadError = error ?? "Unknown upload error"
                     print("📤 Log upload failed: \(error ?? "Unknown error")")
                 }
             }
+            
+            completion(success, error)
+            
+            // A backlog larger than one chunk goes out as the next log job
+            if success && log.hasPendingBytes {
+                self.enqueueLogUpload(log, folderName: job.folderName)
+            }
         }
     }
     
-    private func collectLogData() -> LogUploadRequest {
-        let timestamp = ISO8601DateFormatter().string(from: Date())
-        
-        // Collect network connections
-        let networkConnections = collectNetworkConnections()
-        
-        // Collect suspicion scores
-        let suspicionScores = collectSuspicionScores()
-        
-        // Collect forbidden apps
-        let forbiddenApps = processMonitor?.detectedForbiddenApps ?? []
-        
-        // Create session info
-        let sessionInfo = SessionInfo(
-            sessionId: sessionId,
-            meetingLink: meetingLink,
-            platform: platform,
-            startTime: ISO8601DateFormatter().string(from: sessionStartTime),
-            monitoringActive: processMonitor?.isMonitoringActive ?? false
-        )
-        
-        return LogUploadRequest(
-            timestamp: timestamp,
-            organization: organization,
-            networkConnections: networkConnections,
-            suspicionScores: suspicionScores,
-            forbiddenApps: forbiddenApps,
-            sessionInfo: sessionInfo
-        )
+    private static func epochMilliseconds(_ date: Date = Date()) -> Int64 {
+        Int64((date.timeIntervalSince1970 * 1000).rounded())
     }
     
     private func collectNetworkConnections() -> [NetworkConnectionLog] {
@@ -152,7 +276,7 @@ class LogUploadService: ObservableObject {
                 destinationPort: detection.destinationPort,
                 connectionProtocol: detection.connectionProtocol,
                 confidence: detection.confidence.description,
-                timestamp: ISO8601DateFormatter().string(from: detection.timestamp)
+                timestamp: Self.timestampFormatter.string(from: detection.timestamp)
             )
         }
     }
@@ -160,79 +284,59 @@ class LogUploadService: ObservableObject {
     private func collectSuspicionScores() -> [SuspicionScoreLog] {
         guard let suspiciousDetector = suspiciousDetector else { return [] }
         
-        // Get advanced detection results and calculate scores
-        let advancedResults = suspiciousDetector.advancedDetectionResults
-        
-        // Group results by process to calculate total scores
-        var processScores: [String: (Int, [String], [String])] = [:] // [processName: (score, detectionTypes, evidence)]
-        
-        for result in advancedResults {
-            let processKey = "\(result.processName)_\(result.pid)"
-            
-            if let existing = processScores[processKey] {
-                let newScore = existing.0 + result.evidence.count * 2
-                let newTypes = existing.1 + [result.type.description]
-                let newEvidence = existing.2 + result.evidence
-                processScores[processKey] = (newScore, newTypes, newEvidence)
-            } else {
-                let score = result.evidence.count * 2
-                let types = [result.type.description]
-                processScores[processKey] = (score, types, result.evidence)
-            }
-        }
-        
-        // Convert to SuspicionScoreLog objects
-        return processScores.map { (processKey, data) in
-            let components = processKey.components(separatedBy: "_")
-            let processName = components.dropLast().joined(separator: "_")
-            let pid = Int32(components.last ?? "0") ?? 0
-            
-            return SuspicionScoreLog(
-                processName: processName,
-                pid: pid,
-                score: data.0,
-                detectionTypes: Array(Set(data.1)), // Remove duplicates
-                evidence: data.2
+        // Already ranked and decayed by the detector's score engine
+        return suspiciousDetector.topSuspicionScores().map { ranked in
+            SuspicionScoreLog(
+                processName: ranked.processName,
+                pid: ranked.pid,
+                score: ranked.score,
+                detectionTypes: ranked.detectionTypes,
+                evidence: ranked.evidence
             )
-        }.sorted { $0.score > $1.score } // Sort by score descending
-    }
-    
-    private func createJSONFile(logData: LogUploadRequest) -> Data? {
-        do {
-            let encoder = JSONEncoder()
-            encoder.outputFormatting = .prettyPrinted
-            return try encoder.encode(logData)
-        } catch {
-            print("📤 Error encoding log data: \(error)")
-            return nil
         }
     }
     
     // MARK: - Mock Upload Methods (API calls removed)
     
-    private func uploadToS3Mock(jsonData: Data, folderName: String? = nil, completion: @escaping (Bool, String?) -> Void) {
+    private func uploadToS3Mock(jsonData: Data, folderName: String? = nil, fileName: String, completion: @escaping (Bool, String?) -> Void) {
         let finalFolderName: String
         if let folderName = folderName {
             finalFolderName = folderName
         } else {
-            let timestamp = ISO8601DateFormatter().string(from: Date())
+            let timestamp = Self.timestampFormatter.string(from: sessionStartTime)
             finalFolderName = "\(timestamp)_\(organization)"
         }
         
-        print("📤 LogUploadService: Mock - Uploading JSON data to S3")
+        print("📤 LogUploadService: Mock - Uploading log data to S3")
         print("📤 LogUploadService: Mock - Folder name: \(finalFolderName)")
+        print("📤 LogUploadService: Mock - File name: \(fileName)")
         print("📤 LogUploadService: Mock - Data size: \(jsonData.count) bytes")
         
-        // Simulate network delay
-        DispatchQueue.main.asyncAfter(deadline: .now() + 1.0) {
-            print("📤 LogUploadService: Mock - Upload completed successfully")
+        uploadQueue.sendPaced(jsonData, slice: Self.sendSliceMock) { success, error in
+            DispatchQueue.main.async {
+                if success {
+                    print("📤 LogUploadService: Mock - Upload completed successfully")
+                }
+                completion(success, error)
+            }
+        }
+    }
+    
+    // Stands in for one part of a multipart upload
+    private static func sendSliceMock(_ slice: Data, completion: @escaping (Bool, String?) -> Void) {
+        // Simulate network latency
+        DispatchQueue.global(qos: .utility).asyncAfter(deadline: .now() + 0.05) {
             completion(true, nil)
         }
     }
     
     // MARK: - Screenshot Upload Methods (Mock)
     
-    func uploadScreenshot(filePath: String, folderName: String, fileName: String, completion: @escaping (Bool, String?) -> Void) {
+    func uploadScreenshot(filePath: String, folderName: String, fileName: String, completion: ((Bool, String?) -> Void)? = nil) {
+        uploadQueue.enqueue(.screenshot, filePath: filePath, folderName: folderName, fileName: fileName, completion: completion)
+    }
+    
+    private func transferScreenshot(filePath: String, folderName: String, fileName: String, completion: @escaping (Bool, String?) -> Void) {
         print("📸 LogUploadService: Mock - Starting screenshot upload")
         print("📸 LogUploadService: Mock - File path: \(filePath)")
         print("📸 LogUploadService: Mock - Folder name: \(folderName)")
@@ -252,16 +356,22 @@ class LogUploadService: ObservableObject {
         
         print("📸 LogUploadService: Mock - Image data size: \(imageData.count) bytes")
         
-        // Simulate network delay
-        DispatchQueue.main.asyncAfter(deadline: .now() + 1.0) {
-            print("✅ LogUploadService: Mock - Screenshot upload completed successfully")
-            completion(true, nil)
+        uploadQueue.sendPaced(imageData, slice: Self.sendSliceMock) { success, error in
+            if success {
+                print("✅ LogUploadService: Mock - Screenshot upload completed successfully")
+            }
+            completion(success, error)
         }
     }
     
     // MARK: - Video Upload Methods (Mock)
     
-    func uploadVideo(filePath: String, folderName: String, fileName: String, completion: @escaping (Bool, String?) -> Void) {
+    // Video fragments are queued as they close and go up in order behind logs and screenshots
+    func uploadVideo(filePath: String, folderName: String, fileName: String, completion: ((Bool, String?) -> Void)? = nil) {
+        uploadQueue.enqueue(.video, filePath: filePath, folderName: folderName, fileName: fileName, completion: completion)
+    }
+    
+    private func transferVideo(filePath: String, folderName: String, fileName: String, completion: @escaping (Bool, String?) -> Void) {
         print("🎥 LogUploadService: Mock - Starting video upload")
         print("🎥 LogUploadService: Mock - File path: \(filePath)")
         print("🎥 LogUploadService: Mock - Folder name: \(folderName)")
@@ -281,10 +391,24 @@ class LogUploadService: ObservableObject {
         
         print("🎥 LogUploadService: Mock - Video data size: \(videoData.count) bytes")
         
-        // Simulate network delay
-        DispatchQueue.main.asyncAfter(deadline: .now() + 2.0) {
-            print("✅ LogUploadService: Mock - Video upload completed successfully")
-            completion(true, nil)
+        uploadQueue.sendPaced(videoData, slice: Self.sendSliceMock) { success, error in
+            if success {
+                print("✅ LogUploadService: Mock - Video upload completed successfully")
+            }
+            completion(success, error)
+        }
+    }
+    
+    // MARK: - Upload Queue
+    
+    private func performUpload(_ job: UploadQueue.Job, completion: @escaping (Bool, String?) -> Void) {
+        switch job.kind {
+        case .log:
+            uploadEventLogChunk(job, completion: completion)
+        case .screenshot:
+            transferScreenshot(filePath: job.filePath, folderName: job.folderName, fileName: job.fileName, completion: completion)
+        case .video:
+            transferVideo(filePath: job.filePath, folderName: job.folderName, fileName: job.fileName, completion: completion)
         }
     }
     
@@ -297,39 +421,10 @@ class LogUploadService: ObservableObject {
     }
     
     private func uploadLogsWithSession(folderName: String) {
-        guard isActive else { return }
-        
-        DispatchQueue.main.async {
-            self.uploadStatus = .uploading
-        }
-        
-        // Collect current log data
-        let logData = collectLogData()
+        guard isActive, let log = currentEventLog() else { return }
         
-        // Create JSON file
-        guard let jsonData = createJSONFile(logData: logData) else {
-            DispatchQueue.main.async {
-                self.uploadStatus = .failed
-                self.lastUploadError = "Failed to create JSON data"
-            }
-            return
-        }
-        
-        // Mock upload to S3 via API with session folder name
-        uploadToS3Mock(jsonData: jsonData, folderName: folderName) { success, error in
-            DispatchQueue.main.async {
-                if success {
-                    self.uploadStatus = .success
-                    self.lastUploadTime = Date()
-                    self.lastUploadError = nil
-                    print("📤 Logs uploaded successfully to session folder: \(folderName) (mock)")
-                } else {
-                    self.uploadStatus = .failed
-                    self.lastUploadError = error ?? "Unknown upload error"
-                    print("📤 Log upload failed: \(error ?? "Unknown error")")
-                }
-            }
-        }
+        appendNewEvents(to: log)
+        enqueueLogUpload(log, folderName: folderName)
     }
     
     func getUploadStatus() -> String {
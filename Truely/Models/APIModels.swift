@@ -233,6 +233,35 @@ struct SessionInfo: Codable {
     }
 }
 
+// One line of the NDJSON event log; only the payload for `kind` is present
+struct LogEventRecord: Codable {
+    enum Kind: String, Codable {
+        case session
+        case networkConnection = "network_connection"
+        case suspicionScore = "suspicion_score"
+        case forbiddenApp = "forbidden_app"
+        case scanMetrics = "scan_metrics"
+    }
+    
+    let kind: Kind
+    let timestampMs: Int64
+    var session: SessionInfo? = nil
+    var networkConnection: NetworkConnectionLog? = nil
+    var suspicionScore: SuspicionScoreLog? = nil
+    var forbiddenApp: String? = nil
+    var scanMetrics: ScanMetrics? = nil
+    
+    enum CodingKeys: String, CodingKey {
+        case kind
+        case timestampMs = "ts"
+        case session
+        case networkConnection = "network_connection"
+        case suspicionScore = "suspicion_score"
+        case forbiddenApp = "forbidden_app"
+        case scanMetrics = "scan_metrics"
+    }
+}
+
 struct LogUploadResponse: Codable {
     let message: String
     let statusCode: Int?
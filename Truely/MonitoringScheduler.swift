@@ -0,0 +1,206 @@
+import Foundation
+import CoreGraphics
+import IOKit.ps
+
+// One clock for every periodic monitoring job. Each tick takes at most one
+// process snapshot and hands it to every phase that is due, expensive phases
+// are staggered so no two start on the same tick, and intervals stretch on
+// battery or when the user is idle and shrink for a while after a detection.
+final class MonitoringScheduler {
+    // Shared by ProcessMonitor, NetworkMonitor and LogUploadService
+    static let shared = MonitoringScheduler()
+    
+    typealias PhaseHandler = (ScanSnapshot?) -> Void
+    
+    private final class Phase {
+        let name: String
+        let interval: TimeInterval
+        let isExpensive: Bool     // runs off the scheduler queue, never two at once
+        let needsSnapshot: Bool
+        let isAdaptive: Bool      // interval follows power/idle/detection state
+        let handler: PhaseHandler
+        var nextDue: Date
+        var isRunning = false
+        
+        init(name: String, interval: TimeInterval, initialDelay: TimeInterval, isExpensive: Bool, needsSnapshot: Bool, isAdaptive: Bool, handler: @escaping PhaseHandler) {
+            self.name = name
+            self.interval = interval
+            self.isExpensive = isExpensive
+            self.needsSnapshot = needsSnapshot
+            self.isAdaptive = isAdaptive
+            self.handler = handler
+            self.nextDue = Date().addingTimeInterval(initialDelay)
+        }
+    }
+    
+    private let queue = DispatchQueue(label: "com.truely.scheduler", qos: .userInitiated)
+    private let expensiveQueue = DispatchQueue(label: "com.truely.scheduler.expensive", qos: .utility)
+    private var phases: [String: Phase] = [:]
+    private var timer: DispatchSourceTimer?
+    
+    // Adaptive interval state
+    private var boostUntil = Date.distantPast
+    private let boostDuration: TimeInterval = 60
+    private let boostFactor = 0.5
+    private let batteryFactor = 2.0
+    private let idleFactor = 2.0
+    private let idleThreshold: TimeInterval = 300
+    private let minimumSpacing: TimeInterval = 1.0   // between two expensive phase starts
+    private var lastExpensiveStart = Date.distantPast
+    
+    // MARK: - Registration
+    
+    func register(_ name: String, interval: TimeInterval, initialDelay: TimeInterval = 0, expensive: Bool = false, needsSnapshot: Bool = false, adaptive: Bool = true, handler: @escaping PhaseHandler) {
+        let phase = Phase(name: name, interval: interval, initialDelay: initialDelay, isExpensive: expensive, needsSnapshot: needsSnapshot, isAdaptive: adaptive, handler: handler)
+        queue.async {
+            self.phases[name] = phase
+            print("⏱️ Scheduler: \(name) every \(Int(interval))s\(expensive ? " (staggered)" : "")")
+            self.rescheduleLocked()
+        }
+    }
+    
+    // completion runs once the phase can no longer run: on the scheduler
+    // queue, or after an in-flight run on the expensive queue. Phase state
+    // owned by those queues can be reset there.
+    func unregister(_ name: String, completion: (() -> Void)? = nil) {
+        queue.async {
+            let phase = self.phases.removeValue(forKey: name)
+            self.rescheduleLocked()
+            
+            guard let completion = completion else { return }
+            if phase?.isExpensive == true {
+                self.expensiveQueue.async(execute: completion)
+            } else {
+                completion()
+            }
+        }
+    }
+    
+    // Runs a phase early (event-driven scans); repeated triggers coalesce
+    func trigger(_ name: String, after delay: TimeInterval = 0) {
+        queue.async {
+            guard let phase = self.phases[name] else { return }
+            let due = Date().addingTimeInterval(delay)
+            if due < phase.nextDue {
+                phase.nextDue = due
+                self.rescheduleLocked()
+            }
+        }
+    }
+    
+    // Tightens adaptive intervals for a while after something new was found.
+    // Callers report only when their detected set gains an entry, and a
+    // report during an active boost does not extend it.
+    func reportDetection() {
+        queue.async {
+            guard self.boostUntil <= Date() else { return }
+            self.boostUntil = Date().addingTimeInterval(self.boostDuration)
+            print("⏱️ Scheduler: detection reported - tightening intervals for \(Int(self.boostDuration))s")
+            for phase in self.phases.values where phase.isAdaptive {
+                phase.nextDue = min(phase.nextDue, Date().addingTimeInterval(phase.interval * self.boostFactor))
+            }
+            self.rescheduleLocked()
+        }
+    }
+    
+    // MARK: - Ticking
+    
+    private func rescheduleLocked() {
+        guard let nextDue = phases.values.filter({ !$0.isRunning }).map({ $0.nextDue }).min() else {
+            timer?.cancel()
+            timer = nil
+            return
+        }
+        
+        if timer == nil {
+            let source = DispatchSource.makeTimerSource(queue: queue)
+            source.setEventHandler { [weak self] in
+                self?.tick()
+            }
+            source.resume()
+            timer = source
+        }
+        
+        // Leeway lets the system coalesce our wakeups with others
+        let delay = max(nextDue.timeIntervalSinceNow, 0)
+        timer?.schedule(deadline: .now() + delay, leeway: .milliseconds(Int(max(delay * 100, 50))))
+    }
+    
+    private func tick() {
+        let now = Date()
+        let factor = currentIntervalFactor()
+        var due = phases.values.filter { !$0.isRunning && $0.nextDue <= now }
+        
+        // Stagger: at most one expensive phase starts per tick (the most overdue)
+        let expensive = due.filter { $0.isExpensive }.sorted { $0.nextDue < $1.nextDue }
+        if !expensive.isEmpty {
+            let canStartExpensive = now.timeIntervalSince(lastExpensiveStart) >= minimumSpacing &&
+                !phases.values.contains { $0.isExpensive && $0.isRunning }
+            let deferred = canStartExpensive ? Array(expensive.dropFirst()) : expensive
+            for phase in deferred {
+                phase.nextDue = now.addingTimeInterval(minimumSpacing)
+            }
+            due.removeAll { phase in deferred.contains { $0 === phase } }
+        }
+        
+        guard !due.isEmpty else {
+            rescheduleLocked()
+            return
+        }
+        
+        // One process table walk for everything due this tick
+        let snapshot = due.contains { $0.needsSnapshot } ? ScanSnapshot.capture() : nil
+        
+        for phase in due {
+            let interval = phase.isAdaptive ? phase.interval * factor : phase.interval
+            phase.nextDue = now.addingTimeInterval(interval)
+            
+            if phase.isExpensive {
+                phase.isRunning = true
+                lastExpensiveStart = now
+                expensiveQueue.async {
+                    phase.handler(snapshot)
+                    self.queue.async {
+                        phase.isRunning = false
+                        self.rescheduleLocked()
+                    }
+                }
+            } else {
+                phase.handler(snapshot)
+            }
+        }
+        
+        rescheduleLocked()
+    }
+    
+    // MARK: - Adaptive Intervals
+    
+    private func currentIntervalFactor() -> Double {
+        if boostUntil > Date() {
+            return boostFactor
+        }
+        
+        var factor = 1.0
+        if isOnBatteryPower() {
+            factor *= batteryFactor
+        }
+        if userIdleTime() >= idleThreshold {
+            factor *= idleFactor
+        }
+        return factor
+    }
+    
+    private func isOnBatteryPower() -> Bool {
+        guard let info = IOPSCopyPowerSourcesInfo()?.takeRetainedValue(),
+              let source = IOPSGetProvidingPowerSourceType(info)?.takeUnretainedValue() else {
+            return false
+        }
+        return (source as String) == kIOPSBatteryPowerValue
+    }
+    
+    private func userIdleTime() -> TimeInterval {
+        // Seconds since the last keyboard/mouse event of any kind
+        let anyInput = CGEventType(rawValue: ~0) ?? .null
+        return CGEventSource.secondsSinceLastEventType(.combinedSessionState, eventType: anyInput)
+    }
+}
@@ -0,0 +1,73 @@
+import Foundation
+
+// Compiled substring rules (case-insensitive for ASCII) backed by the bridge's
+// Aho-Corasick automaton. A lookup walks the text once however many rules
+// there are. The automaton is immutable after init and the match buffer is
+// locked, so one matcher can be shared across queues.
+final class NameMatcher {
+    let patterns: [String]
+    private var automaton = PatternAutomaton()
+    
+    // Sized once for every rule matching, so allMatches allocates nothing
+    // unless something matched; only touched under matchLock
+    private let matchBuffer: UnsafeMutablePointer<Int32>
+    private let matchLock = NSLock()
+    
+    init(patterns: [String]) {
+        self.patterns = patterns
+        self.matchBuffer = .allocate(capacity: max(patterns.count, 1))
+        
+        let cStrings = patterns.map { strdup($0) }
+        defer { cStrings.forEach { free($0) } }
+        let pointers = cStrings.map { UnsafePointer<CChar>($0) }
+        
+        if buildPatternAutomaton(&automaton, pointers, Int32(pointers.count)) != 0 {
+            print("🔎 Failed to compile \(patterns.count) name rules")
+        }
+    }
+    
+    deinit {
+        freePatternAutomaton(&automaton)
+        matchBuffer.deallocate()
+    }
+    
+    var isEmpty: Bool {
+        automaton.stateCount <= 1
+    }
+    
+    // The first rule contained in text, if any
+    func firstMatch(in text: String) -> String? {
+        var text = text
+        return text.withUTF8 { firstMatch(in: $0) }
+    }
+    
+    func firstMatch(in bytes: UnsafeBufferPointer<UInt8>) -> String? {
+        guard !isEmpty else { return nil }
+        let index = findFirstPattern(&automaton, bytes.baseAddress, bytes.count)
+        return index >= 0 ? patterns[Int(index)] : nil
+    }
+    
+    func matches(_ text: String) -> Bool {
+        firstMatch(in: text) != nil
+    }
+    
+    func matches(_ bytes: UnsafeBufferPointer<UInt8>) -> Bool {
+        firstMatch(in: bytes) != nil
+    }
+    
+    // Indexes into patterns of every rule contained in text
+    func allMatches(in text: String) -> [Int] {
+        var text = text
+        return text.withUTF8 { allMatches(in: $0) }
+    }
+    
+    func allMatches(in bytes: UnsafeBufferPointer<UInt8>) -> [Int] {
+        guard !isEmpty else { return [] }
+        matchLock.lock()
+        defer { matchLock.unlock() }
+        
+        let count = Int(findAllPatterns(&automaton, bytes.baseAddress, bytes.count, matchBuffer, Int32(patterns.count)))
+        guard count > 0 else { return [] }
+        return (0..<count).map { Int(matchBuffer[$0]) }
+    }
+}
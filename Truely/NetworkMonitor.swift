@@ -10,6 +10,7 @@ struct NetworkDetectionResult: Equatable {
     let processPath: String
     let pid: pid_t
     let destinationDomain: String
+    let destinationAddress: String
     let destinationPort: Int
     let connectionProtocol: String
     let confidence: DetectionConfidence
@@ -35,9 +36,43 @@ class NetworkMonitor: ObservableObject {
     @Published var networkDetections: [NetworkDetectionResult] = []
     
     private var isActive = false
-    private var networkMonitoringTimer: Timer?
+    private weak var scheduler: MonitoringScheduler?
     private var lastDetectionLog = Date()
     private let logInterval: TimeInterval = 30.0 // Log summary every 30 seconds
+    private let dnsResolver = ReverseDNSResolver()
+    
+    // Connection bookkeeping: counts live on the scan side, close times on main
+    private var openConnectionCounts: [DetectionKey: Int] = [:]
+    private var detectionClosedTimes: [DetectionKey: Date] = [:]
+    
+    // Link quality for upload pacing, tracked apart from connection scanning
+    // (free plan included). An NWPathMonitor can't restart once cancelled, so
+    // it is started once and left running.
+    enum LinkQuality: String {
+        case unavailable
+        case constrained    // Low Data Mode
+        case expensive      // cellular or a personal hotspot
+        case wifi
+        case wired
+        
+        // Upload budget that leaves headroom for the meeting on the same link
+        var uploadBytesPerSecond: Int {
+            switch self {
+            case .unavailable: return 0
+            case .constrained: return 64 * 1024
+            case .expensive: return 128 * 1024
+            case .wifi: return 512 * 1024
+            case .wired: return 2 * 1024 * 1024
+            }
+        }
+    }
+    
+    private let pathMonitor = NWPathMonitor()
+    private let pathQueue = DispatchQueue(label: "com.truely.networkmonitor.path", qos: .utility)
+    private var isPathMonitorStarted = false
+    private let linkLock = NSLock()
+    private var currentLinkQuality: LinkQuality = .wifi
+    var onLinkQualityChange: ((LinkQuality) -> Void)?
     
     // LLM API endpoints to monitor
     private let llmApiDomains = [
@@ -69,81 +104,142 @@ class NetworkMonitor: ObservableObject {
         "colab.research.google.com"
     ]
     
-    func startNetworkMonitoring() {
+    // Compiled from the lists above (or configure); rebuilt only when the rules
+    // change and swapped under a lock, since scans read it off the main thread
+    private var compiledMatcher: DestinationMatcher
+    private let matcherLock = NSLock()
+    
+    private var destinationMatcher: DestinationMatcher {
+        matcherLock.lock()
+        defer { matcherLock.unlock() }
+        return compiledMatcher
+    }
+    
+    init() {
+        compiledMatcher = DestinationMatcher(
+            domains: llmApiDomains.map { ($0, .definitive) } + aiRelatedDomains.map { ($0, .suspicious) }
+        )
+    }
+    
+    // Replaces the built-in destination rules. Provider ranges are CIDRs
+    // ("203.0.113.0/24", "2001:db8::/32") classified like API endpoints.
+    func configure(llmApiDomains: [String], aiRelatedDomains: [String], providerRanges: [String] = []) {
+        let matcher = DestinationMatcher(
+            domains: llmApiDomains.map { ($0, .definitive) } + aiRelatedDomains.map { ($0, .suspicious) },
+            ranges: providerRanges.map { ($0, .definitive) }
+        )
+        print("🌐 Loaded \(matcher.ruleCount) destination rules")
+        
+        matcherLock.lock()
+        compiledMatcher = matcher
+        matcherLock.unlock()
+    }
+    
+    var linkQuality: LinkQuality {
+        linkLock.lock()
+        defer { linkLock.unlock() }
+        return currentLinkQuality
+    }
+    
+    func startLinkMonitoring() {
+        linkLock.lock()
+        let alreadyStarted = isPathMonitorStarted
+        isPathMonitorStarted = true
+        linkLock.unlock()
+        guard !alreadyStarted else { return }
+        
+        pathMonitor.pathUpdateHandler = { [weak self] path in
+            self?.updateLinkQuality(path)
+        }
+        pathMonitor.start(queue: pathQueue)
+    }
+    
+    private func updateLinkQuality(_ path: NWPath) {
+        let quality: LinkQuality
+        if path.status != .satisfied {
+            quality = .unavailable
+        } else if path.isConstrained {
+            quality = .constrained
+        } else if path.isExpensive {
+            quality = .expensive
+        } else if path.usesInterfaceType(.wiredEthernet) {
+            quality = .wired
+        } else {
+            quality = .wifi
+        }
+        
+        linkLock.lock()
+        let changed = quality != currentLinkQuality
+        currentLinkQuality = quality
+        linkLock.unlock()
+        
+        if changed {
+            print("🌐 Link quality: \(quality.rawValue) (upload budget \(quality.uploadBytesPerSecond / 1024) KB/s)")
+            onLinkQualityChange?(quality)
+        }
+    }
+    
+    func startNetworkMonitoring(scheduler: MonitoringScheduler = .shared) {
         guard !isActive else { return }
         isActive = true
+        self.scheduler = scheduler
         
         print("🌐 Network monitoring started for LLM API detection")
         
-        // Monitor network connections every 10 seconds for better capture of short-lived connections
-        networkMonitoringTimer = Timer.scheduledTimer(withTimeInterval: 10.0, repeats: true) { _ in
-            DispatchQueue.global(qos: .utility).async {
-                self.checkNetworkConnections()
+        // Connections are classified on the IP first, then again once its PTR name arrives
+        dnsResolver.onResolved = { [weak self] ip, domain in
+            DispatchQueue.main.async {
+                self?.refineDetections(forIP: ip, domain: domain)
             }
         }
         
-        // Run initial check
-        DispatchQueue.global(qos: .utility).async {
-            self.checkNetworkConnections()
+        // Monitor network connections every 10 seconds for better capture of short-lived connections
+        scheduler.register("network", interval: 10.0, initialDelay: 0.5, needsSnapshot: true) { snapshot in
+            ScanTelemetry.shared.measure(.network) {
+                self.checkNetworkConnections(snapshot: snapshot)
+            }
         }
     }
     
     func stopNetworkMonitoring() {
         isActive = false
-        networkMonitoringTimer?.invalidate()
-        networkMonitoringTimer = nil
+        // The open counts belong to the scan side, so they are reset there
+        // along with the bridge's connection table, after the last scan
+        scheduler?.unregister("network") {
+            resetConnectionChanges()
+            self.openConnectionCounts.removeAll()
+        }
+        scheduler = nil
         networkDetections.removeAll()
+        dnsResolver.onResolved = nil
+        detectionClosedTimes.removeAll()
         print("🌐 Network monitoring stopped")
     }
     
-    private func checkNetworkConnections() {
+    private func checkNetworkConnections(snapshot: ScanSnapshot?) {
         let startTime = Date()
         var newDetections: [NetworkDetectionResult] = []
         
-        // Use lsof to get network connections with process information
-        let task = Process()
-        task.executableURL = URL(fileURLWithPath: "/usr/sbin/lsof")
-        // Only show ESTABLISHED outbound connections, not listening sockets
-        task.arguments = ["-i", "-n", "-P", "-sTCP:ESTABLISHED"]
-        
-        let pipe = Pipe()
-        let errorPipe = Pipe()
-        task.standardOutput = pipe
-        task.standardError = errorPipe
-        
-        do {
-            try task.run()
-            task.waitUntilExit()
-            
-            let data = pipe.fileHandleForReading.readDataToEndOfFile()
-            if let output = String(data: data, encoding: .utf8) {
-                newDetections = parseNetworkConnections(output: output)
-            }
-        } catch {
-            // Silently handle errors - network monitoring is supplementary
+        // Only connections opened since the last scan are analyzed; the bridge
+        // tracks the rest by 5-tuple
+        var delta = ConnectionDelta()
+        var openedKeys: [DetectionKey] = []
+        var closedKeys: [DetectionKey] = []
+        if getConnectionChanges(&delta) > 0 {
+            newDetections = analyzeOpenedConnections(delta, snapshot: snapshot)
+            trackOpenConnections(delta, openedKeys: &openedKeys, closedKeys: &closedKeys)
         }
+        freeConnectionDelta(&delta)
         
         let scanTime = Date().timeIntervalSince(startTime)
         
-        // Update detections on main thread
+        // Apply as one batched diff on the main thread
         DispatchQueue.main.async {
-            // Only keep unique detections from the last 5 minutes
-            let fiveMinutesAgo = Date().addingTimeInterval(-300)
-            self.networkDetections = self.networkDetections.filter { $0.timestamp > fiveMinutesAgo }
-            
-            // Add new detections
-            for detection in newDetections {
-                // Avoid duplicates by checking if we already have this process->domain combo recently
-                let isDuplicate = self.networkDetections.contains { existing in
-                    existing.pid == detection.pid && 
-                    existing.destinationDomain == detection.destinationDomain &&
-                    existing.timestamp.timeIntervalSince(detection.timestamp) < 60 // Within last minute
-                }
-                
-                if !isDuplicate {
-                    self.networkDetections.append(detection)
-                }
-            }
+            self.applyDetectionChanges(newDetections, openedKeys: openedKeys, closedKeys: closedKeys)
+        }
+        
+        if !closedKeys.isEmpty {
+            print("🌐 \(closedKeys.count) destinations no longer connected")
         }
         
         // Log summary periodically
@@ -152,36 +248,109 @@ class NetworkMonitor: ObservableObject {
             lastDetectionLog = Date()
         }
         
+        // Only destinations that just became connected count as new
+        let newlyOpened = Set(openedKeys)
+        if newDetections.contains(where: { $0.confidence == .definitive && newlyOpened.contains(DetectionKey(pid: $0.pid, address: $0.destinationAddress)) }) {
+            scheduler?.reportDetection()
+        }
+        
         // Only log if we have meaningful detections
         if newDetections.count > 0 {
             print("🌐 Found \(newDetections.count) new outbound connections")
         }
     }
     
-    private func parseNetworkConnections(output: String) -> [NetworkDetectionResult] {
+    private struct DetectionKey: Hashable {
+        let pid: pid_t
+        let address: String
+    }
+    
+    // Counts open connections per (pid, remote address); only transitions
+    // between none and some are handed to the main thread
+    private func trackOpenConnections(_ delta: ConnectionDelta, openedKeys: inout [DetectionKey], closedKeys: inout [DetectionKey]) {
+        for change in delta.records where change.connection.remotePort != 0 {
+            let key = DetectionKey(pid: change.connection.pid, address: change.connection.remoteAddressString)
+            let count = openConnectionCounts[key, default: 0]
+            
+            if change.type == CONNECTION_OPENED {
+                openConnectionCounts[key] = count + 1
+                if count == 0 { openedKeys.append(key) }
+            } else if count > 0 {
+                openConnectionCounts[key] = count > 1 ? count - 1 : nil
+                if count == 1 { closedKeys.append(key) }
+            }
+        }
+    }
+    
+    // Detections stay while their destination is connected, then for 5 more
+    // minutes. One (pid, destination) detection is kept at a time.
+    private func applyDetectionChanges(_ newDetections: [NetworkDetectionResult], openedKeys: [DetectionKey], closedKeys: [DetectionKey]) {
+        let now = Date()
+        for key in openedKeys {
+            detectionClosedTimes.removeValue(forKey: key)
+        }
+        for key in closedKeys {
+            detectionClosedTimes[key] = now
+        }
+        
+        let fiveMinutesAgo = now.addingTimeInterval(-300)
+        let isExpired = { (detection: NetworkDetectionResult) -> Bool in
+            guard let closedTime = self.detectionClosedTimes[DetectionKey(pid: detection.pid, address: detection.destinationAddress)] else { return false }
+            return closedTime <= fiveMinutesAgo
+        }
+        
+        var seen = Set(networkDetections.lazy.filter { !isExpired($0) }.map { DetectionKey(pid: $0.pid, address: $0.destinationAddress) })
+        
+        // A PTR answer can land before the detection it refines exists (cached
+        // lookups come back within a tick), so bare-IP additions pick up any
+        // name resolved since they were classified
+        let additions = newDetections
+            .filter { seen.insert(DetectionKey(pid: $0.pid, address: $0.destinationAddress)).inserted }
+            .map { detection -> NetworkDetectionResult in
+                guard detection.destinationDomain == detection.destinationAddress,
+                      let domain = dnsResolver.cachedName(for: detection.destinationAddress) else { return detection }
+                return refined(detection, domain: domain)
+            }
+        let hasExpired = networkDetections.contains(where: isExpired)
+        
+        // Publish only when something changed
+        guard hasExpired || !additions.isEmpty else { return }
+        
+        var updated = networkDetections
+        if hasExpired {
+            updated.removeAll(where: isExpired)
+            detectionClosedTimes = detectionClosedTimes.filter { $0.value > fiveMinutesAgo }
+        }
+        updated.append(contentsOf: additions)
+        networkDetections = updated
+    }
+    
+    private func analyzeOpenedConnections(_ delta: ConnectionDelta, snapshot: ScanSnapshot?) -> [NetworkDetectionResult] {
         var detections: [NetworkDetectionResult] = []
-        let lines = output.components(separatedBy: .newlines)
         var processSummary: [String: [String]] = [:] // [processName: [destinations]]
+        var lookedUpNames: [pid_t: String] = [:]
         
-        for line in lines {
-            // Skip header line and empty lines
-            guard !line.isEmpty && !line.starts(with: "COMMAND") else { continue }
+        for change in delta.records where change.type == CONNECTION_OPENED {
+            let connection = change.connection
             
-            // Parse lsof output: COMMAND PID USER FD TYPE DEVICE SIZE/OFF NODE NAME
-            let components = line.components(separatedBy: .whitespaces).filter { !$0.isEmpty }
-            guard components.count >= 9 else { continue }
+            // Only outbound connections have a remote end
+            guard connection.remotePort != 0 else { continue }
             
-            let processName = components[0]
-            guard let pid = pid_t(components[1]) else { continue }
-            let connectionInfo = components[8] // This contains the connection details
-            
-            // Only process outbound connections (contain "->")
-            guard connectionInfo.contains("->") else { continue }
+            let pid = connection.pid
+            let processName: String
+            // Names come from the scheduler tick's snapshot; PIDs newer than it are looked up
+            if let cachedName = snapshot?.process(pid: pid)?.name ?? lookedUpNames[pid] {
+                processName = cachedName
+            } else {
+                processName = getProcessNameString(forPid: pid)
+                lookedUpNames[pid] = processName
+            }
             
             if let detection = analyzeConnection(
                 processName: processName,
                 pid: pid,
-                connectionInfo: connectionInfo
+                destinationHost: connection.remoteAddressString,
+                destinationPort: Int(connection.remotePort)
             ) {
                 detections.append(detection)
                 
@@ -200,9 +369,9 @@ class NetworkMonitor: ObservableObject {
             }
         }
         
-        // Show ALL outbound connections (no filtering)
+        // Show every newly opened outbound connection (no filtering)
         if !processSummary.isEmpty {
-            print("🌐 ALL OUTBOUND CONNECTIONS (\(detections.count) total):")
+            print("🌐 NEW OUTBOUND CONNECTIONS (\(detections.count) total):")
             
             // First, highlight any potential LLM-related processes
             let llmSuspects = processSummary.filter { (processKey, destinations) in
@@ -233,44 +402,13 @@ class NetworkMonitor: ObservableObject {
                 }
             }
         } else {
-            print("🌐 No outbound connections found")
+            print("🌐 No new outbound connections")
         }
         
         return detections
     }
     
-    private func analyzeConnection(processName: String, pid: pid_t, connectionInfo: String) -> NetworkDetectionResult? {
-        // Extract destination from connection info
-        // Expected format: "192.168.1.100:54321->142.250.191.78:443" or similar
-        var destinationHost = ""
-        var destinationPort = 0
-        
-        if connectionInfo.contains("->") {
-            // Format: local->remote (this is what we want for outbound connections)
-            let parts = connectionInfo.components(separatedBy: "->")
-            if parts.count >= 2 {
-                let remote = parts[1].trimmingCharacters(in: .whitespaces)
-                
-                // Handle IPv6 format [addr]:port or regular addr:port
-                if remote.starts(with: "[") {
-                    // IPv6 format: [addr]:port
-                    if let bracketEnd = remote.firstIndex(of: "]"),
-                       let colonIndex = remote.lastIndex(of: ":") {
-                        destinationHost = String(remote[remote.index(after: remote.startIndex)..<bracketEnd])
-                        let portStr = String(remote[remote.index(after: colonIndex)...])
-                        destinationPort = Int(portStr) ?? 0
-                    }
-                } else {
-                    // Regular format: addr:port
-                    if let colonIndex = remote.lastIndex(of: ":") {
-                        destinationHost = String(remote[..<colonIndex])
-                        let portStr = String(remote[remote.index(after: colonIndex)...])
-                        destinationPort = Int(portStr) ?? 0
-                    }
-                }
-            }
-        }
-        
+    private func analyzeConnection(processName: String, pid: pid_t, destinationHost: String, destinationPort: Int) -> NetworkDetectionResult? {
         // Only skip truly empty hosts
         guard !destinationHost.isEmpty else { return nil }
         
@@ -282,7 +420,7 @@ class NetworkMonitor: ObservableObject {
         let processPath = getProcessPathString(forPid: pid)
         
         // Analyze if this is an LLM-related connection
-        let (confidence, evidence) = analyzeDestination(host: hostToAnalyze, port: destinationPort)
+        let (confidence, evidence) = analyzeDestination(host: hostToAnalyze, ip: destinationHost, port: destinationPort)
         
         // For debugging: log what we're finding with detailed info
         let suspiciousApps = ["cluely", "chatgpt", "safari", "chrome", "desktop", "electron", "claude", "openai"]
@@ -314,6 +452,7 @@ class NetworkMonitor: ObservableObject {
             processPath: processPath,
             pid: pid,
             destinationDomain: hostToAnalyze,
+            destinationAddress: destinationHost,
             destinationPort: destinationPort,
             connectionProtocol: destinationPort == 443 ? "HTTPS" : "HTTP",
             confidence: confidence,
@@ -322,23 +461,20 @@ class NetworkMonitor: ObservableObject {
         )
     }
     
-    private func analyzeDestination(host: String, port: Int) -> (NetworkDetectionResult.DetectionConfidence, [String]) {
+    private func analyzeDestination(host: String, ip: String, port: Int) -> (NetworkDetectionResult.DetectionConfidence, [String]) {
         let lowerHost = host.lowercased()
         var evidence: [String] = []
         
-        // Check for definitive LLM API endpoints
-        for apiDomain in llmApiDomains {
-            if lowerHost.contains(apiDomain.lowercased()) {
-                evidence.append("Direct API call to \(apiDomain)")
+        // Known LLM API endpoints and AI-related services, by domain suffix or provider range
+        let matcher = destinationMatcher
+        if let match = matcher.match(host: host) ?? matcher.match(ip: ip) {
+            switch match.category {
+            case .definitive:
+                evidence.append("Direct API call to \(match.rule)")
                 evidence.append("Port: \(port) (\(port == 443 ? "HTTPS" : "HTTP"))")
                 return (.definitive, evidence)
-            }
-        }
-        
-        // Check for AI-related domains
-        for aiDomain in aiRelatedDomains {
-            if lowerHost.contains(aiDomain.lowercased()) {
-                evidence.append("Connection to AI/ML service: \(aiDomain)")
+            case .suspicious:
+                evidence.append("Connection to AI/ML service: \(match.rule)")
                 evidence.append("Port: \(port)")
                 return (.suspicious, evidence)
             }
@@ -357,6 +493,8 @@ class NetworkMonitor: ObservableObject {
         return (.informational, evidence)
     }
     
+    // Never blocks: returns the cached PTR name, or "" while the lookup is
+    // pending (refineDetections picks up the answer)
     private func resolveIPToDomain(_ ipAddress: String) -> String {
         // Only try to resolve if it looks like an IP address
         guard ipAddress.contains(".") || ipAddress.contains(":") else { return "" }
@@ -367,21 +505,36 @@ class NetworkMonitor: ObservableObject {
             return "" // Already a domain name
         }
         
-        // Simple reverse DNS lookup
-        var addr = inet_addr(ipAddress)
-        
-        if addr != INADDR_NONE {
-            let hostent = gethostbyaddr(&addr, 4, AF_INET)
-            if let hostent = hostent, let name = hostent.pointee.h_name {
-                let domain = String(cString: name)
-                // Only return if it's a meaningful domain (not just reverse IP)
-                if !domain.contains(".in-addr.arpa") && domain.contains(".") {
-                    return domain
-                }
-            }
+        return dnsResolver.cachedName(for: ipAddress) ?? ""
+    }
+    
+    // Re-classifies detections that were made on a bare IP now that its name is known
+    private func refineDetections(forIP ip: String, domain: String) {
+        for (index, detection) in networkDetections.enumerated() where detection.destinationAddress == ip && detection.destinationDomain == ip {
+            networkDetections[index] = refined(detection, domain: domain)
+        }
+    }
+    
+    private func refined(_ detection: NetworkDetectionResult, domain: String) -> NetworkDetectionResult {
+        let ip = detection.destinationAddress
+        let (confidence, evidence) = analyzeDestination(host: domain, ip: ip, port: detection.destinationPort)
+        if confidence != .informational {
+            print("🌐 Resolved \(ip) → \(domain): \(detection.processName) (PID:\(detection.pid)) is \(confidence.description)")
         }
         
-        return ""
+        return NetworkDetectionResult(
+            timestamp: detection.timestamp,
+            processName: detection.processName,
+            processPath: detection.processPath,
+            pid: detection.pid,
+            destinationDomain: domain,
+            destinationAddress: ip,
+            destinationPort: detection.destinationPort,
+            connectionProtocol: detection.connectionProtocol,
+            confidence: confidence,
+            message: "[\(confidence.description)] \(detection.processName) → \(domain) (\(ip)):\(detection.destinationPort)",
+            evidence: evidence
+        )
     }
     
     private func getProcessPathString(forPid pid: pid_t) -> String {
@@ -390,12 +543,18 @@ class NetworkMonitor: ObservableObject {
         
         // Call the C bridge function directly
         let result = getProcessPath(pid, pathBuffer, 4096)
-        if result > 0 {
+        if result == 0 {
             return String(cString: pathBuffer)
         }
         return ""
     }
     
+    private func getProcessNameString(forPid pid: pid_t) -> String {
+        var nameBuffer = [CChar](repeating: 0, count: 256)
+        guard getProcessName(pid, &nameBuffer, nameBuffer.count) == 0 else { return "PID \(pid)" }
+        return String(cString: nameBuffer)
+    }
+    
     private func logNetworkDetectionSummary(scanTime: TimeInterval, newDetections: [NetworkDetectionResult]) {
         let definitiveCount = newDetections.filter { $0.confidence == .definitive }.count
         let suspiciousCount = newDetections.filter { $0.confidence == .suspicious }.count
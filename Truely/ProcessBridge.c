@@ -19,364 +19,3418 @@ int initializeProcessBridge(void) {
     return BRIDGE_SUCCESS;
 }
 
+static void releaseProcessCache(void);
+
 void cleanupProcessBridge(void) {
+    stopProcessWatcher();
+    resetConnectionChanges();
+    resetWindowEvents();
     pthread_mutex_lock(&g_bridge_mutex);
+    releaseProcessCache();
     g_bridge_initialized = 0;
     pthread_mutex_unlock(&g_bridge_mutex);
     pthread_mutex_destroy(&g_bridge_mutex);
 }
 
-int getAllProcesses(SystemProcessInfo **processes) {
-    if (!processes) {
-        return BRIDGE_ERROR_NULL_POINTER;
+// MARK: - Metrics
+
+// One relaxed atomic per BridgeMetrics field; counters are only ever added to
+typedef struct {
+    _Atomic uint64_t processScans;
+    _Atomic uint64_t sharedScans;
+    _Atomic uint64_t processesScanned;
+    _Atomic uint64_t processesResolved;
+    _Atomic uint64_t scanNanoseconds;
+    _Atomic uint64_t sysctlNanoseconds;
+    _Atomic uint64_t resolveNanoseconds;
+    _Atomic uint64_t windowCopies;
+    _Atomic uint64_t windowCopyNanoseconds;
+    _Atomic uint64_t socketScans;
+    _Atomic uint64_t socketScanNanoseconds;
+    _Atomic uint64_t hashCacheHits;
+    _Atomic uint64_t hashCacheMisses;
+    _Atomic uint64_t filesHashed;
+    _Atomic uint64_t bytesHashed;
+    _Atomic uint64_t hashNanoseconds;
+} BridgeMetricCounters;
+
+static BridgeMetricCounters g_metrics;
+static os_log_t g_signpost_log;
+static pthread_once_t g_signpost_once = PTHREAD_ONCE_INIT;
+
+static void createSignpostLog(void) {
+    g_signpost_log = os_log_create("com.truely.bridge", "Scan");
+}
+
+static os_log_t signpostLog(void) {
+    pthread_once(&g_signpost_once, createSignpostLog);
+    return g_signpost_log;
+}
+
+static inline uint64_t metricsNow(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static inline void countMetric(_Atomic uint64_t *counter, uint64_t value) {
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static inline uint64_t readMetric(_Atomic uint64_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+void getBridgeMetrics(BridgeMetrics *metrics) {
+    if (!metrics) {
+        return;
+    }
+    
+    metrics->processScans = readMetric(&g_metrics.processScans);
+    metrics->sharedScans = readMetric(&g_metrics.sharedScans);
+    metrics->processesScanned = readMetric(&g_metrics.processesScanned);
+    metrics->processesResolved = readMetric(&g_metrics.processesResolved);
+    metrics->scanNanoseconds = readMetric(&g_metrics.scanNanoseconds);
+    metrics->sysctlNanoseconds = readMetric(&g_metrics.sysctlNanoseconds);
+    metrics->resolveNanoseconds = readMetric(&g_metrics.resolveNanoseconds);
+    metrics->windowCopies = readMetric(&g_metrics.windowCopies);
+    metrics->windowCopyNanoseconds = readMetric(&g_metrics.windowCopyNanoseconds);
+    metrics->socketScans = readMetric(&g_metrics.socketScans);
+    metrics->socketScanNanoseconds = readMetric(&g_metrics.socketScanNanoseconds);
+    metrics->hashCacheHits = readMetric(&g_metrics.hashCacheHits);
+    metrics->hashCacheMisses = readMetric(&g_metrics.hashCacheMisses);
+    metrics->filesHashed = readMetric(&g_metrics.filesHashed);
+    metrics->bytesHashed = readMetric(&g_metrics.bytesHashed);
+    metrics->hashNanoseconds = readMetric(&g_metrics.hashNanoseconds);
+}
+
+// MARK: - Allocation Counting
+
+// libsystem_malloc's logging hook, the one MallocStackLogging installs. It is
+// exported but not in the SDK headers. It sees every malloc, calloc, realloc
+// and valloc in the process, whichever zone serves it.
+typedef void (malloc_logger_t)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip);
+extern malloc_logger_t *malloc_logger;
+
+#define MALLOC_LOG_TYPE_ALLOCATE 2
+
+static _Atomic uint64_t g_allocation_count;
+static malloc_logger_t *g_previous_malloc_logger;
+
+// Runs inside malloc, so it must not allocate
+static void countAllocation(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3, uintptr_t result, uint32_t numHotFramesToSkip) {
+    if (type & MALLOC_LOG_TYPE_ALLOCATE) {
+        countMetric(&g_allocation_count, 1);
+    }
+    if (g_previous_malloc_logger) {
+        g_previous_malloc_logger(type, arg1, arg2, arg3, result, numHotFramesToSkip + 1);
+    }
+}
+
+void beginAllocationCounting(void) {
+    atomic_store_explicit(&g_allocation_count, 0, memory_order_relaxed);
+    if (malloc_logger != countAllocation) {
+        g_previous_malloc_logger = malloc_logger;
+        malloc_logger = countAllocation;
+    }
+}
+
+uint64_t endAllocationCounting(void) {
+    if (malloc_logger == countAllocation) {
+        malloc_logger = g_previous_malloc_logger;
+        g_previous_malloc_logger = NULL;
+    }
+    return readMetric(&g_allocation_count);
+}
+
+// MARK: - String Arena
+
+// Build-time state for a snapshot's string arena. Identical strings (helper
+// names, shared XPC service paths) are interned so each is stored once.
+typedef struct {
+    char *bytes;
+    size_t size;
+    size_t capacity;
+    uint32_t *slots;            // arena offset + 1 per slot, 0 = empty
+    uint32_t slotMask;
+    uint32_t stringCount;
+} StringArena;
+
+static inline uint32_t hashArenaString(const char *string, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)string[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int initStringArena(StringArena *arena, size_t initialCapacity, uint32_t slotCount) {
+    memset(arena, 0, sizeof(*arena));
+    
+    arena->bytes = malloc(initialCapacity);
+    arena->slots = calloc(slotCount, sizeof(uint32_t));
+    if (!arena->bytes || !arena->slots) {
+        free(arena->bytes);
+        free(arena->slots);
+        memset(arena, 0, sizeof(*arena));
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    arena->capacity = initialCapacity;
+    arena->slotMask = slotCount - 1;
+    
+    // Offset 0 is reserved for the empty string
+    arena->bytes[0] = '\0';
+    arena->size = 1;
+    return BRIDGE_SUCCESS;
+}
+
+static int growStringArenaSlots(StringArena *arena) {
+    uint32_t slotCount = (arena->slotMask + 1) * 2;
+    uint32_t *slots = calloc(slotCount, sizeof(uint32_t));
+    if (!slots) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    for (uint32_t i = 0; i <= arena->slotMask; i++) {
+        if (arena->slots[i] == 0) continue;
+        
+        const char *string = arena->bytes + (arena->slots[i] - 1);
+        uint32_t slot = hashArenaString(string, strlen(string)) & (slotCount - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = arena->slots[i];
+    }
+    
+    free(arena->slots);
+    arena->slots = slots;
+    arena->slotMask = slotCount - 1;
+    return BRIDGE_SUCCESS;
+}
+
+// Returns the arena offset of `string`, appending it only if not yet interned
+static int internString(StringArena *arena, const char *string, size_t length, uint32_t *offset) {
+    if (length == 0) {
+        *offset = 0;
+        return BRIDGE_SUCCESS;
+    }
+    
+    uint32_t slot = hashArenaString(string, length) & arena->slotMask;
+    while (arena->slots[slot] != 0) {
+        const char *candidate = arena->bytes + (arena->slots[slot] - 1);
+        if (memcmp(candidate, string, length) == 0 && candidate[length] == '\0') {
+            *offset = arena->slots[slot] - 1;
+            return BRIDGE_SUCCESS;
+        }
+        slot = (slot + 1) & arena->slotMask;
+    }
+    
+    if (arena->size + length + 1 > UINT32_MAX) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (arena->size + length + 1 > arena->capacity) {
+        size_t capacity = arena->capacity * 2;
+        while (capacity < arena->size + length + 1) {
+            capacity *= 2;
+        }
+        char *bytes = realloc(arena->bytes, capacity);
+        if (!bytes) {
+            return BRIDGE_ERROR_MEMORY_ALLOCATION;
+        }
+        arena->bytes = bytes;
+        arena->capacity = capacity;
+    }
+    
+    *offset = (uint32_t)arena->size;
+    memcpy(arena->bytes + arena->size, string, length);
+    arena->bytes[arena->size + length] = '\0';
+    arena->size += length + 1;
+    
+    arena->slots[slot] = *offset + 1;
+    arena->stringCount++;
+    
+    // Keep the intern table at most half full
+    if (arena->stringCount * 2 > arena->slotMask + 1) {
+        return growStringArenaSlots(arena);
+    }
+    return BRIDGE_SUCCESS;
+}
+
+// MARK: - Process Cache
+
+// Persistent per-process state, keyed by (pid, start time) so a recycled PID
+// is never mistaken for the process that used to own it. Names and paths are
+// resolved once per process lifetime and kept in the cache's own arena.
+typedef struct {
+    SystemProcessInfo info;     // latest state, offsets into g_process_cache.arena
+    SystemProcessInfo reported; // window state last handed out by getProcessChanges
+    uint64_t startTime;         // kp_proc.p_starttime in microseconds
+    int isReported;             // spawn has been handed out by getProcessChanges
+    int isExited;               // gone from the process table, exit not yet reported
+    int isStale;                // exec'd since it was resolved; name/path must be re-read
+} CachedProcess;
+
+typedef struct {
+    CachedProcess *entries;
+    int count;
+    int *slots;                 // open-addressed index into entries, -1 = empty
+    int slotMask;
+    StringArena arena;
+    size_t liveStringBytes;     // bytes referenced by current entries
+} ProcessCache;
+
+static ProcessCache g_process_cache;
+
+// Guards g_process_cache and the scan state below. Held for lookups and
+// copies only, never across a process table or WindowServer walk.
+static pthread_mutex_t g_process_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_process_scan_cond = PTHREAD_COND_INITIALIZER;
+static int g_process_scan_active = 0;
+static uint64_t g_process_scan_generation = 0;
+static uint64_t g_process_scan_time = 0;    // CLOCK_UPTIME_RAW ns when the last scan finished
+static int g_process_scan_result = BRIDGE_SUCCESS;
+
+// Process watcher state (fd/thread owned by start/stopProcessWatcher;
+// g_watcher_kq changes under g_process_cache_mutex)
+static int g_watcher_kq = -1;
+static pthread_t g_watcher_thread;
+static ProcessEventCallback g_watcher_callback = NULL;
+static void *g_watcher_context = NULL;
+static const uintptr_t kWatcherWakeIdent = 1;
+
+static void watchProcessEvents(pid_t pid);
+
+// Compact the cache arena once dead strings dominate it
+static const size_t kProcessCacheCompactThreshold = 1024 * 1024;
+
+static inline uint32_t processCacheHash(pid_t pid, uint64_t startTime) {
+    return ((uint32_t)pid * 2654435761u) ^ (uint32_t)(startTime ^ (startTime >> 32));
+}
+
+static int findCachedProcess(const ProcessCache *cache, pid_t pid, uint64_t startTime) {
+    if (!cache->slots) {
+        return -1;
+    }
+    
+    uint32_t slot = processCacheHash(pid, startTime) & (uint32_t)cache->slotMask;
+    while (cache->slots[slot] >= 0) {
+        const CachedProcess *entry = &cache->entries[cache->slots[slot]];
+        if (entry->info.pid == pid && entry->startTime == startTime) {
+            return cache->slots[slot];
+        }
+        slot = (slot + 1) & (uint32_t)cache->slotMask;
+    }
+    return -1;
+}
+
+static int indexProcessCache(ProcessCache *cache) {
+    size_t slotCount = 16;
+    while (slotCount < (size_t)cache->count * 2) {
+        slotCount <<= 1;
+    }
+    
+    int *slots = malloc(slotCount * sizeof(int));
+    if (!slots) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    memset(slots, 0xFF, slotCount * sizeof(int));
+    
+    for (int i = 0; i < cache->count; i++) {
+        const CachedProcess *entry = &cache->entries[i];
+        uint32_t slot = processCacheHash(entry->info.pid, entry->startTime) & (uint32_t)(slotCount - 1);
+        while (slots[slot] >= 0) {
+            slot = (slot + 1) & (uint32_t)(slotCount - 1);
+        }
+        slots[slot] = i;
+    }
+    
+    free(cache->slots);
+    cache->slots = slots;
+    cache->slotMask = (int)(slotCount - 1);
+    return BRIDGE_SUCCESS;
+}
+
+static int compactProcessCacheArena(ProcessCache *cache) {
+    StringArena arena;
+    uint32_t slotCount = 64;
+    while (slotCount < (uint32_t)cache->count * 4) {
+        slotCount <<= 1;
+    }
+    
+    int result = initStringArena(&arena, cache->liveStringBytes + 1, slotCount);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
+    }
+    
+    for (int i = 0; i < cache->count && result == BRIDGE_SUCCESS; i++) {
+        SystemProcessInfo *info = &cache->entries[i].info;
+        result = internString(&arena, cache->arena.bytes + info->nameOffset, info->nameLength, &info->nameOffset);
+        if (result == BRIDGE_SUCCESS) {
+            result = internString(&arena, cache->arena.bytes + info->pathOffset, info->pathLength, &info->pathOffset);
+        }
+    }
+    
+    if (result != BRIDGE_SUCCESS) {
+        free(arena.bytes);
+        free(arena.slots);
+        return result;
+    }
+    
+    free(cache->arena.bytes);
+    free(cache->arena.slots);
+    cache->arena = arena;
+    return BRIDGE_SUCCESS;
+}
+
+static void releaseProcessCache(void) {
+    pthread_mutex_lock(&g_process_cache_mutex);
+    ProcessCache *cache = &g_process_cache;
+    free(cache->entries);
+    free(cache->slots);
+    free(cache->arena.bytes);
+    free(cache->arena.slots);
+    memset(cache, 0, sizeof(*cache));
+    g_process_scan_generation = 0;
+    pthread_mutex_unlock(&g_process_cache_mutex);
+}
+
+static uint64_t processStartTime(const struct kinfo_proc *proc) {
+    return (uint64_t)proc->kp_proc.p_starttime.tv_sec * 1000000ull + (uint64_t)proc->kp_proc.p_starttime.tv_usec;
+}
+
+// Private libsystem call TCC uses to attribute helpers to their app; weak so a
+// system without it just reports 0 and callers fall back to the parent chain
+extern pid_t responsibility_get_pid_responsible_for_pid(pid_t pid) __attribute__((weak_import));
+
+static pid_t responsiblePidForPid(pid_t pid) {
+    if (!responsibility_get_pid_responsible_for_pid) return 0;
+    pid_t responsible = responsibility_get_pid_responsible_for_pid(pid);
+    return responsible > 0 ? responsible : 0;
+}
+
+static void applyWindowState(SystemProcessInfo *info, const WindowSnapshot *windowSnapshot) {
+    const WindowOwnerEntry *windows = windowSnapshot ? lookupWindowOwner(windowSnapshot, info->pid) : NULL;
+    
+    info->windowCount = windows ? windows->windowCount : 0;
+    info->screenEvasionCount = windows ? windows->screenEvasionCount : 0;
+    info->elevatedLayerCount = windows ? windows->elevatedLayerCount : 0;
+    info->sharingDisabledCount = windows ? windows->sharingDisabledCount : 0;
+    info->suspiciousWindowCount = (info->screenEvasionCount > 0 || info->elevatedLayerCount > 0) ? 1 : 0;
+}
+
+static int sameWindowState(const SystemProcessInfo *a, const SystemProcessInfo *b) {
+    return a->windowCount == b->windowCount &&
+           a->screenEvasionCount == b->screenEvasionCount &&
+           a->elevatedLayerCount == b->elevatedLayerCount &&
+           a->sharingDisabledCount == b->sharingDisabledCount;
+}
+
+// Names/paths of processes resolved outside the cache lock, in scratch storage
+typedef struct {
+    uint32_t nameOffset;
+    uint32_t pathOffset;
+    uint16_t nameLength;
+    uint16_t pathLength;
+    int isResolved;
+} ResolvedProcess;
+
+// Walks the live process table and merges it into g_process_cache. The
+// syscalls (sysctl, WindowServer, proc_pidinfo/proc_pidpath for new PIDs) run
+// without the cache lock; it is only held to look up and merge entries. Runs
+// on at most one thread at a time (see refreshProcessCache).
+static int scanProcessTable(void) {
+    ProcessCache *cache = &g_process_cache;
+    os_log_t log = signpostLog();
+    os_signpost_id_t signpost = os_signpost_id_generate(log);
+    
+    int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_ALL, 0};
+    size_t size;
+    
+    os_signpost_interval_begin(log, signpost, "Sysctl");
+    uint64_t phaseStart = metricsNow();
+    
+    // Get the size needed
+    if (sysctl(mib, 4, NULL, &size, NULL, 0) != 0) {
+        os_signpost_interval_end(log, signpost, "Sysctl");
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    if (size == 0) {
+        os_signpost_interval_end(log, signpost, "Sysctl");
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    // Allocate memory for process list
+    struct kinfo_proc *proc_list = malloc(size);
+    if (!proc_list) {
+        os_signpost_interval_end(log, signpost, "Sysctl");
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    // Get the actual process list
+    if (sysctl(mib, 4, proc_list, &size, NULL, 0) != 0) {
+        os_signpost_interval_end(log, signpost, "Sysctl");
+        free(proc_list);
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    int proc_count = (int)(size / sizeof(struct kinfo_proc));
+    countMetric(&g_metrics.sysctlNanoseconds, metricsNow() - phaseStart);
+    os_signpost_interval_end(log, signpost, "Sysctl", "%d processes", proc_count);
+    if (proc_count <= 0) {
+        free(proc_list);
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    countMetric(&g_metrics.processesScanned, (uint64_t)proc_count);
+    
+    ResolvedProcess *resolved = calloc((size_t)proc_count, sizeof(ResolvedProcess));
+    unsigned char *needsResolve = calloc((size_t)proc_count, 1);
+    StringArena scratch;
+    if (!resolved || !needsResolve || initStringArena(&scratch, 16 * 1024, 256) != BRIDGE_SUCCESS) {
+        free(resolved);
+        free(needsResolve);
+        free(proc_list);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    // One window list copy for the whole scan (non-critical if it fails)
+    WindowSnapshot windowSnapshot;
+    int hasWindowSnapshot = (createWindowSnapshot(&windowSnapshot) == BRIDGE_SUCCESS);
+    
+    // Which processes are new or exec'd since they were resolved?
+    pthread_mutex_lock(&g_process_cache_mutex);
+    for (int i = 0; i < proc_count; i++) {
+        pid_t pid = proc_list[i].kp_proc.p_pid;
+        if (pid <= 0) continue;
+        
+        int previous = findCachedProcess(cache, pid, processStartTime(&proc_list[i]));
+        needsResolve[i] = previous < 0 || cache->entries[previous].isExited || cache->entries[previous].isStale;
+    }
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    
+    // Resolve only those, without holding the lock
+    char name[PROC_PIDPATHINFO_MAXSIZE];
+    char path[PROC_PIDPATHINFO_MAXSIZE];
+    int result = BRIDGE_SUCCESS;
+    uint64_t resolvedCount = 0;
+    
+    os_signpost_interval_begin(log, signpost, "Resolve");
+    phaseStart = metricsNow();
+    
+    for (int i = 0; i < proc_count && result == BRIDGE_SUCCESS; i++) {
+        if (!needsResolve[i]) continue;
+        pid_t pid = proc_list[i].kp_proc.p_pid;
+        resolvedCount++;
+        
+        // Get process name
+        if (getProcessName(pid, name, sizeof(name)) != BRIDGE_SUCCESS) continue;
+        
+        // Get process path (non-critical if it fails)
+        if (getProcessPath(pid, path, sizeof(path)) != BRIDGE_SUCCESS) {
+            path[0] = '\0';
+        }
+        
+        ResolvedProcess *process = &resolved[i];
+        process->nameLength = (uint16_t)strlen(name);
+        process->pathLength = (uint16_t)strlen(path);
+        result = internString(&scratch, name, process->nameLength, &process->nameOffset);
+        if (result == BRIDGE_SUCCESS) {
+            result = internString(&scratch, path, process->pathLength, &process->pathOffset);
+        }
+        process->isResolved = (result == BRIDGE_SUCCESS);
+    }
+    
+    countMetric(&g_metrics.resolveNanoseconds, metricsNow() - phaseStart);
+    countMetric(&g_metrics.processesResolved, resolvedCount);
+    os_signpost_interval_end(log, signpost, "Resolve", "%llu processes", resolvedCount);
+    
+    free(needsResolve);
+    
+    // Merge. The cache may have changed since the lookup, so look up again.
+    pthread_mutex_lock(&g_process_cache_mutex);
+    
+    if (result == BRIDGE_SUCCESS && !cache->arena.bytes) {
+        result = initStringArena(&cache->arena, 64 * 1024, 1024);
+    }
+    
+    // New table = live processes + exits still waiting to be reported
+    size_t capacity = (size_t)proc_count + (size_t)cache->count;
+    CachedProcess *entries = NULL;
+    unsigned char *matched = NULL;
+    if (result == BRIDGE_SUCCESS) {
+        entries = malloc(capacity * sizeof(CachedProcess));
+        matched = calloc((size_t)cache->count + 1, 1);
+        if (!entries || !matched) {
+            result = BRIDGE_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+    
+    int count = 0;
+    size_t liveStringBytes = 0;
+    
+    for (int i = 0; i < proc_count && result == BRIDGE_SUCCESS; i++) {
+        pid_t pid = proc_list[i].kp_proc.p_pid;
+        
+        // Skip kernel processes (PID 0)
+        if (pid <= 0) continue;
+        
+        uint64_t startTime = processStartTime(&proc_list[i]);
+        CachedProcess *entry = &entries[count];
+        
+        int previous = findCachedProcess(cache, pid, startTime);
+        int isKnown = previous >= 0 && !cache->entries[previous].isExited;
+        if (isKnown && (!cache->entries[previous].isStale || !resolved[i].isResolved)) {
+            // Known process: reuse the resolved name and path (an exec seen
+            // mid-scan stays stale and is re-read next time)
+            *entry = cache->entries[previous];
+            matched[previous] = 1;
+        } else if (resolved[i].isResolved) {
+            memset(entry, 0, sizeof(*entry));
+            entry->info.pid = pid;
+            entry->info.startTime = startTime;
+            entry->info.responsiblePid = responsiblePidForPid(pid);
+            entry->startTime = startTime;
+            entry->info.nameLength = resolved[i].nameLength;
+            entry->info.pathLength = resolved[i].pathLength;
+            
+            result = internString(&cache->arena, scratch.bytes + resolved[i].nameOffset, resolved[i].nameLength, &entry->info.nameOffset);
+            if (result == BRIDGE_SUCCESS) {
+                result = internString(&cache->arena, scratch.bytes + resolved[i].pathOffset, resolved[i].pathLength, &entry->info.pathOffset);
+            }
+            
+            // A re-resolved exec keeps its kqueue registration
+            if (previous < 0) {
+                watchProcessEvents(pid);
+            }
+        } else {
+            continue;
+        }
+        
+        // Reparenting (the parent exited) changes ppid without a new lifetime
+        entry->info.parentPid = proc_list[i].kp_eproc.e_ppid;
+        applyWindowState(&entry->info, hasWindowSnapshot ? &windowSnapshot : NULL);
+        liveStringBytes += entry->info.nameLength + entry->info.pathLength + 2;
+        count++;
+    }
+    
+    // Processes that vanished keep their entry until the exit is reported
+    for (int i = 0; i < cache->count && result == BRIDGE_SUCCESS; i++) {
+        CachedProcess *old = &cache->entries[i];
+        if (matched[i] || !old->isReported) continue;
+        
+        entries[count] = *old;
+        entries[count].isExited = 1;
+        liveStringBytes += old->info.nameLength + old->info.pathLength + 2;
+        count++;
+    }
+    
+    if (result == BRIDGE_SUCCESS) {
+        free(cache->entries);
+        cache->entries = entries;
+        cache->count = count;
+        cache->liveStringBytes = liveStringBytes;
+        entries = NULL;
+        
+        result = indexProcessCache(cache);
+        if (result == BRIDGE_SUCCESS &&
+            cache->arena.size > kProcessCacheCompactThreshold &&
+            cache->arena.size > liveStringBytes * 4) {
+            result = compactProcessCacheArena(cache);
+        }
+    }
+    
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    
+    if (hasWindowSnapshot) {
+        freeWindowSnapshot(&windowSnapshot);
+    }
+    free(entries);
+    free(matched);
+    free(scratch.bytes);
+    free(scratch.slots);
+    free(resolved);
+    free(proc_list);
+    return result;
+}
+
+// Brings g_process_cache up to date. Scans are single-flight: a caller that
+// finds one in progress waits for it, and with maxAgeNanoseconds > 0 takes
+// its result (or a scan finished within that window) instead of running
+// another. Always returns with g_process_cache_mutex held.
+static int refreshProcessCache(uint64_t maxAgeNanoseconds) {
+    pthread_mutex_lock(&g_process_cache_mutex);
+    
+    for (;;) {
+        if (g_process_scan_active) {
+            uint64_t generation = g_process_scan_generation;
+            while (g_process_scan_active && g_process_scan_generation == generation) {
+                pthread_cond_wait(&g_process_scan_cond, &g_process_cache_mutex);
+            }
+            if (maxAgeNanoseconds > 0 && g_process_scan_generation != generation) {
+                countMetric(&g_metrics.sharedScans, 1);
+                return g_process_scan_result;
+            }
+            continue;
+        }
+        
+        if (maxAgeNanoseconds > 0 && g_process_scan_generation > 0 && g_process_scan_result == BRIDGE_SUCCESS &&
+            clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - g_process_scan_time <= maxAgeNanoseconds) {
+            countMetric(&g_metrics.sharedScans, 1);
+            return BRIDGE_SUCCESS;
+        }
+        break;
+    }
+    
+    g_process_scan_active = 1;
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    
+    os_log_t log = signpostLog();
+    os_signpost_id_t signpost = os_signpost_id_generate(log);
+    os_signpost_interval_begin(log, signpost, "ProcessScan");
+    uint64_t scanStart = metricsNow();
+    
+    int result = scanProcessTable();
+    
+    countMetric(&g_metrics.processScans, 1);
+    countMetric(&g_metrics.scanNanoseconds, metricsNow() - scanStart);
+    os_signpost_interval_end(log, signpost, "ProcessScan", "result %d", result);
+    
+    pthread_mutex_lock(&g_process_cache_mutex);
+    g_process_scan_active = 0;
+    g_process_scan_generation++;
+    g_process_scan_time = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    g_process_scan_result = result;
+    pthread_cond_broadcast(&g_process_scan_cond);
+    return result;
+}
+
+static char *copyProcessCacheStrings(const ProcessCache *cache) {
+    char *strings = malloc(cache->arena.size);
+    if (strings) {
+        memcpy(strings, cache->arena.bytes, cache->arena.size);
+    }
+    return strings;
+}
+
+// MARK: - Process Snapshot
+
+int getAllProcesses(ProcessSnapshot *snapshot) {
+    return getAllProcessesWithMaxAge(snapshot, 0);
+}
+
+int getAllProcessesWithMaxAge(ProcessSnapshot *snapshot, uint32_t maxAgeMilliseconds) {
+    if (!snapshot) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    memset(snapshot, 0, sizeof(*snapshot));
+    
+    int result = refreshProcessCache((uint64_t)maxAgeMilliseconds * 1000000ull);
+    if (result != BRIDGE_SUCCESS) {
+        pthread_mutex_unlock(&g_process_cache_mutex);
+        return result;
+    }
+    
+    const ProcessCache *cache = &g_process_cache;
+    
+    // Records keep their cache offsets, so the arena is copied wholesale
+    SystemProcessInfo *records = malloc((size_t)(cache->count > 0 ? cache->count : 1) * sizeof(SystemProcessInfo));
+    char *strings = copyProcessCacheStrings(cache);
+    if (!records || !strings) {
+        free(records);
+        free(strings);
+        pthread_mutex_unlock(&g_process_cache_mutex);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    int valid_count = 0;
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].isExited) continue;
+        records[valid_count++] = cache->entries[i].info;
+    }
+    
+    snapshot->processes = records;
+    snapshot->count = valid_count;
+    snapshot->strings = strings;
+    snapshot->stringsSize = cache->arena.size;
+    
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    return valid_count;
+}
+
+void freeProcessSnapshot(ProcessSnapshot *snapshot) {
+    if (!snapshot) {
+        return;
+    }
+    
+    free(snapshot->processes);
+    free(snapshot->strings);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+const char *getSnapshotString(const ProcessSnapshot *snapshot, uint32_t offset) {
+    if (!snapshot || !snapshot->strings || offset >= snapshot->stringsSize) {
+        return "";
+    }
+    return snapshot->strings + offset;
+}
+
+// MARK: - Process Changes
+
+int getProcessChanges(ProcessDelta *delta) {
+    return getProcessChangesWithMaxAge(delta, 0);
+}
+
+int getProcessChangesWithMaxAge(ProcessDelta *delta, uint32_t maxAgeMilliseconds) {
+    if (!delta) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    memset(delta, 0, sizeof(*delta));
+    
+    int result = refreshProcessCache((uint64_t)maxAgeMilliseconds * 1000000ull);
+    if (result != BRIDGE_SUCCESS) {
+        pthread_mutex_unlock(&g_process_cache_mutex);
+        return result;
+    }
+    
+    ProcessCache *cache = &g_process_cache;
+    
+    ProcessChange *changes = malloc((size_t)(cache->count > 0 ? cache->count : 1) * sizeof(ProcessChange));
+    char *strings = copyProcessCacheStrings(cache);
+    size_t stringsSize = cache->arena.size;
+    if (!changes || !strings) {
+        free(changes);
+        free(strings);
+        pthread_mutex_unlock(&g_process_cache_mutex);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    // Exits go first so a recycled PID's exit never follows its new spawn
+    int changeCount = 0;
+    for (int i = 0; i < cache->count; i++) {
+        if (!cache->entries[i].isExited) continue;
+        changes[changeCount].type = PROCESS_CHANGE_EXITED;
+        changes[changeCount].process = cache->entries[i].info;
+        changeCount++;
+    }
+    
+    int liveCount = 0;
+    for (int i = 0; i < cache->count; i++) {
+        CachedProcess *entry = &cache->entries[i];
+        
+        // Reported exits drop out of the table here
+        if (entry->isExited) continue;
+        
+        if (!entry->isReported) {
+            changes[changeCount].type = PROCESS_CHANGE_SPAWNED;
+            changes[changeCount].process = entry->info;
+            changeCount++;
+            entry->isReported = 1;
+            entry->reported = entry->info;
+        } else if (!sameWindowState(&entry->info, &entry->reported)) {
+            changes[changeCount].type = PROCESS_CHANGE_WINDOWS;
+            changes[changeCount].process = entry->info;
+            changeCount++;
+            entry->reported = entry->info;
+        }
+        
+        cache->entries[liveCount++] = *entry;
+    }
+    
+    if (liveCount != cache->count) {
+        cache->count = liveCount;
+        result = indexProcessCache(cache);
+    }
+    
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    
+    if (result != BRIDGE_SUCCESS) {
+        free(changes);
+        free(strings);
+        return result;
+    }
+    
+    delta->changes = changes;
+    delta->count = changeCount;
+    delta->strings = strings;
+    delta->stringsSize = stringsSize;
+    return changeCount;
+}
+
+void freeProcessDelta(ProcessDelta *delta) {
+    if (!delta) {
+        return;
+    }
+    
+    free(delta->changes);
+    free(delta->strings);
+    memset(delta, 0, sizeof(*delta));
+}
+
+void resetProcessChanges(void) {
+    pthread_mutex_lock(&g_process_cache_mutex);
+    
+    // Forget what has been reported: pending exits are dropped and every live
+    // process is handed out as spawned on the next getProcessChanges call
+    ProcessCache *cache = &g_process_cache;
+    int liveCount = 0;
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].isExited) continue;
+        cache->entries[i].isReported = 0;
+        cache->entries[liveCount++] = cache->entries[i];
+    }
+    if (liveCount != cache->count) {
+        cache->count = liveCount;
+        indexProcessCache(cache);
+    }
+    
+    pthread_mutex_unlock(&g_process_cache_mutex);
+}
+
+// MARK: - Process Watcher
+
+// Caller holds g_process_cache_mutex
+static void watchProcessEvents(pid_t pid) {
+    if (g_watcher_kq < 0 || pid <= 0) {
+        return;
+    }
+    
+    struct kevent change;
+    EV_SET(&change, (uintptr_t)pid, EVFILT_PROC, EV_ADD | EV_CLEAR, NOTE_EXIT | NOTE_FORK | NOTE_EXEC, 0, NULL);
+    
+    // Other users' processes may refuse registration (EPERM); those are still
+    // picked up by the reconciliation scan
+    kevent(g_watcher_kq, &change, 1, NULL, 0, NULL);
+}
+
+static void markCachedProcessStale(pid_t pid) {
+    pthread_mutex_lock(&g_process_cache_mutex);
+    
+    ProcessCache *cache = &g_process_cache;
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].info.pid == pid && !cache->entries[i].isExited) {
+            cache->entries[i].isStale = 1;
+        }
+    }
+    
+    pthread_mutex_unlock(&g_process_cache_mutex);
+}
+
+static void *processWatcherThread(void *arg) {
+    int kq = (int)(intptr_t)arg;
+    struct kevent events[64];
+    
+    for (;;) {
+        int eventCount = kevent(kq, NULL, 0, events, 64, NULL);
+        if (eventCount < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        for (int i = 0; i < eventCount; i++) {
+            if (events[i].filter == EVFILT_USER && events[i].ident == kWatcherWakeIdent) {
+                return NULL;
+            }
+            
+            if (events[i].filter != EVFILT_PROC || (events[i].flags & EV_ERROR)) continue;
+            
+            pid_t pid = (pid_t)events[i].ident;
+            uint32_t fflags = events[i].fflags;
+            
+            if (fflags & NOTE_EXEC) {
+                markCachedProcessStale(pid);
+                if (g_watcher_callback) g_watcher_callback(pid, PROCESS_EVENT_EXEC, g_watcher_context);
+            }
+            if ((fflags & NOTE_FORK) && g_watcher_callback) {
+                g_watcher_callback(pid, PROCESS_EVENT_FORK, g_watcher_context);
+            }
+            // The kernel drops the registration once the process exits
+            if ((fflags & NOTE_EXIT) && g_watcher_callback) {
+                g_watcher_callback(pid, PROCESS_EVENT_EXIT, g_watcher_context);
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+int startProcessWatcher(ProcessEventCallback callback, void *context) {
+    if (!callback) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    int mutex_result = pthread_mutex_lock(&g_bridge_mutex);
+    if (mutex_result != 0) {
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    if (g_watcher_kq >= 0) {
+        pthread_mutex_unlock(&g_bridge_mutex);
+        return BRIDGE_ERROR_INVALID_PARAMETER; // Already running
+    }
+    
+    int kq = kqueue();
+    if (kq < 0) {
+        pthread_mutex_unlock(&g_bridge_mutex);
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    // User event used by stopProcessWatcher to wake the thread
+    struct kevent wake;
+    EV_SET(&wake, kWatcherWakeIdent, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, NULL);
+    if (kevent(kq, &wake, 1, NULL, 0, NULL) != 0) {
+        close(kq);
+        pthread_mutex_unlock(&g_bridge_mutex);
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    g_watcher_callback = callback;
+    g_watcher_context = context;
+    
+    // Track everything already known; scans register new PIDs from here on
+    pthread_mutex_lock(&g_process_cache_mutex);
+    g_watcher_kq = kq;
+    for (int i = 0; i < g_process_cache.count; i++) {
+        if (!g_process_cache.entries[i].isExited) {
+            watchProcessEvents(g_process_cache.entries[i].info.pid);
+        }
+    }
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    
+    // Populate the cache if this is the first scan
+    refreshProcessCache(0);
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    
+    if (pthread_create(&g_watcher_thread, NULL, processWatcherThread, (void *)(intptr_t)kq) != 0) {
+        pthread_mutex_lock(&g_process_cache_mutex);
+        g_watcher_kq = -1;
+        pthread_mutex_unlock(&g_process_cache_mutex);
+        close(kq);
+        g_watcher_callback = NULL;
+        g_watcher_context = NULL;
+        pthread_mutex_unlock(&g_bridge_mutex);
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    pthread_mutex_unlock(&g_bridge_mutex);
+    return BRIDGE_SUCCESS;
+}
+
+void stopProcessWatcher(void) {
+    pthread_mutex_lock(&g_bridge_mutex);
+    
+    pthread_mutex_lock(&g_process_cache_mutex);
+    int kq = g_watcher_kq;
+    g_watcher_kq = -1;
+    pthread_mutex_unlock(&g_process_cache_mutex);
+    
+    if (kq < 0) {
+        pthread_mutex_unlock(&g_bridge_mutex);
+        return;
+    }
+    
+    struct kevent wake;
+    EV_SET(&wake, kWatcherWakeIdent, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+    kevent(kq, &wake, 1, NULL, 0, NULL);
+    
+    pthread_mutex_unlock(&g_bridge_mutex);
+    
+    // The thread may be waiting on g_process_cache_mutex in
+    // markCachedProcessStale, so join without holding any lock
+    pthread_join(g_watcher_thread, NULL);
+    close(kq);
+    
+    g_watcher_callback = NULL;
+    g_watcher_context = NULL;
+}
+
+int getProcessName(pid_t pid, char *name, size_t nameSize) {
+    if (!name || nameSize == 0) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    if (pid <= 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    struct proc_bsdinfo proc_info;
+    
+    if (proc_pidinfo(pid, PROC_PIDTBSDINFO, 0, &proc_info, sizeof(proc_info)) <= 0) {
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    strncpy(name, proc_info.pbi_name, nameSize - 1);
+    name[nameSize - 1] = '\0';
+    return BRIDGE_SUCCESS;
+}
+
+int getProcessPath(pid_t pid, char *path, size_t pathSize) {
+    if (!path || pathSize == 0) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    if (pid <= 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    // Ensure pathSize fits in uint32_t for proc_pidpath
+    if (pathSize > UINT32_MAX) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (proc_pidpath(pid, path, (uint32_t)pathSize) <= 0) {
+        path[0] = '\0';
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    return BRIDGE_SUCCESS;
+}
+
+// MARK: - Socket Enumeration
+
+// Copies one in_sockinfo into a record; returns 0 for non-internet sockets
+static int fillSocketConnection(SocketConnectionInfo *record, pid_t pid, const struct in_sockinfo *socket, SocketProtocol protocol) {
+    memset(record, 0, sizeof(*record));
+    record->pid = pid;
+    record->protocol = (uint8_t)protocol;
+    record->localPort = ntohs((uint16_t)socket->insi_lport);
+    record->remotePort = ntohs((uint16_t)socket->insi_fport);
+    record->state = -1;
+    
+    if (socket->insi_vflag & INI_IPV4) {
+        record->family = AF_INET;
+        memcpy(record->localAddress, &socket->insi_laddr.ina_46.i46a_addr4, 4);
+        memcpy(record->remoteAddress, &socket->insi_faddr.ina_46.i46a_addr4, 4);
+    } else if (socket->insi_vflag & INI_IPV6) {
+        record->family = AF_INET6;
+        memcpy(record->localAddress, &socket->insi_laddr.ina_6, 16);
+        memcpy(record->remoteAddress, &socket->insi_faddr.ina_6, 16);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static int collectSocketConnections(SocketSnapshot *snapshot, int connectedOnly);
+
+int getSocketConnections(SocketSnapshot *snapshot, int connectedOnly) {
+    if (!snapshot) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    memset(snapshot, 0, sizeof(*snapshot));
+    
+    os_log_t log = signpostLog();
+    os_signpost_id_t signpost = os_signpost_id_generate(log);
+    os_signpost_interval_begin(log, signpost, "SocketScan");
+    uint64_t scanStart = metricsNow();
+    int result = collectSocketConnections(snapshot, connectedOnly);
+    
+    countMetric(&g_metrics.socketScans, 1);
+    countMetric(&g_metrics.socketScanNanoseconds, metricsNow() - scanStart);
+    os_signpost_interval_end(log, signpost, "SocketScan", "result %d", result);
+    return result;
+}
+
+static int collectSocketConnections(SocketSnapshot *snapshot, int connectedOnly) {
+    // Size the PID list with some headroom for processes spawned meanwhile
+    int pidBytes = proc_listallpids(NULL, 0);
+    if (pidBytes <= 0) {
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    int pidCapacity = pidBytes / (int)sizeof(pid_t) + 64;
+    pid_t *pids = malloc((size_t)pidCapacity * sizeof(pid_t));
+    if (!pids) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    int pidCount = proc_listallpids(pids, pidCapacity * (int)sizeof(pid_t));
+    if (pidCount <= 0) {
+        free(pids);
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    // Scratch buffers reused across processes
+    int fdCapacity = 256;
+    struct proc_fdinfo *fds = malloc((size_t)fdCapacity * sizeof(struct proc_fdinfo));
+    int connectionCapacity = 256;
+    SocketConnectionInfo *connections = malloc((size_t)connectionCapacity * sizeof(SocketConnectionInfo));
+    if (!fds || !connections) {
+        free(fds);
+        free(connections);
+        free(pids);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    int count = 0;
+    int result = BRIDGE_SUCCESS;
+    
+    for (int i = 0; i < pidCount && result == BRIDGE_SUCCESS; i++) {
+        pid_t pid = pids[i];
+        if (pid <= 0) continue;
+        
+        // Processes we may not inspect (or that just exited) are skipped
+        int fdBytes = proc_pidinfo(pid, PROC_PIDLISTFDS, 0, NULL, 0);
+        if (fdBytes <= 0) continue;
+        
+        int needed = fdBytes / (int)sizeof(struct proc_fdinfo) + 16;
+        if (needed > fdCapacity) {
+            struct proc_fdinfo *grown = realloc(fds, (size_t)needed * sizeof(struct proc_fdinfo));
+            if (!grown) {
+                result = BRIDGE_ERROR_MEMORY_ALLOCATION;
+                break;
+            }
+            fds = grown;
+            fdCapacity = needed;
+        }
+        
+        fdBytes = proc_pidinfo(pid, PROC_PIDLISTFDS, 0, fds, fdCapacity * (int)sizeof(struct proc_fdinfo));
+        if (fdBytes <= 0) continue;
+        int fdCount = fdBytes / (int)sizeof(struct proc_fdinfo);
+        
+        for (int j = 0; j < fdCount; j++) {
+            if (fds[j].proc_fdtype != PROX_FDTYPE_SOCKET) continue;
+            
+            struct socket_fdinfo socketInfo;
+            if (proc_pidfdinfo(pid, fds[j].proc_fd, PROC_PIDFDSOCKETINFO, &socketInfo, sizeof(socketInfo)) != (int)sizeof(socketInfo)) {
+                continue;
+            }
+            
+            int family = socketInfo.psi.soi_family;
+            if (family != AF_INET && family != AF_INET6) continue;
+            
+            if (count == connectionCapacity) {
+                SocketConnectionInfo *grown = realloc(connections, (size_t)connectionCapacity * 2 * sizeof(SocketConnectionInfo));
+                if (!grown) {
+                    result = BRIDGE_ERROR_MEMORY_ALLOCATION;
+                    break;
+                }
+                connections = grown;
+                connectionCapacity *= 2;
+            }
+            
+            SocketConnectionInfo *record = &connections[count];
+            if (socketInfo.psi.soi_kind == SOCKINFO_TCP) {
+                const struct tcp_sockinfo *tcp = &socketInfo.psi.soi_proto.pri_tcp;
+                if (!fillSocketConnection(record, pid, &tcp->tcpsi_ini, SOCKET_PROTOCOL_TCP)) continue;
+                record->state = tcp->tcpsi_state;
+                if (connectedOnly && record->state != TSI_S_ESTABLISHED) continue;
+            } else if (socketInfo.psi.soi_kind == SOCKINFO_IN) {
+                if (!fillSocketConnection(record, pid, &socketInfo.psi.soi_proto.pri_in, SOCKET_PROTOCOL_UDP)) continue;
+                if (connectedOnly && record->remotePort == 0) continue;
+            } else {
+                continue;
+            }
+            count++;
+        }
+    }
+    
+    free(fds);
+    free(pids);
+    
+    if (result != BRIDGE_SUCCESS) {
+        free(connections);
+        return result;
+    }
+    
+    snapshot->connections = connections;
+    snapshot->count = count;
+    return count;
+}
+
+void freeSocketSnapshot(SocketSnapshot *snapshot) {
+    if (!snapshot) {
+        return;
+    }
+    
+    free(snapshot->connections);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+// MARK: - Connection Table
+
+// Connections seen by the previous getConnectionChanges call, indexed by 5-tuple
+typedef struct {
+    SocketConnectionInfo *connections;
+    int count;
+    int *slots;                 // open-addressed index into connections, -1 = empty
+    int slotMask;
+} ConnectionTable;
+
+static pthread_mutex_t g_connection_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ConnectionTable g_connection_table;
+
+// FNV-1a over the identifying fields (state is deliberately left out)
+static uint32_t connectionHash(const SocketConnectionInfo *connection) {
+    uint32_t hash = 2166136261u;
+    const unsigned char *fields[] = {
+        (const unsigned char *)&connection->pid,
+        (const unsigned char *)&connection->localPort,
+        (const unsigned char *)&connection->remotePort,
+        connection->localAddress,
+        connection->remoteAddress
+    };
+    const size_t sizes[] = {
+        sizeof(connection->pid),
+        sizeof(connection->localPort),
+        sizeof(connection->remotePort),
+        sizeof(connection->localAddress),
+        sizeof(connection->remoteAddress)
+    };
+    
+    for (size_t field = 0; field < sizeof(sizes) / sizeof(sizes[0]); field++) {
+        for (size_t i = 0; i < sizes[field]; i++) {
+            hash ^= fields[field][i];
+            hash *= 16777619u;
+        }
+    }
+    return hash ^ ((uint32_t)connection->protocol << 8 | connection->family);
+}
+
+static int sameConnection(const SocketConnectionInfo *a, const SocketConnectionInfo *b) {
+    return a->pid == b->pid &&
+           a->protocol == b->protocol &&
+           a->family == b->family &&
+           a->localPort == b->localPort &&
+           a->remotePort == b->remotePort &&
+           memcmp(a->localAddress, b->localAddress, sizeof(a->localAddress)) == 0 &&
+           memcmp(a->remoteAddress, b->remoteAddress, sizeof(a->remoteAddress)) == 0;
+}
+
+static int indexConnectionTable(ConnectionTable *table) {
+    size_t slotCount = 16;
+    while (slotCount < (size_t)table->count * 2) {
+        slotCount <<= 1;
+    }
+    
+    int *slots = malloc(slotCount * sizeof(int));
+    if (!slots) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    memset(slots, 0xFF, slotCount * sizeof(int));
+    
+    for (int i = 0; i < table->count; i++) {
+        uint32_t slot = connectionHash(&table->connections[i]) & (uint32_t)(slotCount - 1);
+        while (slots[slot] >= 0) {
+            slot = (slot + 1) & (uint32_t)(slotCount - 1);
+        }
+        slots[slot] = i;
+    }
+    
+    free(table->slots);
+    table->slots = slots;
+    table->slotMask = (int)(slotCount - 1);
+    return BRIDGE_SUCCESS;
+}
+
+static int containsConnection(const ConnectionTable *table, const SocketConnectionInfo *connection) {
+    if (!table->slots) {
+        return 0;
+    }
+    
+    uint32_t slot = connectionHash(connection) & (uint32_t)table->slotMask;
+    while (table->slots[slot] >= 0) {
+        if (sameConnection(&table->connections[table->slots[slot]], connection)) {
+            return 1;
+        }
+        slot = (slot + 1) & (uint32_t)table->slotMask;
+    }
+    return 0;
+}
+
+static void releaseConnectionTable(ConnectionTable *table) {
+    free(table->connections);
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+int getConnectionChanges(ConnectionDelta *delta) {
+    if (!delta) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    memset(delta, 0, sizeof(*delta));
+    
+    // Enumerate without holding the table lock
+    SocketSnapshot snapshot;
+    int result = getSocketConnections(&snapshot, 1);
+    if (result < 0) {
+        return result;
+    }
+    
+    ConnectionTable current = {snapshot.connections, snapshot.count, NULL, 0};
+    result = indexConnectionTable(&current);
+    if (result != BRIDGE_SUCCESS) {
+        releaseConnectionTable(&current);
+        return result;
+    }
+    
+    pthread_mutex_lock(&g_connection_table_mutex);
+    
+    ConnectionTable *previous = &g_connection_table;
+    size_t capacity = (size_t)current.count + (size_t)previous->count;
+    ConnectionChange *changes = malloc((capacity > 0 ? capacity : 1) * sizeof(ConnectionChange));
+    if (!changes) {
+        pthread_mutex_unlock(&g_connection_table_mutex);
+        releaseConnectionTable(&current);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    // Closes go first so a reused 5-tuple reads as close-then-open
+    int changeCount = 0;
+    for (int i = 0; i < previous->count; i++) {
+        if (containsConnection(&current, &previous->connections[i])) continue;
+        changes[changeCount].type = CONNECTION_CLOSED;
+        changes[changeCount].connection = previous->connections[i];
+        changeCount++;
+    }
+    
+    for (int i = 0; i < current.count; i++) {
+        if (containsConnection(previous, &current.connections[i])) continue;
+        changes[changeCount].type = CONNECTION_OPENED;
+        changes[changeCount].connection = current.connections[i];
+        changeCount++;
+    }
+    
+    releaseConnectionTable(previous);
+    *previous = current;
+    
+    pthread_mutex_unlock(&g_connection_table_mutex);
+    
+    delta->changes = changes;
+    delta->count = changeCount;
+    return changeCount;
+}
+
+void freeConnectionDelta(ConnectionDelta *delta) {
+    if (!delta) {
+        return;
+    }
+    
+    free(delta->changes);
+    memset(delta, 0, sizeof(*delta));
+}
+
+void resetConnectionChanges(void) {
+    // Every open connection is reported as opened on the next call
+    pthread_mutex_lock(&g_connection_table_mutex);
+    releaseConnectionTable(&g_connection_table);
+    pthread_mutex_unlock(&g_connection_table_mutex);
+}
+
+// MARK: - Pattern Matching
+
+static inline uint8_t foldPatternByte(uint8_t byte) {
+    return (byte >= 'A' && byte <= 'Z') ? (uint8_t)(byte + ('a' - 'A')) : byte;
+}
+
+int buildPatternAutomaton(PatternAutomaton *automaton, const char *const *patterns, int patternCount) {
+    if (!automaton || (!patterns && patternCount > 0)) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    if (patternCount < 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    memset(automaton, 0, sizeof(*automaton));
+    
+    // One transition column per distinct folded pattern byte, plus column 0
+    // for every other byte. Worst case is one state per pattern byte plus the root.
+    uint8_t *byteClasses = automaton->byteClasses;
+    int classCount = 1;
+    size_t maxStates = 1;
+    for (int i = 0; i < patternCount; i++) {
+        if (!patterns[i]) continue;
+        for (const uint8_t *byte = (const uint8_t *)patterns[i]; *byte; byte++) {
+            uint8_t folded = foldPatternByte(*byte);
+            if (byteClasses[folded] == 0) {
+                byteClasses[folded] = (uint8_t)classCount++;
+            }
+            maxStates++;
+        }
+    }
+    for (int upper = 'A'; upper <= 'Z'; upper++) {
+        byteClasses[upper] = byteClasses[foldPatternByte((uint8_t)upper)];
+    }
+    if (maxStates > INT32_MAX / (size_t)classCount) {
+        memset(automaton, 0, sizeof(*automaton));
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    int32_t *transitions = malloc(maxStates * (size_t)classCount * sizeof(int32_t));
+    int32_t *outputs = malloc(maxStates * sizeof(int32_t));
+    int32_t *outputLinks = malloc(maxStates * sizeof(int32_t));
+    int32_t *failures = malloc(maxStates * sizeof(int32_t));
+    int32_t *nextPattern = malloc((size_t)(patternCount > 0 ? patternCount : 1) * sizeof(int32_t));
+    if (!transitions || !outputs || !outputLinks || !failures || !nextPattern) {
+        free(transitions);
+        free(outputs);
+        free(outputLinks);
+        free(failures);
+        free(nextPattern);
+        memset(automaton, 0, sizeof(*automaton));
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    // All bits set = -1 for every int32_t
+    memset(transitions, 0xff, maxStates * (size_t)classCount * sizeof(int32_t));
+    memset(outputs, 0xff, maxStates * sizeof(int32_t));
+    memset(outputLinks, 0xff, maxStates * sizeof(int32_t));
+    
+    // Trie of the folded patterns
+    int stateCount = 1;
+    for (int i = 0; i < patternCount; i++) {
+        nextPattern[i] = -1;
+        const uint8_t *pattern = (const uint8_t *)patterns[i];
+        if (!pattern || !*pattern) continue;
+        
+        int state = 0;
+        for (; *pattern; pattern++) {
+            int32_t *next = &transitions[(size_t)state * (size_t)classCount + byteClasses[*pattern]];
+            if (*next < 0) {
+                *next = stateCount++;
+            }
+            state = *next;
+        }
+        
+        // Duplicates (after folding) chain off the same state
+        nextPattern[i] = outputs[state];
+        outputs[state] = i;
+    }
+    
+    // Breadth-first failure links, turning the trie into a full DFA so
+    // matching is one table load per byte
+    int32_t *queue = malloc((size_t)stateCount * sizeof(int32_t));
+    if (!queue) {
+        free(transitions);
+        free(outputs);
+        free(outputLinks);
+        free(failures);
+        free(nextPattern);
+        memset(automaton, 0, sizeof(*automaton));
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    int head = 0;
+    int tail = 0;
+    for (int c = 0; c < classCount; c++) {
+        int32_t child = transitions[c];
+        if (child < 0) {
+            transitions[c] = 0;
+        } else {
+            failures[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+    
+    while (head < tail) {
+        int32_t state = queue[head++];
+        int32_t *row = &transitions[(size_t)state * (size_t)classCount];
+        const int32_t *failureRow = &transitions[(size_t)failures[state] * (size_t)classCount];
+        
+        for (int c = 0; c < classCount; c++) {
+            int32_t child = row[c];
+            if (child < 0) {
+                row[c] = failureRow[c];
+                continue;
+            }
+            
+            int32_t failure = failureRow[c];
+            failures[child] = failure;
+            outputLinks[child] = outputs[failure] >= 0 ? failure : outputLinks[failure];
+            queue[tail++] = child;
+        }
+    }
+    
+    free(queue);
+    free(failures);
+    
+    // Give back the unused worst-case tail
+    int32_t *shrunk = realloc(transitions, (size_t)stateCount * (size_t)classCount * sizeof(int32_t));
+    
+    automaton->classCount = classCount;
+    automaton->transitions = shrunk ? shrunk : transitions;
+    automaton->outputs = outputs;
+    automaton->outputLinks = outputLinks;
+    automaton->nextPattern = nextPattern;
+    automaton->stateCount = stateCount;
+    automaton->patternCount = patternCount;
+    return BRIDGE_SUCCESS;
+}
+
+void freePatternAutomaton(PatternAutomaton *automaton) {
+    if (!automaton) {
+        return;
+    }
+    
+    free(automaton->transitions);
+    free(automaton->outputs);
+    free(automaton->outputLinks);
+    free(automaton->nextPattern);
+    memset(automaton, 0, sizeof(*automaton));
+}
+
+// Index of the first pattern to complete in text, or -1
+int findFirstPattern(const PatternAutomaton *automaton, const uint8_t *text, size_t length) {
+    if (!automaton || !automaton->transitions || !text || automaton->stateCount <= 1) {
+        return -1;
+    }
+    
+    int32_t state = 0;
+    for (size_t i = 0; i < length; i++) {
+        state = automaton->transitions[(size_t)state * (size_t)automaton->classCount + automaton->byteClasses[text[i]]];
+        if (automaton->outputs[state] >= 0) {
+            return automaton->outputs[state];
+        }
+        if (automaton->outputLinks[state] >= 0) {
+            return automaton->outputs[automaton->outputLinks[state]];
+        }
+    }
+    return -1;
+}
+
+// Distinct pattern indexes found in text, in the order they complete.
+// Stops once maxMatches are found; returns the number written.
+int findAllPatterns(const PatternAutomaton *automaton, const uint8_t *text, size_t length, int *matches, int maxMatches) {
+    if (!automaton || !automaton->transitions || !text || !matches || maxMatches <= 0 || automaton->stateCount <= 1) {
+        return 0;
+    }
+    
+    int matchCount = 0;
+    int32_t state = 0;
+    for (size_t i = 0; i < length; i++) {
+        state = automaton->transitions[(size_t)state * (size_t)automaton->classCount + automaton->byteClasses[text[i]]];
+        
+        int32_t outputState = automaton->outputs[state] >= 0 ? state : automaton->outputLinks[state];
+        for (; outputState >= 0; outputState = automaton->outputLinks[outputState]) {
+            for (int32_t pattern = automaton->outputs[outputState]; pattern >= 0; pattern = automaton->nextPattern[pattern]) {
+                int seen = 0;
+                for (int j = 0; j < matchCount; j++) {
+                    if (matches[j] == pattern) {
+                        seen = 1;
+                        break;
+                    }
+                }
+                if (seen) continue;
+                
+                matches[matchCount++] = pattern;
+                if (matchCount == maxMatches) {
+                    return matchCount;
+                }
+            }
+        }
+    }
+    return matchCount;
+}
+
+// MARK: - File Hashing
+
+static void makeHashCacheKey(const struct stat *info, HashCacheKey *key);
+static int lookupHashCache(const HashCacheKey *key, unsigned char digest[CC_SHA256_DIGEST_LENGTH]);
+static void storeHashCache(const HashCacheKey *key, const unsigned char digest[CC_SHA256_DIGEST_LENGTH]);
+
+static void formatHexDigest(const unsigned char *digest, size_t length, char *hashString) {
+    static const char hexDigits[] = "0123456789abcdef";
+    for (size_t i = 0; i < length; i++) {
+        hashString[i * 2] = hexDigits[digest[i] >> 4];
+        hashString[i * 2 + 1] = hexDigits[digest[i] & 0x0F];
+    }
+    hashString[length * 2] = '\0';
+}
+
+static void formatSHA256Digest(const unsigned char digest[CC_SHA256_DIGEST_LENGTH], char *hashString) {
+    formatHexDigest(digest, CC_SHA256_DIGEST_LENGTH, hashString);
+}
+
+// Large aligned blocks keep the number of read() calls low on multi-hundred
+// MB binaries; F_NOCACHE keeps a one-off hash from evicting the candidate's
+// page cache.
+static const size_t kHashBlockSize = 1024 * 1024;
+
+static inline uint64_t hashBudgetNow(void) {
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static int isHashBudgetExhausted(const HashBudget *budget) {
+    if (!budget) {
+        return 0;
+    }
+    if (budget->maxBytes > 0 && budget->bytesHashed >= budget->maxBytes) {
+        return 1;
+    }
+    if (budget->maxNanoseconds > 0 && hashBudgetNow() - budget->startTime >= budget->maxNanoseconds) {
+        return 1;
+    }
+    return 0;
+}
+
+static int hashFileContents(const char *filePath, uint64_t fileSize, HashBudget *budget, unsigned char digest[CC_SHA256_DIGEST_LENGTH]) {
+    // Don't start a file the remaining byte budget can't cover. A file bigger
+    // than the whole budget still gets a fresh scan to itself.
+    if (budget && budget->maxBytes > 0 && budget->bytesHashed > 0 &&
+        budget->bytesHashed + fileSize > budget->maxBytes) {
+        budget->filesDeferred++;
+        return BRIDGE_ERROR_BUDGET_EXHAUSTED;
+    }
+    
+    // Likewise the first file read in a pass always runs to the end, or a
+    // binary slower to read than the time budget would restart every pass
+    int isFirstFile = budget && budget->bytesHashed == 0;
+    
+    int fd = open(filePath, O_RDONLY);
+    if (fd < 0) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    fcntl(fd, F_NOCACHE, 1);
+    fcntl(fd, F_RDAHEAD, 1);
+    
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, 4096, kHashBlockSize) != 0) {
+        close(fd);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    CC_SHA256_CTX sha256Context;
+    if (CC_SHA256_Init(&sha256Context) == 0) {
+        free(buffer);
+        close(fd);
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    int result = BRIDGE_SUCCESS;
+    uint64_t totalRead = 0;
+    for (;;) {
+        ssize_t bytesRead = read(fd, buffer, kHashBlockSize);
+        if (bytesRead < 0) {
+            if (errno == EINTR) continue;
+            result = BRIDGE_ERROR_FILE_ACCESS;
+            break;
+        }
+        if (bytesRead == 0) break;
+        totalRead += (uint64_t)bytesRead;
+        
+        if (CC_SHA256_Update(&sha256Context, buffer, (CC_LONG)bytesRead) == 0) {
+            result = BRIDGE_ERROR_SYSTEM_CALL;
+            break;
+        }
+        
+        if (budget) {
+            budget->bytesHashed += (uint64_t)bytesRead;
+            
+            // A slow disk can still blow the time budget mid-file
+            if (!isFirstFile && budget->maxNanoseconds > 0 && hashBudgetNow() - budget->startTime >= budget->maxNanoseconds) {
+                budget->filesDeferred++;
+                result = BRIDGE_ERROR_BUDGET_EXHAUSTED;
+                break;
+            }
+        }
+    }
+    
+    free(buffer);
+    close(fd);
+    
+    countMetric(&g_metrics.filesHashed, 1);
+    countMetric(&g_metrics.bytesHashed, totalRead);
+    
+    if (result != BRIDGE_SUCCESS) {
+        return result;
+    }
+    
+    if (CC_SHA256_Final(digest, &sha256Context) == 0) {
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    return BRIDGE_SUCCESS;
+}
+
+void beginHashBudget(HashBudget *budget, uint64_t maxBytes, uint64_t maxMilliseconds) {
+    if (!budget) {
+        return;
+    }
+    
+    memset(budget, 0, sizeof(*budget));
+    budget->maxBytes = maxBytes;
+    budget->maxNanoseconds = maxMilliseconds * 1000000ull;
+    budget->startTime = hashBudgetNow();
+}
+
+int calculateFileSHA256(const char *filePath, char *hashString, size_t hashStringSize) {
+    return calculateFileSHA256WithBudget(filePath, hashString, hashStringSize, NULL);
+}
+
+// Identifies the file to hash without reading it. A bundle directory stands
+// for its main executable, whose path is written to executablePath.
+static int statHashTarget(const char **filePath, char executablePath[PROC_PIDPATHINFO_MAXSIZE], struct stat *info) {
+    if (stat(*filePath, info) != 0) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    if (S_ISDIR(info->st_mode)) {
+        if (resolveBundleExecutable(*filePath, executablePath, PROC_PIDPATHINFO_MAXSIZE) != BRIDGE_SUCCESS ||
+            stat(executablePath, info) != 0) {
+            return BRIDGE_ERROR_FILE_ACCESS;
+        }
+        *filePath = executablePath;
+    }
+    
+    if (!S_ISREG(info->st_mode)) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    return BRIDGE_SUCCESS;
+}
+
+int calculateFileSHA256Uncached(const char *filePath, char *hashString, size_t hashStringSize) {
+    if (!filePath || !hashString) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    if (hashStringSize < 65 || strlen(filePath) == 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    struct stat info;
+    char executablePath[PROC_PIDPATHINFO_MAXSIZE];
+    int result = statHashTarget(&filePath, executablePath, &info);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
+    }
+    
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    result = hashFileContents(filePath, (uint64_t)info.st_size, NULL, digest);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
+    }
+    
+    formatSHA256Digest(digest, hashString);
+    return BRIDGE_SUCCESS;
+}
+
+int calculateFileSHA256WithBudget(const char *filePath, char *hashString, size_t hashStringSize, HashBudget *budget) {
+    if (!filePath || !hashString) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    if (hashStringSize < 65) {
+        return BRIDGE_ERROR_INVALID_PARAMETER; // Need at least 65 bytes for SHA256 hex string + null terminator
+    }
+    
+    if (strlen(filePath) == 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    struct stat before;
+    char executablePath[PROC_PIDPATHINFO_MAXSIZE];
+    int targetResult = statHashTarget(&filePath, executablePath, &before);
+    if (targetResult != BRIDGE_SUCCESS) {
+        return targetResult;
+    }
+    
+    HashCacheKey key;
+    makeHashCacheKey(&before, &key);
+    
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    if (lookupHashCache(&key, digest)) {
+        countMetric(&g_metrics.hashCacheHits, 1);
+        formatSHA256Digest(digest, hashString);
+        return BRIDGE_SUCCESS;
+    }
+    countMetric(&g_metrics.hashCacheMisses, 1);
+    
+    // Cache hits are free; only real reads count against the budget
+    if (isHashBudgetExhausted(budget)) {
+        budget->filesDeferred++;
+        return BRIDGE_ERROR_BUDGET_EXHAUSTED;
+    }
+    
+    os_log_t log = signpostLog();
+    os_signpost_id_t signpost = os_signpost_id_generate(log);
+    os_signpost_interval_begin(log, signpost, "HashFile", "%llu bytes", (unsigned long long)before.st_size);
+    uint64_t hashStart = metricsNow();
+    
+    int result = hashFileContents(filePath, (uint64_t)before.st_size, budget, digest);
+    
+    countMetric(&g_metrics.hashNanoseconds, metricsNow() - hashStart);
+    os_signpost_interval_end(log, signpost, "HashFile", "result %d", result);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
+    }
+    
+    // Only cache if the file didn't change while it was being read
+    struct stat after;
+    if (stat(filePath, &after) == 0) {
+        HashCacheKey afterKey;
+        makeHashCacheKey(&after, &afterKey);
+        if (memcmp(&key, &afterKey, sizeof(key)) == 0) {
+            storeHashCache(&key, digest);
+        }
+    }
+    
+    formatSHA256Digest(digest, hashString);
+    return BRIDGE_SUCCESS;
+}
+
+// MARK: - Bundle & Mach-O Identity
+
+int resolveBundleExecutable(const char *bundlePath, char *executablePath, size_t executablePathSize) {
+    if (!bundlePath || !executablePath || executablePathSize == 0) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    CFURLRef bundleURL = CFURLCreateFromFileSystemRepresentation(kCFAllocatorDefault, (const UInt8 *)bundlePath, (CFIndex)strlen(bundlePath), true);
+    if (!bundleURL) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    CFBundleRef bundle = CFBundleCreate(kCFAllocatorDefault, bundleURL);
+    CFRelease(bundleURL);
+    if (!bundle) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    CFURLRef executableURL = CFBundleCopyExecutableURL(bundle);
+    CFRelease(bundle);
+    if (!executableURL) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    Boolean resolved = CFURLGetFileSystemRepresentation(executableURL, true, (UInt8 *)executablePath, (CFIndex)executablePathSize);
+    CFRelease(executableURL);
+    return resolved ? BRIDGE_SUCCESS : BRIDGE_ERROR_INVALID_PARAMETER;
+}
+
+// Code signature blobs (big-endian on disk), see xnu's cs_blobs.h
+#define CS_MAGIC_EMBEDDED_SIGNATURE 0xfade0cc0
+#define CS_MAGIC_CODEDIRECTORY 0xfade0c02
+#define CS_SLOT_CODEDIRECTORY 0x0000
+#define CS_SLOT_ALTERNATE_CODEDIRECTORIES 0x1000
+#define CS_SLOT_ALTERNATE_CODEDIRECTORY_MAX 5
+#define CS_HASHTYPE_SHA1 1
+#define CS_HASHTYPE_SHA256 2
+#define CS_CDHASH_LENGTH 20
+
+typedef struct {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t count;
+} CSSuperBlobHeader;
+
+typedef struct {
+    uint32_t type;
+    uint32_t offset;
+} CSBlobIndex;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t hashOffset;
+    uint32_t identOffset;
+    uint32_t nSpecialSlots;
+    uint32_t nCodeSlots;
+    uint32_t codeLimit;
+    uint8_t hashSize;
+    uint8_t hashType;
+    uint8_t platform;
+    uint8_t pageSize;
+    uint32_t spare2;
+} CSCodeDirectoryHeader;
+
+// Upper bound on signature metadata we're willing to read (the code directory
+// holds one hash per 4 KB page, so even very large binaries stay well below)
+static const uint32_t kMaxCodeDirectorySize = 16 * 1024 * 1024;
+
+static int readFully(int fd, void *buffer, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t bytesRead = pread(fd, (char *)buffer + done, size - done, offset + (off_t)done);
+        if (bytesRead < 0) {
+            if (errno == EINTR) continue;
+            return BRIDGE_ERROR_FILE_ACCESS;
+        }
+        if (bytesRead == 0) {
+            return BRIDGE_ERROR_FILE_ACCESS;
+        }
+        done += (size_t)bytesRead;
+    }
+    return BRIDGE_SUCCESS;
+}
+
+// Finds the 64-bit Mach-O slice for the host architecture
+static int findHostSliceOffset(int fd, off_t *sliceOffset) {
+#if defined(__arm64__) || defined(__aarch64__)
+    const cpu_type_t hostCPU = CPU_TYPE_ARM64;
+#else
+    const cpu_type_t hostCPU = CPU_TYPE_X86_64;
+#endif
+    
+    uint32_t magic;
+    if (readFully(fd, &magic, sizeof(magic), 0) != BRIDGE_SUCCESS) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    if (magic == MH_MAGIC_64) {
+        *sliceOffset = 0;
+        return BRIDGE_SUCCESS;
+    }
+    
+    if (magic != FAT_CIGAM && magic != FAT_CIGAM_64) {
+        return BRIDGE_ERROR_INVALID_PARAMETER; // Not a (little-endian 64-bit) Mach-O
+    }
+    
+    struct fat_header fatHeader;
+    if (readFully(fd, &fatHeader, sizeof(fatHeader), 0) != BRIDGE_SUCCESS) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    uint32_t archCount = OSSwapBigToHostInt32(fatHeader.nfat_arch);
+    int isFat64 = (magic == FAT_CIGAM_64);
+    size_t archSize = isFat64 ? sizeof(struct fat_arch_64) : sizeof(struct fat_arch);
+    
+    for (uint32_t i = 0; i < archCount && i < 16; i++) {
+        off_t archOffset = (off_t)(sizeof(fatHeader) + i * archSize);
+        if (isFat64) {
+            struct fat_arch_64 arch;
+            if (readFully(fd, &arch, sizeof(arch), archOffset) != BRIDGE_SUCCESS) break;
+            if ((cpu_type_t)OSSwapBigToHostInt32((uint32_t)arch.cputype) == hostCPU) {
+                *sliceOffset = (off_t)OSSwapBigToHostInt64(arch.offset);
+                return BRIDGE_SUCCESS;
+            }
+        } else {
+            struct fat_arch arch;
+            if (readFully(fd, &arch, sizeof(arch), archOffset) != BRIDGE_SUCCESS) break;
+            if ((cpu_type_t)OSSwapBigToHostInt32((uint32_t)arch.cputype) == hostCPU) {
+                *sliceOffset = (off_t)OSSwapBigToHostInt32(arch.offset);
+                return BRIDGE_SUCCESS;
+            }
+        }
+    }
+    
+    return BRIDGE_ERROR_INVALID_PARAMETER;
+}
+
+// Locates LC_CODE_SIGNATURE in the slice and returns its file range
+static int findCodeSignature(int fd, off_t sliceOffset, off_t *signatureOffset, uint32_t *signatureSize) {
+    struct mach_header_64 header;
+    if (readFully(fd, &header, sizeof(header), sliceOffset) != BRIDGE_SUCCESS) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    if (header.magic != MH_MAGIC_64 || header.sizeofcmds == 0 || header.sizeofcmds > 1024 * 1024) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    unsigned char *commands = malloc(header.sizeofcmds);
+    if (!commands) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    if (readFully(fd, commands, header.sizeofcmds, sliceOffset + (off_t)sizeof(header)) != BRIDGE_SUCCESS) {
+        free(commands);
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    int result = BRIDGE_ERROR_INVALID_PARAMETER; // Unsigned
+    uint32_t position = 0;
+    for (uint32_t i = 0; i < header.ncmds && position + sizeof(struct load_command) <= header.sizeofcmds; i++) {
+        const struct load_command *command = (const struct load_command *)(commands + position);
+        if (command->cmdsize < sizeof(struct load_command) || position + command->cmdsize > header.sizeofcmds) {
+            break;
+        }
+        
+        if (command->cmd == LC_CODE_SIGNATURE && command->cmdsize >= sizeof(struct linkedit_data_command)) {
+            const struct linkedit_data_command *signature = (const struct linkedit_data_command *)command;
+            *signatureOffset = sliceOffset + (off_t)signature->dataoff;
+            *signatureSize = signature->datasize;
+            result = BRIDGE_SUCCESS;
+            break;
+        }
+        position += command->cmdsize;
+    }
+    
+    free(commands);
+    return result;
+}
+
+int getExecutableCDHash(const char *filePath, char *hashString, size_t hashStringSize) {
+    if (!filePath || !hashString) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    if (hashStringSize < CS_CDHASH_LENGTH * 2 + 1) {
+        return BRIDGE_ERROR_INVALID_PARAMETER; // Need 41 bytes for the 20-byte CDHash in hex
+    }
+    
+    char executablePath[PROC_PIDPATHINFO_MAXSIZE];
+    struct stat info;
+    if (stat(filePath, &info) != 0) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        if (resolveBundleExecutable(filePath, executablePath, sizeof(executablePath)) != BRIDGE_SUCCESS) {
+            return BRIDGE_ERROR_FILE_ACCESS;
+        }
+        filePath = executablePath;
+    }
+    
+    int fd = open(filePath, O_RDONLY);
+    if (fd < 0) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    off_t sliceOffset = 0;
+    off_t signatureOffset = 0;
+    uint32_t signatureSize = 0;
+    int result = findHostSliceOffset(fd, &sliceOffset);
+    if (result == BRIDGE_SUCCESS) {
+        result = findCodeSignature(fd, sliceOffset, &signatureOffset, &signatureSize);
+    }
+    
+    // Read the blob index, then only the code directory we want
+    CSSuperBlobHeader superBlob;
+    if (result == BRIDGE_SUCCESS) {
+        result = readFully(fd, &superBlob, sizeof(superBlob), signatureOffset);
+    }
+    if (result == BRIDGE_SUCCESS && OSSwapBigToHostInt32(superBlob.magic) != CS_MAGIC_EMBEDDED_SIGNATURE) {
+        result = BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    uint32_t bestOffset = 0;
+    uint8_t bestHashType = 0;
+    if (result == BRIDGE_SUCCESS) {
+        uint32_t blobCount = OSSwapBigToHostInt32(superBlob.count);
+        for (uint32_t i = 0; i < blobCount && i < 32; i++) {
+            CSBlobIndex index;
+            if (readFully(fd, &index, sizeof(index), signatureOffset + (off_t)(sizeof(superBlob) + i * sizeof(index))) != BRIDGE_SUCCESS) {
+                break;
+            }
+            
+            uint32_t type = OSSwapBigToHostInt32(index.type);
+            if (type != CS_SLOT_CODEDIRECTORY &&
+                (type < CS_SLOT_ALTERNATE_CODEDIRECTORIES || type >= CS_SLOT_ALTERNATE_CODEDIRECTORIES + CS_SLOT_ALTERNATE_CODEDIRECTORY_MAX)) {
+                continue;
+            }
+            
+            uint32_t offset = OSSwapBigToHostInt32(index.offset);
+            CSCodeDirectoryHeader directory;
+            if (offset >= signatureSize ||
+                readFully(fd, &directory, sizeof(directory), signatureOffset + (off_t)offset) != BRIDGE_SUCCESS ||
+                OSSwapBigToHostInt32(directory.magic) != CS_MAGIC_CODEDIRECTORY) {
+                continue;
+            }
+            
+            // Prefer SHA-256 directories, as the kernel does
+            if (bestOffset == 0 || (directory.hashType == CS_HASHTYPE_SHA256 && bestHashType != CS_HASHTYPE_SHA256)) {
+                bestOffset = offset;
+                bestHashType = directory.hashType;
+            }
+        }
+        if (bestOffset == 0) {
+            result = BRIDGE_ERROR_INVALID_PARAMETER;
+        }
+    }
+    
+    unsigned char *directoryBytes = NULL;
+    uint32_t directoryLength = 0;
+    if (result == BRIDGE_SUCCESS) {
+        CSCodeDirectoryHeader directory;
+        result = readFully(fd, &directory, sizeof(directory), signatureOffset + (off_t)bestOffset);
+        directoryLength = OSSwapBigToHostInt32(directory.length);
+        if (result == BRIDGE_SUCCESS &&
+            (directoryLength < sizeof(directory) || directoryLength > kMaxCodeDirectorySize ||
+             bestOffset + directoryLength > signatureSize)) {
+            result = BRIDGE_ERROR_INVALID_PARAMETER;
+        }
+    }
+    if (result == BRIDGE_SUCCESS) {
+        directoryBytes = malloc(directoryLength);
+        result = directoryBytes ? readFully(fd, directoryBytes, directoryLength, signatureOffset + (off_t)bestOffset) : BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    close(fd);
+    
+    if (result != BRIDGE_SUCCESS) {
+        free(directoryBytes);
+        return result;
+    }
+    
+    // The CDHash is the directory's digest (in its own hash type), truncated to 20 bytes
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    if (bestHashType == CS_HASHTYPE_SHA1) {
+        CC_SHA1(directoryBytes, (CC_LONG)directoryLength, digest);
+    } else {
+        CC_SHA256(directoryBytes, (CC_LONG)directoryLength, digest);
+    }
+    free(directoryBytes);
+    
+    formatHexDigest(digest, CS_CDHASH_LENGTH, hashString);
+    return BRIDGE_SUCCESS;
+}
+
+// MARK: - Running Process Identity
+
+// Private libsystem call behind SecCode's dynamic checks (xnu's codesign.h)
+extern int csops(pid_t pid, unsigned int ops, void *useraddr, size_t usersize);
+
+#define CS_OPS_STATUS 0
+#define CS_OPS_CDHASH 5
+#define CS_OPS_IDENTITY 11
+#define CS_OPS_TEAMID 14
+#define CS_VALID 0x00000001
+#define CS_PLATFORM_BINARY 0x04000000
+
+// Identity and team ID come back as a blob: 8-byte {magic, length} header
+// followed by a null-terminated string
+static void copyCodeSigningString(pid_t pid, unsigned int op, char *out, size_t outSize) {
+    unsigned char blob[8 + 256];
+    out[0] = '\0';
+    
+    memset(blob, 0, sizeof(blob));
+    if (csops(pid, op, blob, sizeof(blob) - 1) != 0) {
+        return;
+    }
+    
+    uint32_t length;
+    memcpy(&length, blob + 4, sizeof(length));
+    length = OSSwapBigToHostInt32(length);
+    if (length <= 8 || length > sizeof(blob) - 1) {
+        return;
+    }
+    
+    strlcpy(out, (const char *)(blob + 8), outSize);
+}
+
+int getProcessCodeIdentity(pid_t pid, CodeSigningIdentity *identity) {
+    if (!identity) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    if (pid <= 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    memset(identity, 0, sizeof(CodeSigningIdentity));
+    
+    uint32_t flags = 0;
+    if (csops(pid, CS_OPS_STATUS, &flags, sizeof(flags)) != 0) {
+        return errno == ESRCH ? BRIDGE_ERROR_INVALID_PARAMETER : BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    
+    identity->flags = flags;
+    identity->isSigned = (flags & CS_VALID) != 0;
+    identity->isPlatformBinary = (flags & CS_PLATFORM_BINARY) != 0;
+    
+    // Unsigned or invalidated processes have no identity worth reporting
+    if (!identity->isSigned) {
+        return BRIDGE_SUCCESS;
+    }
+    
+    unsigned char cdHash[CS_CDHASH_LENGTH];
+    if (csops(pid, CS_OPS_CDHASH, cdHash, sizeof(cdHash)) == 0) {
+        formatHexDigest(cdHash, CS_CDHASH_LENGTH, identity->cdHash);
+    }
+    
+    copyCodeSigningString(pid, CS_OPS_IDENTITY, identity->signingIdentifier, sizeof(identity->signingIdentifier));
+    copyCodeSigningString(pid, CS_OPS_TEAMID, identity->teamIdentifier, sizeof(identity->teamIdentifier));
+    return BRIDGE_SUCCESS;
+}
+
+// MARK: - Hash Cache
+
+// Entries are keyed by file identity and change stamps, so an unchanged
+// binary is hashed once per session (or once ever, when persisted).
+typedef struct {
+    HashCacheKey key;
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    int isUsed;
+} HashCacheEntry;
+
+static pthread_mutex_t g_hash_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static HashCacheEntry *g_hash_cache = NULL;
+static uint32_t g_hash_cache_slot_mask = 0;
+static uint32_t g_hash_cache_count = 0;
+
+static const uint32_t kHashCacheInitialSlots = 1024;
+static const uint32_t kHashCacheMaxEntries = 8192;
+
+// On-disk format: header, `count` fixed-size records, then an HMAC-SHA256 of
+// both. The file sits in a directory the user can write, and an edited record
+// could map a known binary's identity to a harmless digest, so nothing is
+// loaded unless the MAC matches.
+static const uint32_t kHashCacheFileMagic = 0x43485254; // "TRHC"
+static const uint32_t kHashCacheFileVersion = 2;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+} HashCacheFileHeader;
+
+typedef struct {
+    HashCacheKey key;
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+} HashCacheFileRecord;
+
+static void makeHashCacheKey(const struct stat *info, HashCacheKey *key) {
+    memset(key, 0, sizeof(*key));
+    key->device = (uint64_t)info->st_dev;
+    key->inode = (uint64_t)info->st_ino;
+    key->size = (uint64_t)info->st_size;
+    key->modifiedSeconds = (int64_t)info->st_mtimespec.tv_sec;
+    key->modifiedNanoseconds = (int64_t)info->st_mtimespec.tv_nsec;
+    key->changedSeconds = (int64_t)info->st_ctimespec.tv_sec;
+    key->changedNanoseconds = (int64_t)info->st_ctimespec.tv_nsec;
+}
+
+static inline uint32_t hashCacheSlot(const HashCacheKey *key, uint32_t slotMask) {
+    uint64_t hash = key->inode * 0x9E3779B97F4A7C15ull;
+    hash ^= key->device + (hash << 6) + (hash >> 2);
+    hash ^= key->size + (uint64_t)key->modifiedSeconds * 31u;
+    return (uint32_t)(hash ^ (hash >> 32)) & slotMask;
+}
+
+// Caller holds g_hash_cache_mutex
+static int resizeHashCache(uint32_t slotCount) {
+    HashCacheEntry *table = calloc(slotCount, sizeof(HashCacheEntry));
+    if (!table) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    if (g_hash_cache) {
+        for (uint32_t i = 0; i <= g_hash_cache_slot_mask; i++) {
+            if (!g_hash_cache[i].isUsed) continue;
+            
+            uint32_t slot = hashCacheSlot(&g_hash_cache[i].key, slotCount - 1);
+            while (table[slot].isUsed) {
+                slot = (slot + 1) & (slotCount - 1);
+            }
+            table[slot] = g_hash_cache[i];
+        }
+        free(g_hash_cache);
+    }
+    
+    g_hash_cache = table;
+    g_hash_cache_slot_mask = slotCount - 1;
+    return BRIDGE_SUCCESS;
+}
+
+// Caller holds g_hash_cache_mutex
+static void insertHashCacheLocked(const HashCacheKey *key, const unsigned char digest[CC_SHA256_DIGEST_LENGTH]) {
+    if (!g_hash_cache && resizeHashCache(kHashCacheInitialSlots) != BRIDGE_SUCCESS) {
+        return;
+    }
+    
+    uint32_t slot = hashCacheSlot(key, g_hash_cache_slot_mask);
+    while (g_hash_cache[slot].isUsed) {
+        if (memcmp(&g_hash_cache[slot].key, key, sizeof(*key)) == 0) {
+            memcpy(g_hash_cache[slot].digest, digest, CC_SHA256_DIGEST_LENGTH);
+            return;
+        }
+        slot = (slot + 1) & g_hash_cache_slot_mask;
+    }
+    
+    // Bound memory and the persisted file; a full cache starts over
+    if (g_hash_cache_count >= kHashCacheMaxEntries) {
+        memset(g_hash_cache, 0, (g_hash_cache_slot_mask + 1) * sizeof(HashCacheEntry));
+        g_hash_cache_count = 0;
+        slot = hashCacheSlot(key, g_hash_cache_slot_mask);
+    }
+    
+    g_hash_cache[slot].key = *key;
+    memcpy(g_hash_cache[slot].digest, digest, CC_SHA256_DIGEST_LENGTH);
+    g_hash_cache[slot].isUsed = 1;
+    g_hash_cache_count++;
+    
+    // Keep the table at most half full
+    if (g_hash_cache_count * 2 > g_hash_cache_slot_mask + 1) {
+        resizeHashCache((g_hash_cache_slot_mask + 1) * 2);
+    }
+}
+
+static int lookupHashCache(const HashCacheKey *key, unsigned char digest[CC_SHA256_DIGEST_LENGTH]) {
+    int found = 0;
+    pthread_mutex_lock(&g_hash_cache_mutex);
+    
+    if (g_hash_cache) {
+        uint32_t slot = hashCacheSlot(key, g_hash_cache_slot_mask);
+        while (g_hash_cache[slot].isUsed) {
+            if (memcmp(&g_hash_cache[slot].key, key, sizeof(*key)) == 0) {
+                memcpy(digest, g_hash_cache[slot].digest, CC_SHA256_DIGEST_LENGTH);
+                found = 1;
+                break;
+            }
+            slot = (slot + 1) & g_hash_cache_slot_mask;
+        }
+    }
+    
+    pthread_mutex_unlock(&g_hash_cache_mutex);
+    return found;
+}
+
+static void storeHashCache(const HashCacheKey *key, const unsigned char digest[CC_SHA256_DIGEST_LENGTH]) {
+    pthread_mutex_lock(&g_hash_cache_mutex);
+    insertHashCacheLocked(key, digest);
+    pthread_mutex_unlock(&g_hash_cache_mutex);
+}
+
+// Constant time, so a forged MAC can't be found byte by byte
+static int macsEqual(const unsigned char *a, const unsigned char *b, size_t length) {
+    unsigned char difference = 0;
+    for (size_t i = 0; i < length; i++) {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
+
+int loadHashCache(const char *filePath, const uint8_t *key, size_t keyLength) {
+    if (!filePath || !key || keyLength == 0) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    FILE *file = fopen(filePath, "rb");
+    if (!file) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    HashCacheFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != kHashCacheFileMagic ||
+        header.version != kHashCacheFileVersion ||
+        header.count > kHashCacheMaxEntries) {
+        fclose(file);
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    // Records are only inserted after the whole file has been authenticated
+    HashCacheFileRecord *records = malloc((size_t)(header.count > 0 ? header.count : 1) * sizeof(HashCacheFileRecord));
+    if (!records) {
+        fclose(file);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    unsigned char storedMac[CC_SHA256_DIGEST_LENGTH];
+    int complete = fread(records, sizeof(HashCacheFileRecord), header.count, file) == header.count &&
+                   fread(storedMac, sizeof(storedMac), 1, file) == 1;
+    fclose(file);
+    if (!complete) {
+        free(records);
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    unsigned char mac[CC_SHA256_DIGEST_LENGTH];
+    CCHmacContext hmac;
+    CCHmacInit(&hmac, kCCHmacAlgSHA256, key, keyLength);
+    CCHmacUpdate(&hmac, &header, sizeof(header));
+    CCHmacUpdate(&hmac, records, header.count * sizeof(HashCacheFileRecord));
+    CCHmacFinal(&hmac, mac);
+    if (!macsEqual(mac, storedMac, sizeof(mac))) {
+        free(records);
+        return BRIDGE_ERROR_AUTHENTICATION;
+    }
+    
+    pthread_mutex_lock(&g_hash_cache_mutex);
+    for (uint32_t i = 0; i < header.count; i++) {
+        insertHashCacheLocked(&records[i].key, records[i].digest);
+    }
+    pthread_mutex_unlock(&g_hash_cache_mutex);
+    
+    free(records);
+    return (int)header.count;
+}
+
+int saveHashCache(const char *filePath, const uint8_t *key, size_t keyLength) {
+    if (!filePath || !key || keyLength == 0) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    // Write to a temporary file and rename so a crash never leaves a torn cache
+    char tempPath[PROC_PIDPATHINFO_MAXSIZE];
+    if (snprintf(tempPath, sizeof(tempPath), "%s.tmp", filePath) >= (int)sizeof(tempPath)) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    FILE *file = fopen(tempPath, "wb");
+    if (!file) {
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    pthread_mutex_lock(&g_hash_cache_mutex);
+    
+    HashCacheFileHeader header = { kHashCacheFileMagic, kHashCacheFileVersion, g_hash_cache_count, 0 };
+    int ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+    
+    CCHmacContext hmac;
+    CCHmacInit(&hmac, kCCHmacAlgSHA256, key, keyLength);
+    CCHmacUpdate(&hmac, &header, sizeof(header));
+    
+    if (g_hash_cache) {
+        for (uint32_t i = 0; ok && i <= g_hash_cache_slot_mask; i++) {
+            if (!g_hash_cache[i].isUsed) continue;
+            
+            HashCacheFileRecord record;
+            memset(&record, 0, sizeof(record));
+            record.key = g_hash_cache[i].key;
+            memcpy(record.digest, g_hash_cache[i].digest, CC_SHA256_DIGEST_LENGTH);
+            CCHmacUpdate(&hmac, &record, sizeof(record));
+            ok = (fwrite(&record, sizeof(record), 1, file) == 1);
+        }
+    }
+    
+    int saved = (int)g_hash_cache_count;
+    pthread_mutex_unlock(&g_hash_cache_mutex);
+    
+    unsigned char mac[CC_SHA256_DIGEST_LENGTH];
+    CCHmacFinal(&hmac, mac);
+    ok = ok && (fwrite(mac, sizeof(mac), 1, file) == 1);
+    
+    if (fclose(file) != 0 || !ok || rename(tempPath, filePath) != 0) {
+        unlink(tempPath);
+        return BRIDGE_ERROR_FILE_ACCESS;
+    }
+    
+    return saved;
+}
+
+void clearHashCache(void) {
+    pthread_mutex_lock(&g_hash_cache_mutex);
+    free(g_hash_cache);
+    g_hash_cache = NULL;
+    g_hash_cache_slot_mask = 0;
+    g_hash_cache_count = 0;
+    pthread_mutex_unlock(&g_hash_cache_mutex);
+}
+
+// MARK: - Hash Worker Pool
+
+// Paths are hashed on a few background threads so one large binary can't hold
+// up the rest of a scan. A path that is already queued or being hashed picks
+// up the new caller as an extra waiter instead of being hashed twice.
+typedef struct HashWaiter {
+    HashResultCallback callback;
+    void *context;
+    struct HashWaiter *next;
+} HashWaiter;
+
+typedef struct {
+    char *filePath;
+    HashWaiter *waiters;
+} HashJob;
+
+static pthread_mutex_t g_hash_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_hash_pool_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *g_hash_workers = NULL;
+static int g_hash_worker_count = 0;
+static int g_hash_pool_stopping = 0;
+
+static HashJob **g_hash_queue = NULL;       // ring buffer of pending jobs
+static int g_hash_queue_capacity = 0;
+static int g_hash_queue_head = 0;
+static int g_hash_queue_count = 0;
+static HashJob **g_hash_in_flight = NULL;   // one slot per worker
+
+static const int kHashWorkerMax = 4;
+
+static void completeHashJob(HashJob *job, int result, const char *hashString) {
+    HashWaiter *waiter = job->waiters;
+    while (waiter) {
+        HashWaiter *next = waiter->next;
+        waiter->callback(job->filePath, result, hashString, waiter->context);
+        free(waiter);
+        waiter = next;
+    }
+    
+    free(job->filePath);
+    free(job);
+}
+
+// Caller holds g_hash_pool_mutex
+static HashJob *findPendingHashJob(const char *filePath) {
+    for (int i = 0; i < g_hash_queue_count; i++) {
+        HashJob *job = g_hash_queue[(g_hash_queue_head + i) % g_hash_queue_capacity];
+        if (strcmp(job->filePath, filePath) == 0) {
+            return job;
+        }
+    }
+    for (int i = 0; i < g_hash_worker_count; i++) {
+        HashJob *job = g_hash_in_flight[i];
+        if (job && strcmp(job->filePath, filePath) == 0) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static void *hashWorkerThread(void *arg) {
+    int workerIndex = (int)(intptr_t)arg;
+    
+    pthread_mutex_lock(&g_hash_pool_mutex);
+    for (;;) {
+        while (g_hash_queue_count == 0 && !g_hash_pool_stopping) {
+            pthread_cond_wait(&g_hash_pool_cond, &g_hash_pool_mutex);
+        }
+        if (g_hash_pool_stopping) break;
+        
+        HashJob *job = g_hash_queue[g_hash_queue_head];
+        g_hash_queue_head = (g_hash_queue_head + 1) % g_hash_queue_capacity;
+        g_hash_queue_count--;
+        g_hash_in_flight[workerIndex] = job;
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        
+        char hashString[CC_SHA256_DIGEST_LENGTH * 2 + 1];
+        int result = calculateFileSHA256(job->filePath, hashString, sizeof(hashString));
+        
+        // Detach before calling back so late submitters start a new (cached) job
+        pthread_mutex_lock(&g_hash_pool_mutex);
+        g_hash_in_flight[workerIndex] = NULL;
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        
+        completeHashJob(job, result, result == BRIDGE_SUCCESS ? hashString : NULL);
+        
+        pthread_mutex_lock(&g_hash_pool_mutex);
+    }
+    pthread_mutex_unlock(&g_hash_pool_mutex);
+    return NULL;
+}
+
+int startHashWorkers(int workerCount, int queueCapacity) {
+    if (queueCapacity <= 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    if (workerCount <= 0) {
+        long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+        workerCount = cpuCount > 1 ? (int)(cpuCount / 2) : 1;
+    }
+    if (workerCount > kHashWorkerMax) {
+        workerCount = kHashWorkerMax;
+    }
+    
+    pthread_mutex_lock(&g_hash_pool_mutex);
+    
+    if (g_hash_workers) {
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        return BRIDGE_ERROR_INVALID_PARAMETER; // Already running
+    }
+    
+    g_hash_queue = calloc((size_t)queueCapacity, sizeof(HashJob *));
+    g_hash_in_flight = calloc((size_t)workerCount, sizeof(HashJob *));
+    g_hash_workers = calloc((size_t)workerCount, sizeof(pthread_t));
+    if (!g_hash_queue || !g_hash_in_flight || !g_hash_workers) {
+        free(g_hash_queue);
+        free(g_hash_in_flight);
+        free(g_hash_workers);
+        g_hash_queue = NULL;
+        g_hash_in_flight = NULL;
+        g_hash_workers = NULL;
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    g_hash_queue_capacity = queueCapacity;
+    g_hash_queue_head = 0;
+    g_hash_queue_count = 0;
+    g_hash_pool_stopping = 0;
+    g_hash_worker_count = 0;
+    
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&g_hash_workers[i], NULL, hashWorkerThread, (void *)(intptr_t)i) != 0) {
+            break;
+        }
+        g_hash_worker_count++;
+    }
+    
+    int started = g_hash_worker_count;
+    pthread_mutex_unlock(&g_hash_pool_mutex);
+    
+    if (started == 0) {
+        stopHashWorkers();
+        return BRIDGE_ERROR_SYSTEM_CALL;
+    }
+    return started;
+}
+
+void stopHashWorkers(void) {
+    pthread_mutex_lock(&g_hash_pool_mutex);
+    
+    if (!g_hash_workers || g_hash_pool_stopping) {
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        return;
+    }
+    
+    g_hash_pool_stopping = 1;
+    pthread_cond_broadcast(&g_hash_pool_cond);
+    
+    pthread_t *workers = g_hash_workers;
+    int workerCount = g_hash_worker_count;
+    pthread_mutex_unlock(&g_hash_pool_mutex);
+    
+    // In-flight jobs finish and call back normally
+    for (int i = 0; i < workerCount; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    
+    pthread_mutex_lock(&g_hash_pool_mutex);
+    
+    // Unqueue leftovers; they are cancelled once the lock is released
+    HashJob **queue = g_hash_queue;
+    int queueCapacity = g_hash_queue_capacity;
+    int queueHead = g_hash_queue_head;
+    int queueCount = g_hash_queue_count;
+    g_hash_queue_count = 0;
+    
+    free(g_hash_in_flight);
+    free(g_hash_workers);
+    g_hash_queue = NULL;
+    g_hash_in_flight = NULL;
+    g_hash_workers = NULL;
+    g_hash_queue_capacity = 0;
+    g_hash_worker_count = 0;
+    g_hash_pool_stopping = 0;
+    
+    pthread_mutex_unlock(&g_hash_pool_mutex);
+    
+    // Every waiter hears back exactly once, so callers can release contexts
+    for (int i = 0; i < queueCount; i++) {
+        completeHashJob(queue[(queueHead + i) % queueCapacity], BRIDGE_ERROR_CANCELLED, NULL);
+    }
+    free(queue);
+}
+
+int submitHashJob(const char *filePath, HashResultCallback callback, void *context) {
+    if (!filePath || !callback) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    if (strlen(filePath) == 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
+    }
+    
+    HashWaiter *waiter = malloc(sizeof(HashWaiter));
+    if (!waiter) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    waiter->callback = callback;
+    waiter->context = context;
+    waiter->next = NULL;
+    
+    pthread_mutex_lock(&g_hash_pool_mutex);
+    
+    if (!g_hash_workers || g_hash_pool_stopping) {
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        free(waiter);
+        return BRIDGE_ERROR_INVALID_PARAMETER; // Pool not running
+    }
+    
+    HashJob *existing = findPendingHashJob(filePath);
+    if (existing) {
+        waiter->next = existing->waiters;
+        existing->waiters = waiter;
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        return BRIDGE_SUCCESS;
+    }
+    
+    if (g_hash_queue_count >= g_hash_queue_capacity) {
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        free(waiter);
+        return BRIDGE_ERROR_QUEUE_FULL;
+    }
+    
+    HashJob *job = malloc(sizeof(HashJob));
+    char *pathCopy = strdup(filePath);
+    if (!job || !pathCopy) {
+        pthread_mutex_unlock(&g_hash_pool_mutex);
+        free(job);
+        free(pathCopy);
+        free(waiter);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    job->filePath = pathCopy;
+    job->waiters = waiter;
+    
+    g_hash_queue[(g_hash_queue_head + g_hash_queue_count) % g_hash_queue_capacity] = job;
+    g_hash_queue_count++;
+    pthread_cond_signal(&g_hash_pool_cond);
+    
+    pthread_mutex_unlock(&g_hash_pool_mutex);
+    return BRIDGE_SUCCESS;
+}
+
+// MARK: - Window Heuristics
+
+// Window heuristics shared by the snapshot builder and the state cache. A
+// window counts towards screen evasion when it is positioned off-screen /
+// degenerate, or when its content is excluded from screen capture
+// (kCGWindowSharingNone = 0). Written branch-free so the column passes below
+// compile to straight-line (vectorizable) loops.
+static inline int isWindowBoundsSuspicious(double x, double y, double width, double height) {
+    // Detect windows that are suspiciously positioned (off-screen or very small)
+    return (x < -1000) | (y < -1000) | (width < 1) | (height < 1) | (x > 10000) | (y > 10000);
+}
+
+static inline int isWindowCaptureExcluded(int32_t sharingState) {
+    // kCGWindowSharingNone = 0 (window not available for reading)
+    return sharingState == 0;
+}
+
+static inline int isWindowLayerElevated(int32_t layer) {
+    // Elevated layers (above normal application windows)
+    // kCGFloatingWindowLevel = 3, kCGModalPanelWindowLevel = 8, etc.
+    return layer > 2;
+}
+
+static inline void accumulateWindow(WindowOwnerEntry *entry, int isOnScreen, int isOffScreen, int32_t sharingState, int32_t layer) {
+    int captureExcluded = isWindowCaptureExcluded(sharingState);
+    entry->windowCount += isOnScreen;
+    entry->screenEvasionCount += isOffScreen + captureExcluded;
+    entry->sharingDisabledCount += captureExcluded;
+    entry->elevatedLayerCount += isWindowLayerElevated(layer);
+}
+
+// MARK: - Window Columns
+
+// One window list copy decoded into flat per-field arrays, so every heuristic
+// is a tight loop over contiguous values instead of dictionary lookups
+typedef struct {
+    int count;
+    double *x;
+    double *y;
+    double *width;
+    double *height;
+    pid_t *ownerPid;
+    uint32_t *windowNumber;
+    int32_t *layer;
+    int32_t *sharingState;
+    uint8_t *isOnScreen;
+    uint8_t *hasBounds;
+    uint8_t *isOffScreen;       // filled by markOffScreenWindows
+    void *storage;              // single allocation backing every column
+} WindowColumns;
+
+static int allocateWindowColumns(WindowColumns *columns, size_t capacity) {
+    memset(columns, 0, sizeof(*columns));
+    
+    // Widest columns first keeps every column naturally aligned
+    size_t doubleBytes = capacity * sizeof(double);
+    size_t wordBytes = capacity * sizeof(int32_t);
+    char *storage = malloc(doubleBytes * 4 + wordBytes * 4 + capacity * 3);
+    if (!storage) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    
+    columns->storage = storage;
+    columns->x = (double *)storage;
+    columns->y = (double *)(storage + doubleBytes);
+    columns->width = (double *)(storage + doubleBytes * 2);
+    columns->height = (double *)(storage + doubleBytes * 3);
+    char *words = storage + doubleBytes * 4;
+    columns->ownerPid = (pid_t *)words;
+    columns->windowNumber = (uint32_t *)(words + wordBytes);
+    columns->layer = (int32_t *)(words + wordBytes * 2);
+    columns->sharingState = (int32_t *)(words + wordBytes * 3);
+    uint8_t *bytes = (uint8_t *)(words + wordBytes * 4);
+    columns->isOnScreen = bytes;
+    columns->hasBounds = bytes + capacity;
+    columns->isOffScreen = bytes + capacity * 2;
+    return BRIDGE_SUCCESS;
+}
+
+static void releaseWindowColumns(WindowColumns *columns) {
+    free(columns->storage);
+    memset(columns, 0, sizeof(*columns));
+}
+
+static inline int32_t copyWindowInt(CFDictionaryRef dictionary, CFStringRef key, int32_t fallback) {
+    CFNumberRef number = (CFNumberRef)CFDictionaryGetValue(dictionary, key);
+    int32_t value;
+    return (number && CFNumberGetValue(number, kCFNumberSInt32Type, &value)) ? value : fallback;
+}
+
+static inline double copyWindowDouble(CFDictionaryRef dictionary, CFStringRef key) {
+    CFNumberRef number = (CFNumberRef)CFDictionaryGetValue(dictionary, key);
+    double value;
+    return (number && CFNumberGetValue(number, kCFNumberDoubleType, &value)) ? value : 0;
+}
+
+// The only pass that touches CoreFoundation: every key the heuristics need,
+// read once per window. Windows without an owner are dropped.
+static void decodeWindowColumns(CFArrayRef windowList, WindowColumns *columns) {
+    // Keys of the kCGWindowBounds dictionary (CGRectCreateDictionaryRepresentation)
+    CFStringRef boundsX = CFSTR("X");
+    CFStringRef boundsY = CFSTR("Y");
+    CFStringRef boundsWidth = CFSTR("Width");
+    CFStringRef boundsHeight = CFSTR("Height");
+    
+    CFIndex windowCount = CFArrayGetCount(windowList);
+    int count = 0;
+    for (CFIndex i = 0; i < windowCount; i++) {
+        CFDictionaryRef window = (CFDictionaryRef)CFArrayGetValueAtIndex(windowList, i);
+        
+        int32_t ownerPid = copyWindowInt(window, kCGWindowOwnerPID, 0);
+        if (ownerPid <= 0) {
+            continue;
+        }
+        
+        columns->ownerPid[count] = ownerPid;
+        columns->windowNumber[count] = (uint32_t)copyWindowInt(window, kCGWindowNumber, 0);
+        columns->layer[count] = copyWindowInt(window, kCGWindowLayer, 0);
+        // Missing sharing state reads as a normal, shareable window
+        columns->sharingState[count] = copyWindowInt(window, kCGWindowSharingState, -1);
+        
+        CFBooleanRef onScreen = (CFBooleanRef)CFDictionaryGetValue(window, kCGWindowIsOnscreen);
+        columns->isOnScreen[count] = (onScreen && CFBooleanGetValue(onScreen)) ? 1 : 0;
+        
+        CFDictionaryRef bounds = (CFDictionaryRef)CFDictionaryGetValue(window, kCGWindowBounds);
+        columns->hasBounds[count] = bounds ? 1 : 0;
+        columns->x[count] = bounds ? copyWindowDouble(bounds, boundsX) : 0;
+        columns->y[count] = bounds ? copyWindowDouble(bounds, boundsY) : 0;
+        columns->width[count] = bounds ? copyWindowDouble(bounds, boundsWidth) : 0;
+        columns->height[count] = bounds ? copyWindowDouble(bounds, boundsHeight) : 0;
+        count++;
+    }
+    columns->count = count;
+}
+
+static void markOffScreenWindows(WindowColumns *columns) {
+    const double *x = columns->x;
+    const double *y = columns->y;
+    const double *width = columns->width;
+    const double *height = columns->height;
+    const uint8_t *hasBounds = columns->hasBounds;
+    uint8_t *isOffScreen = columns->isOffScreen;
+    
+    for (int i = 0; i < columns->count; i++) {
+        isOffScreen[i] = (uint8_t)(hasBounds[i] & isWindowBoundsSuspicious(x[i], y[i], width[i], height[i]));
+    }
+}
+
+static WindowState *copyWindowStates(const WindowColumns *columns) {
+    WindowState *windows = malloc((size_t)(columns->count > 0 ? columns->count : 1) * sizeof(WindowState));
+    if (!windows) {
+        return NULL;
+    }
+    
+    for (int i = 0; i < columns->count; i++) {
+        windows[i].windowNumber = columns->windowNumber[i];
+        windows[i].ownerPid = columns->ownerPid[i];
+        windows[i].layer = columns->layer[i];
+        windows[i].sharingState = columns->sharingState[i];
+        windows[i].isOnScreen = columns->isOnScreen[i];
+        windows[i].isOffScreen = columns->isOffScreen[i];
+        windows[i].bounds = CGRectMake(columns->x[i], columns->y[i], columns->width[i], columns->height[i]);
+    }
+    return windows;
+}
+
+// MARK: - Window State Cache
+
+#define WINDOW_EVENT_CAPACITY 4096
+#define WINDOW_STATE_MAX_AGE_NS 1000000000ull   // single-PID queries reuse a scan this recent
+
+// Windows seen by the previous window scan, indexed by window number
+typedef struct {
+    WindowState *windows;
+    int count;
+    int *slots;                 // open-addressed index into windows, -1 = empty
+    int slotMask;
+    uint64_t updatedAt;         // CLOCK_UPTIME_RAW ns, 0 = never scanned
+} WindowStateTable;
+
+// The previous scan's windows and the changes queued against it. Window scans
+// update the shared one under g_window_state_mutex; createWindowStateCache
+// makes private ones for callers that diff their own window lists.
+struct WindowStateCache {
+    WindowStateTable table;
+    WindowEvent *events;        // pending, capacity WINDOW_EVENT_CAPACITY
+    int eventCount;
+    int eventsDropped;
+};
+
+static pthread_mutex_t g_window_state_mutex = PTHREAD_MUTEX_INITIALIZER;
+static WindowStateCache g_window_state_cache;
+
+static inline uint32_t windowNumberHash(uint32_t windowNumber) {
+    return windowNumber * 2654435761u;
+}
+
+static int indexWindowStateTable(WindowStateTable *table) {
+    size_t slotCount = 16;
+    while (slotCount < (size_t)table->count * 2) {
+        slotCount <<= 1;
+    }
+    
+    int *slots = malloc(slotCount * sizeof(int));
+    if (!slots) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    memset(slots, 0xFF, slotCount * sizeof(int));
+    
+    for (int i = 0; i < table->count; i++) {
+        uint32_t slot = windowNumberHash(table->windows[i].windowNumber) & (uint32_t)(slotCount - 1);
+        while (slots[slot] >= 0) {
+            slot = (slot + 1) & (uint32_t)(slotCount - 1);
+        }
+        slots[slot] = i;
+    }
+    
+    free(table->slots);
+    table->slots = slots;
+    table->slotMask = (int)(slotCount - 1);
+    return BRIDGE_SUCCESS;
+}
+
+static const WindowState *findWindowState(const WindowStateTable *table, uint32_t windowNumber) {
+    if (!table->slots) {
+        return NULL;
+    }
+    
+    uint32_t slot = windowNumberHash(windowNumber) & (uint32_t)table->slotMask;
+    while (table->slots[slot] >= 0) {
+        const WindowState *window = &table->windows[table->slots[slot]];
+        if (window->windowNumber == windowNumber) {
+            return window;
+        }
+        slot = (slot + 1) & (uint32_t)table->slotMask;
+    }
+    return NULL;
+}
+
+static void releaseWindowStateTable(WindowStateTable *table) {
+    free(table->windows);
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
+
+static inline int isWindowLifecycleEvent(WindowEventType type) {
+    return type == WINDOW_EVENT_CREATED || type == WINDOW_EVENT_CLOSED;
+}
+
+// Menus, tooltips and popovers queue a CREATED/CLOSED pair every scan, so a
+// full queue sheds those (oldest first, all at once) before it ever drops an
+// evasion event
+static void appendWindowEvent(WindowStateCache *cache, WindowEventType type, const WindowState *window) {
+    if (!cache->events) {
+        cache->events = malloc(WINDOW_EVENT_CAPACITY * sizeof(WindowEvent));
     }
-    
-    // Ensure thread safety for this critical operation
-    int mutex_result = pthread_mutex_lock(&g_bridge_mutex);
-    if (mutex_result != 0) {
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    if (!cache->events) {
+        cache->eventsDropped++;
+        return;
     }
     
-    int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_ALL, 0};
-    size_t size;
-    
-    // Get the size needed
-    if (sysctl(mib, 4, NULL, &size, NULL, 0) != 0) {
-        pthread_mutex_unlock(&g_bridge_mutex);
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    if (cache->eventCount >= WINDOW_EVENT_CAPACITY) {
+        int kept = 0;
+        for (int i = 0; i < cache->eventCount; i++) {
+            if (!isWindowLifecycleEvent(cache->events[i].type)) {
+                cache->events[kept++] = cache->events[i];
+            }
+        }
+        cache->eventsDropped += cache->eventCount - kept;
+        cache->eventCount = kept;
     }
-    
-    if (size == 0) {
-        pthread_mutex_unlock(&g_bridge_mutex);
-        return BRIDGE_ERROR_INVALID_PARAMETER;
+    if (cache->eventCount >= WINDOW_EVENT_CAPACITY) {
+        cache->eventsDropped++;
+        return;
     }
     
-    // Allocate memory for process list
-    struct kinfo_proc *proc_list = malloc(size);
-    if (!proc_list) {
-        pthread_mutex_unlock(&g_bridge_mutex);
+    cache->events[cache->eventCount].type = type;
+    cache->events[cache->eventCount].window = *window;
+    cache->eventCount++;
+}
+
+// A scan's windows as an indexed table; takes ownership of windows
+static int makeWindowStateTable(WindowState *windows, int count, WindowStateTable *table) {
+    WindowStateTable current = {windows, count, NULL, 0, clock_gettime_nsec_np(CLOCK_UPTIME_RAW)};
+    if (indexWindowStateTable(&current) != BRIDGE_SUCCESS) {
+        free(windows);
         return BRIDGE_ERROR_MEMORY_ALLOCATION;
     }
-    
-    // Get the actual process list
-    if (sysctl(mib, 4, proc_list, &size, NULL, 0) != 0) {
-        free(proc_list);
-        pthread_mutex_unlock(&g_bridge_mutex);
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    *table = current;
+    return BRIDGE_SUCCESS;
+}
+
+// Swaps in a scan's table (taking ownership) and queues the window-level
+// changes against the previous scan. The shared cache needs g_window_state_mutex.
+static void applyWindowStateTable(WindowStateCache *cache, WindowStateTable current) {
+    WindowStateTable *previous = &cache->table;
+    for (int i = 0; i < previous->count; i++) {
+        if (!findWindowState(&current, previous->windows[i].windowNumber)) {
+            appendWindowEvent(cache, WINDOW_EVENT_CLOSED, &previous->windows[i]);
+        }
     }
     
-    int proc_count = (int)(size / sizeof(struct kinfo_proc));
-    if (proc_count <= 0) {
-        free(proc_list);
-        pthread_mutex_unlock(&g_bridge_mutex);
-        return BRIDGE_ERROR_INVALID_PARAMETER;
+    for (int i = 0; i < current.count; i++) {
+        const WindowState *window = &current.windows[i];
+        const WindowState *before = findWindowState(previous, window->windowNumber);
+        
+        // Windows with an owner change are treated as new windows
+        if (!before || before->ownerPid != window->ownerPid) {
+            appendWindowEvent(cache, WINDOW_EVENT_CREATED, window);
+            continue;
+        }
+        
+        if (window->isOffScreen && !before->isOffScreen) {
+            appendWindowEvent(cache, WINDOW_EVENT_MOVED_OFFSCREEN, window);
+        }
+        if (isWindowCaptureExcluded(window->sharingState) && !isWindowCaptureExcluded(before->sharingState)) {
+            appendWindowEvent(cache, WINDOW_EVENT_SHARING_DISABLED, window);
+        }
+        if (isWindowLayerElevated(window->layer) && !isWindowLayerElevated(before->layer)) {
+            appendWindowEvent(cache, WINDOW_EVENT_LAYER_ELEVATED, window);
+        }
     }
     
-    // Allocate our SystemProcessInfo array
-    *processes = malloc(proc_count * sizeof(SystemProcessInfo));
-    if (!*processes) {
-        free(proc_list);
-        pthread_mutex_unlock(&g_bridge_mutex);
+    releaseWindowStateTable(previous);
+    *previous = current;
+}
+
+static int takeWindowEvents(WindowStateCache *cache, WindowEventDelta *delta) {
+    WindowEvent *events = malloc((size_t)(cache->eventCount > 0 ? cache->eventCount : 1) * sizeof(WindowEvent));
+    if (!events) {
         return BRIDGE_ERROR_MEMORY_ALLOCATION;
     }
     
-    int valid_count = 0;
-    
-    for (int i = 0; i < proc_count; i++) {
-        pid_t pid = proc_list[i].kp_proc.p_pid;
-        
-        // Skip kernel processes (PID 0)
-        if (pid <= 0) continue;
-        
-        SystemProcessInfo *info = &(*processes)[valid_count];
-        info->pid = pid;
-        
-        // Initialize all fields to safe defaults
-        memset(info->name, 0, sizeof(info->name));
-        memset(info->path, 0, sizeof(info->path));
-        info->windowCount = 0;
-        info->screenEvasionCount = 0;
-        info->elevatedLayerCount = 0;
-        info->suspiciousWindowCount = 0;
-        
-        // Get process name
-        if (getProcessName(pid, info->name, sizeof(info->name)) == BRIDGE_SUCCESS) {
-            // Get process path (non-critical if it fails)
-            getProcessPath(pid, info->path, sizeof(info->path));
-            
-            // Get window information (non-critical if they fail)
-            info->windowCount = getWindowCount(pid);
-            info->screenEvasionCount = detectScreenEvasion(pid);
-            info->elevatedLayerCount = detectElevatedLayers(pid);
-            info->suspiciousWindowCount = (info->screenEvasionCount > 0 || info->elevatedLayerCount > 0) ? 1 : 0;
-            
-            valid_count++;
+    // Closes go first so a reused window number reads as close-then-create
+    int eventCount = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < cache->eventCount; i++) {
+            int isClose = (cache->events[i].type == WINDOW_EVENT_CLOSED);
+            if (isClose == (pass == 0)) {
+                events[eventCount++] = cache->events[i];
+            }
         }
     }
     
-    free(proc_list);
-    pthread_mutex_unlock(&g_bridge_mutex);
-    return valid_count;
+    delta->events = events;
+    delta->count = eventCount;
+    delta->droppedCount = cache->eventsDropped;
+    cache->eventCount = 0;
+    cache->eventsDropped = 0;
+    return eventCount;
 }
 
-int getProcessName(pid_t pid, char *name, size_t nameSize) {
-    if (!name || nameSize == 0) {
+static void releaseWindowStateCache(WindowStateCache *cache) {
+    releaseWindowStateTable(&cache->table);
+    free(cache->events);
+    memset(cache, 0, sizeof(*cache));
+}
+
+int getWindowEvents(WindowEventDelta *delta) {
+    if (!delta) {
         return BRIDGE_ERROR_NULL_POINTER;
     }
     
-    if (pid <= 0) {
-        return BRIDGE_ERROR_INVALID_PARAMETER;
+    memset(delta, 0, sizeof(*delta));
+    
+    pthread_mutex_lock(&g_window_state_mutex);
+    int result = takeWindowEvents(&g_window_state_cache, delta);
+    pthread_mutex_unlock(&g_window_state_mutex);
+    return result;
+}
+
+void freeWindowEventDelta(WindowEventDelta *delta) {
+    if (!delta) {
+        return;
     }
     
-    struct proc_bsdinfo proc_info;
+    free(delta->events);
+    memset(delta, 0, sizeof(*delta));
+}
+
+void resetWindowEvents(void) {
+    // Every window is reported as created after the next window scan
+    pthread_mutex_lock(&g_window_state_mutex);
+    releaseWindowStateCache(&g_window_state_cache);
+    pthread_mutex_unlock(&g_window_state_mutex);
+}
+
+// Aggregates one owner from the cached windows if a scan ran recently
+static int getCachedWindowProperties(pid_t pid, WindowProperties *properties) {
+    pthread_mutex_lock(&g_window_state_mutex);
     
-    if (proc_pidinfo(pid, PROC_PIDTBSDINFO, 0, &proc_info, sizeof(proc_info)) <= 0) {
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    WindowStateTable *table = &g_window_state_cache.table;
+    if (table->updatedAt == 0 ||
+        clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - table->updatedAt > WINDOW_STATE_MAX_AGE_NS) {
+        pthread_mutex_unlock(&g_window_state_mutex);
+        return 0;
     }
     
-    strncpy(name, proc_info.pbi_name, nameSize - 1);
-    name[nameSize - 1] = '\0';
-    return BRIDGE_SUCCESS;
+    WindowOwnerEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    for (int i = 0; i < table->count; i++) {
+        if (table->windows[i].ownerPid == pid) {
+            const WindowState *window = &table->windows[i];
+            accumulateWindow(&entry, window->isOnScreen, window->isOffScreen, window->sharingState, window->layer);
+        }
+    }
+    
+    pthread_mutex_unlock(&g_window_state_mutex);
+    
+    properties->windowCount = entry.windowCount;
+    properties->elevatedLayers = entry.elevatedLayerCount;
+    properties->suspiciousPatterns = entry.screenEvasionCount;
+    properties->sharingStateDisabled = entry.sharingDisabledCount;
+    return 1;
 }
 
-int getProcessPath(pid_t pid, char *path, size_t pathSize) {
-    if (!path || pathSize == 0) {
-        return BRIDGE_ERROR_NULL_POINTER;
+// MARK: - Window Snapshot
+
+static inline uint32_t windowSnapshotHash(pid_t pid) {
+    return (uint32_t)pid * 2654435761u;
+}
+
+static WindowOwnerEntry *findOrInsertWindowOwner(WindowSnapshot *snapshot, pid_t pid) {
+    uint32_t slot = windowSnapshotHash(pid) & (uint32_t)snapshot->slotMask;
+    
+    while (snapshot->slots[slot] >= 0) {
+        WindowOwnerEntry *entry = &snapshot->entries[snapshot->slots[slot]];
+        if (entry->pid == pid) {
+            return entry;
+        }
+        slot = (slot + 1) & (uint32_t)snapshot->slotMask;
     }
     
-    if (pid <= 0) {
-        return BRIDGE_ERROR_INVALID_PARAMETER;
+    WindowOwnerEntry *entry = &snapshot->entries[snapshot->count];
+    memset(entry, 0, sizeof(*entry));
+    entry->pid = pid;
+    snapshot->slots[slot] = snapshot->count;
+    snapshot->count++;
+    return entry;
+}
+
+// Column decode and off-screen marking for a list in CGWindowListCopyWindowInfo format
+static int decodeWindowList(CFArrayRef windowList, WindowColumns *columns) {
+    CFIndex windowCount = CFArrayGetCount(windowList);
+    if (allocateWindowColumns(columns, windowCount > 0 ? (size_t)windowCount : 1) != BRIDGE_SUCCESS) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
     }
     
-    // Ensure pathSize fits in uint32_t for proc_pidpath
-    if (pathSize > UINT32_MAX) {
-        return BRIDGE_ERROR_INVALID_PARAMETER;
+    decodeWindowColumns(windowList, columns);
+    markOffScreenWindows(columns);
+    return BRIDGE_SUCCESS;
+}
+
+// Per-owner counters; touches no shared state
+static int groupWindowOwners(const WindowColumns *columns, WindowSnapshot *snapshot) {
+    size_t entryCapacity = columns->count > 0 ? (size_t)columns->count : 1;
+    
+    // Keep the open-addressed table at most half full
+    size_t slotCount = 16;
+    while (slotCount < entryCapacity * 2) {
+        slotCount <<= 1;
     }
     
-    if (proc_pidpath(pid, path, (uint32_t)pathSize) <= 0) {
-        path[0] = '\0';
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    snapshot->entries = malloc(entryCapacity * sizeof(WindowOwnerEntry));
+    snapshot->slots = malloc(slotCount * sizeof(int));
+    if (!snapshot->entries || !snapshot->slots) {
+        freeWindowSnapshot(snapshot);
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
+    }
+    memset(snapshot->slots, 0xFF, slotCount * sizeof(int)); // every slot = -1 (empty)
+    snapshot->slotMask = (int)(slotCount - 1);
+    
+    for (int i = 0; i < columns->count; i++) {
+        WindowOwnerEntry *entry = findOrInsertWindowOwner(snapshot, columns->ownerPid[i]);
+        accumulateWindow(entry, columns->isOnScreen[i], columns->isOffScreen[i], columns->sharingState[i], columns->layer[i]);
     }
     return BRIDGE_SUCCESS;
 }
 
-void freeProcessList(SystemProcessInfo *processes) {
-    if (processes) {
-        free(processes);
+// The row-per-window copy a state cache keeps for diffing and single-PID queries
+static int copyWindowStateTable(const WindowColumns *columns, WindowStateTable *table) {
+    WindowState *windows = copyWindowStates(columns);
+    if (!windows) {
+        return BRIDGE_ERROR_MEMORY_ALLOCATION;
     }
+    return makeWindowStateTable(windows, columns->count, table);
 }
 
-int calculateFileSHA256(const char *filePath, char *hashString, size_t hashStringSize) {
-    if (!filePath || !hashString) {
+int createWindowSnapshot(WindowSnapshot *snapshot) {
+    if (!snapshot) {
         return BRIDGE_ERROR_NULL_POINTER;
     }
     
-    if (hashStringSize < 65) {
-        return BRIDGE_ERROR_INVALID_PARAMETER; // Need at least 65 bytes for SHA256 hex string + null terminator
-    }
+    memset(snapshot, 0, sizeof(*snapshot));
     
-    if (strlen(filePath) == 0) {
-        return BRIDGE_ERROR_INVALID_PARAMETER;
-    }
+    // One WindowServer round-trip for the whole scan. On-screen state is taken
+    // from kCGWindowIsOnscreen so the on-screen-only count needs no second copy.
+    os_log_t log = signpostLog();
+    os_signpost_id_t signpost = os_signpost_id_generate(log);
+    os_signpost_interval_begin(log, signpost, "WindowCopy");
+    uint64_t copyStart = metricsNow();
     
-    FILE *file = fopen(filePath, "rb");
-    if (!file) {
-        return BRIDGE_ERROR_FILE_ACCESS;
-    }
+    CFArrayRef windowList = CGWindowListCopyWindowInfo(kCGWindowListOptionAll, kCGNullWindowID);
     
-    // Check if file is readable and get size for validation
-    if (fseek(file, 0, SEEK_END) != 0) {
-        fclose(file);
-        return BRIDGE_ERROR_FILE_ACCESS;
+    countMetric(&g_metrics.windowCopies, 1);
+    countMetric(&g_metrics.windowCopyNanoseconds, metricsNow() - copyStart);
+    os_signpost_interval_end(log, signpost, "WindowCopy", "%ld windows", windowList ? (long)CFArrayGetCount(windowList) : 0L);
+    if (!windowList) {
+        return BRIDGE_ERROR_SYSTEM_CALL;
     }
     
-    long fileSize = ftell(file);
-    if (fileSize < 0) {
-        fclose(file);
-        return BRIDGE_ERROR_FILE_ACCESS;
+    WindowColumns columns;
+    int result = decodeWindowList(windowList, &columns);
+    CFRelease(windowList);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
     }
     
-    if (fseek(file, 0, SEEK_SET) != 0) {
-        fclose(file);
-        return BRIDGE_ERROR_FILE_ACCESS;
+    result = groupWindowOwners(&columns, snapshot);
+    
+    // A failed copy only costs this scan's window events
+    WindowStateTable table;
+    if (result == BRIDGE_SUCCESS && copyWindowStateTable(&columns, &table) == BRIDGE_SUCCESS) {
+        pthread_mutex_lock(&g_window_state_mutex);
+        applyWindowStateTable(&g_window_state_cache, table);
+        pthread_mutex_unlock(&g_window_state_mutex);
     }
     
-    CC_SHA256_CTX sha256Context;
-    if (CC_SHA256_Init(&sha256Context) == 0) {
-        fclose(file);
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    releaseWindowColumns(&columns);
+    return result;
+}
+
+int decodeWindowSnapshot(CFArrayRef windowList, WindowSnapshot *snapshot) {
+    if (!windowList || !snapshot) {
+        return BRIDGE_ERROR_NULL_POINTER;
     }
     
-    const size_t bufferSize = 4096;
-    unsigned char buffer[bufferSize];
-    size_t bytesRead;
+    memset(snapshot, 0, sizeof(*snapshot));
     
-    while ((bytesRead = fread(buffer, 1, bufferSize, file)) > 0) {
-        // Ensure bytesRead fits in CC_LONG (uint32_t) to avoid truncation
-        if (bytesRead > UINT32_MAX) {
-            fclose(file);
-            return BRIDGE_ERROR_INVALID_PARAMETER;
-        }
-        
-        if (CC_SHA256_Update(&sha256Context, buffer, (CC_LONG)bytesRead) == 0) {
-            fclose(file);
-            return BRIDGE_ERROR_SYSTEM_CALL;
-        }
+    WindowColumns columns;
+    int result = decodeWindowList(windowList, &columns);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
     }
     
-    // Check for read errors
-    if (ferror(file)) {
-        fclose(file);
-        return BRIDGE_ERROR_FILE_ACCESS;
+    result = groupWindowOwners(&columns, snapshot);
+    releaseWindowColumns(&columns);
+    return result;
+}
+
+WindowStateCache *createWindowStateCache(void) {
+    return calloc(1, sizeof(WindowStateCache));
+}
+
+void freeWindowStateCache(WindowStateCache *cache) {
+    if (!cache) {
+        return;
     }
     
-    fclose(file);
+    releaseWindowStateCache(cache);
+    free(cache);
+}
+
+int updateWindowStateCacheFromList(WindowStateCache *cache, CFArrayRef windowList) {
+    if (!cache || !windowList) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
     
-    unsigned char hash[CC_SHA256_DIGEST_LENGTH];
-    if (CC_SHA256_Final(hash, &sha256Context) == 0) {
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    WindowColumns columns;
+    int result = decodeWindowList(windowList, &columns);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
     }
     
-    // Convert hash to hex string with bounds checking
-    for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
-        int written = snprintf(hashString + (i * 2), 3, "%02x", hash[i]);
-        if (written != 2) {
-            return BRIDGE_ERROR_SYSTEM_CALL;
-        }
+    WindowStateTable table;
+    result = copyWindowStateTable(&columns, &table);
+    if (result == BRIDGE_SUCCESS) {
+        applyWindowStateTable(cache, table);
     }
-    hashString[CC_SHA256_DIGEST_LENGTH * 2] = '\0';
     
-    return BRIDGE_SUCCESS;
+    releaseWindowColumns(&columns);
+    return result;
 }
 
-// MARK: - Window Property Detection Functions
+int getWindowStateCacheEvents(WindowStateCache *cache, WindowEventDelta *delta) {
+    if (!cache || !delta) {
+        return BRIDGE_ERROR_NULL_POINTER;
+    }
+    
+    memset(delta, 0, sizeof(*delta));
+    return takeWindowEvents(cache, delta);
+}
 
-int getWindowCount(pid_t pid) {
-    if (pid <= 0) {
-        return 0;
+void freeWindowSnapshot(WindowSnapshot *snapshot) {
+    if (!snapshot) {
+        return;
     }
     
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(kCGWindowListOptionOnScreenOnly, kCGNullWindowID);
-    if (!windowList) {
-        return 0;
+    free(snapshot->entries);
+    free(snapshot->slots);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+const WindowOwnerEntry *lookupWindowOwner(const WindowSnapshot *snapshot, pid_t pid) {
+    if (!snapshot || !snapshot->slots || pid <= 0) {
+        return NULL;
     }
     
-    int count = 0;
-    CFIndex windowCount = CFArrayGetCount(windowList);
+    uint32_t slot = windowSnapshotHash(pid) & (uint32_t)snapshot->slotMask;
     
-    for (CFIndex i = 0; i < windowCount; i++) {
-        CFDictionaryRef window = (CFDictionaryRef)CFArrayGetValueAtIndex(windowList, i);
-        
-        CFNumberRef windowPID = (CFNumberRef)CFDictionaryGetValue(window, kCGWindowOwnerPID);
-        if (windowPID) {
-            int windowOwnerPID;
-            CFNumberGetValue(windowPID, kCFNumberIntType, &windowOwnerPID);
-            
-            if (windowOwnerPID == pid) {
-                count++;
-            }
+    while (snapshot->slots[slot] >= 0) {
+        const WindowOwnerEntry *entry = &snapshot->entries[snapshot->slots[slot]];
+        if (entry->pid == pid) {
+            return entry;
         }
+        slot = (slot + 1) & (uint32_t)snapshot->slotMask;
     }
     
-    CFRelease(windowList);
-    return count;
+    return NULL;
 }
 
-int detectScreenEvasion(pid_t pid) {
-    if (pid <= 0) {
-        return 0;
+int getWindowPropertiesFromSnapshot(const WindowSnapshot *snapshot, pid_t pid, WindowProperties *properties) {
+    if (!snapshot || !properties) {
+        return BRIDGE_ERROR_NULL_POINTER;
     }
     
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(kCGWindowListOptionAll, kCGNullWindowID);
-    if (!windowList) {
-        return 0;
+    if (pid <= 0) {
+        return BRIDGE_ERROR_INVALID_PARAMETER;
     }
     
-    int suspiciousCount = 0;
-    CFIndex windowCount = CFArrayGetCount(windowList);
+    memset(properties, 0, sizeof(*properties));
     
-    for (CFIndex i = 0; i < windowCount; i++) {
-        CFDictionaryRef window = (CFDictionaryRef)CFArrayGetValueAtIndex(windowList, i);
-        
-        CFNumberRef windowPID = (CFNumberRef)CFDictionaryGetValue(window, kCGWindowOwnerPID);
-        if (windowPID) {
-            int windowOwnerPID;
-            CFNumberGetValue(windowPID, kCFNumberIntType, &windowOwnerPID);
-            
-            if (windowOwnerPID == pid) {
-                // Check for suspicious window properties
-                CFDictionaryRef bounds = (CFDictionaryRef)CFDictionaryGetValue(window, kCGWindowBounds);
-                if (bounds) {
-                    CGRect rect;
-                    CGRectMakeWithDictionaryRepresentation(bounds, &rect);
-                    
-                    // Detect windows that are suspiciously positioned (off-screen or very small)
-                    if (rect.origin.x < -1000 || rect.origin.y < -1000 || 
-                        rect.size.width < 1 || rect.size.height < 1 ||
-                        rect.origin.x > 10000 || rect.origin.y > 10000) {
-                        suspiciousCount++;
-                    }
-                }
-                
-                // Check for windows with suspicious sharing state
-                CFNumberRef sharingState = (CFNumberRef)CFDictionaryGetValue(window, kCGWindowSharingState);
-                if (sharingState) {
-                    int sharing;
-                    CFNumberGetValue(sharingState, kCFNumberIntType, &sharing);
-                    
-                    // kCGWindowSharingNone = 0 (window not available for reading)
-                    if (sharing == 0) {
-                        suspiciousCount++;
-                    }
-                }
-            }
-        }
+    const WindowOwnerEntry *entry = lookupWindowOwner(snapshot, pid);
+    if (entry) {
+        properties->windowCount = entry->windowCount;
+        properties->elevatedLayers = entry->elevatedLayerCount;
+        properties->suspiciousPatterns = entry->screenEvasionCount;
+        properties->sharingStateDisabled = entry->sharingDisabledCount;
     }
     
-    CFRelease(windowList);
-    return suspiciousCount;
+    return BRIDGE_SUCCESS;
 }
 
-int detectElevatedLayers(pid_t pid) {
-    if (pid <= 0) {
+// MARK: - Window Property Detection Functions
+
+// Single-PID conveniences. They answer from the window state cache when a scan
+// ran within the last second and cost one window list copy otherwise; scans
+// that look at many PIDs should build a WindowSnapshot once and use
+// lookupWindowOwner instead.
+
+int getWindowCount(pid_t pid) {
+    WindowProperties properties;
+    if (getWindowProperties(pid, &properties) != BRIDGE_SUCCESS) {
         return 0;
     }
-    
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(kCGWindowListOptionAll, kCGNullWindowID);
-    if (!windowList) {
+    return properties.windowCount;
+}
+
+int detectScreenEvasion(pid_t pid) {
+    WindowProperties properties;
+    if (getWindowProperties(pid, &properties) != BRIDGE_SUCCESS) {
         return 0;
     }
-    
-    int elevatedCount = 0;
-    CFIndex windowCount = CFArrayGetCount(windowList);
-    
-    for (CFIndex i = 0; i < windowCount; i++) {
-        CFDictionaryRef window = (CFDictionaryRef)CFArrayGetValueAtIndex(windowList, i);
-        
-        CFNumberRef windowPID = (CFNumberRef)CFDictionaryGetValue(window, kCGWindowOwnerPID);
-        if (windowPID) {
-            int windowOwnerPID;
-            CFNumberGetValue(windowPID, kCFNumberIntType, &windowOwnerPID);
-            
-            if (windowOwnerPID == pid) {
-                // Check window layer
-                CFNumberRef layer = (CFNumberRef)CFDictionaryGetValue(window, kCGWindowLayer);
-                if (layer) {
-                    int layerValue;
-                    CFNumberGetValue(layer, kCFNumberIntType, &layerValue);
-                    
-                    // Elevated layers (above normal application windows)
-                    // kCGFloatingWindowLevel = 3, kCGModalPanelWindowLevel = 8, etc.
-                    if (layerValue > 2) {
-                        elevatedCount++;
-                    }
-                }
-            }
-        }
+    return properties.suspiciousPatterns;
+}
+
+int detectElevatedLayers(pid_t pid) {
+    WindowProperties properties;
+    if (getWindowProperties(pid, &properties) != BRIDGE_SUCCESS) {
+        return 0;
     }
-    
-    CFRelease(windowList);
-    return elevatedCount;
+    return properties.elevatedLayers;
 }
 
 int getWindowProperties(pid_t pid, WindowProperties *properties) {
@@ -388,40 +3442,20 @@ int getWindowProperties(pid_t pid, WindowProperties *properties) {
         return BRIDGE_ERROR_INVALID_PARAMETER;
     }
     
-    properties->windowCount = getWindowCount(pid);
-    properties->elevatedLayers = detectElevatedLayers(pid);
-    properties->suspiciousPatterns = detectScreenEvasion(pid);
-    properties->sharingStateDisabled = 0; // Will be set based on screen evasion results
+    memset(properties, 0, sizeof(*properties));
     
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(kCGWindowListOptionAll, kCGNullWindowID);
-    if (!windowList) {
-        return BRIDGE_ERROR_SYSTEM_CALL;
+    // The decoded windows of a recent scan avoid another window list copy
+    if (getCachedWindowProperties(pid, properties)) {
+        return BRIDGE_SUCCESS;
     }
     
-    CFIndex windowCount = CFArrayGetCount(windowList);
-    
-    for (CFIndex i = 0; i < windowCount; i++) {
-        CFDictionaryRef window = (CFDictionaryRef)CFArrayGetValueAtIndex(windowList, i);
-        
-        CFNumberRef windowPID = (CFNumberRef)CFDictionaryGetValue(window, kCGWindowOwnerPID);
-        if (windowPID) {
-            int windowOwnerPID;
-            CFNumberGetValue(windowPID, kCFNumberIntType, &windowOwnerPID);
-            
-            if (windowOwnerPID == pid) {
-                CFNumberRef sharingState = (CFNumberRef)CFDictionaryGetValue(window, kCGWindowSharingState);
-                if (sharingState) {
-                    int sharing;
-                    CFNumberGetValue(sharingState, kCFNumberIntType, &sharing);
-                    
-                    if (sharing == 0) {
-                        properties->sharingStateDisabled++;
-                    }
-                }
-            }
-        }
+    WindowSnapshot snapshot;
+    int result = createWindowSnapshot(&snapshot);
+    if (result != BRIDGE_SUCCESS) {
+        return result;
     }
     
-    CFRelease(windowList);
-    return BRIDGE_SUCCESS;
-}
\ No newline at end of file
+    result = getWindowPropertiesFromSnapshot(&snapshot, pid, properties);
+    freeWindowSnapshot(&snapshot);
+    return result;
+}
@@ -10,9 +10,21 @@
 #include <unistd.h>
 #include <string.h>
 #include <CommonCrypto/CommonDigest.h>
+#include <CommonCrypto/CommonHMAC.h>
 #include <CoreGraphics/CoreGraphics.h>
 #include <ApplicationServices/ApplicationServices.h>
 #include <pthread.h>
+#include <sys/event.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <mach-o/loader.h>
+#include <mach-o/fat.h>
+#include <libkern/OSByteOrder.h>
+#include <os/signpost.h>
+#include <stdatomic.h>
 
 typedef enum {
     BRIDGE_SUCCESS = 0,
@@ -20,19 +32,66 @@ typedef enum {
     BRIDGE_ERROR_INVALID_PARAMETER = -2,
     BRIDGE_ERROR_MEMORY_ALLOCATION = -3,
     BRIDGE_ERROR_SYSTEM_CALL = -4,
-    BRIDGE_ERROR_FILE_ACCESS = -5
+    BRIDGE_ERROR_FILE_ACCESS = -5,
+    BRIDGE_ERROR_BUDGET_EXHAUSTED = -6,
+    BRIDGE_ERROR_QUEUE_FULL = -7,
+    BRIDGE_ERROR_CANCELLED = -8,
+    BRIDGE_ERROR_AUTHENTICATION = -9
 } BridgeErrorCode;
 
+// Fixed-size per-process record. Names and paths live in the owning
+// ProcessSnapshot's string arena; offsets index into snapshot.strings and
+// every string there is NUL terminated.
 typedef struct {
     pid_t pid;
-    char name[PROC_PIDPATHINFO_MAXSIZE];
-    char path[PROC_PIDPATHINFO_MAXSIZE];
+    uint32_t nameOffset;
+    uint32_t pathOffset;
+    uint16_t nameLength;
+    uint16_t pathLength;
     int windowCount;
     int suspiciousWindowCount;
     int screenEvasionCount;
     int elevatedLayerCount;
+    int sharingDisabledCount;
+    uint64_t startTime;         // microseconds since the epoch; with pid, identifies one process lifetime
+    pid_t parentPid;            // kp_eproc.e_ppid as of the latest scan
+    pid_t responsiblePid;       // process macOS attributes this one to (TCC "responsible"), 0 if unknown
 } SystemProcessInfo;
 
+typedef struct {
+    SystemProcessInfo *processes;
+    int count;
+    char *strings;              // interned string arena, offset 0 is the empty string
+    size_t stringsSize;
+} ProcessSnapshot;
+
+typedef enum {
+    PROCESS_CHANGE_SPAWNED = 1,
+    PROCESS_CHANGE_EXITED = 2,
+    PROCESS_CHANGE_WINDOWS = 3  // window counters differ from the last report
+} ProcessChangeType;
+
+typedef struct {
+    ProcessChangeType type;
+    SystemProcessInfo process;  // offsets index into the owning delta's strings
+} ProcessChange;
+
+typedef enum {
+    PROCESS_EVENT_FORK = 1,     // pid is the parent; the child shows up on the next scan
+    PROCESS_EVENT_EXEC = 2,
+    PROCESS_EVENT_EXIT = 3
+} ProcessEventType;
+
+// Invoked on the watcher thread; keep it short and hop to a queue
+typedef void (*ProcessEventCallback)(pid_t pid, ProcessEventType type, void *context);
+
+typedef struct {
+    ProcessChange *changes;     // exits first, then spawns and window changes
+    int count;
+    char *strings;
+    size_t stringsSize;
+} ProcessDelta;
+
 typedef struct {
     int windowCount;
     int sharingStateDisabled;
@@ -40,21 +99,271 @@ typedef struct {
     int suspiciousPatterns;
 } WindowProperties;
 
+// File identity used by the SHA-256 cache; any change to the file changes the key
+typedef struct {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t modifiedSeconds;
+    int64_t modifiedNanoseconds;
+    int64_t changedSeconds;
+    int64_t changedNanoseconds;
+} HashCacheKey;
+
+// Per-scan limit on hashing work. Files that would exceed it are skipped with
+// BRIDGE_ERROR_BUDGET_EXHAUSTED and picked up by a later scan (0 = unlimited).
+// The first file a scan reads is always finished, so every scan makes progress.
+typedef struct {
+    uint64_t maxBytes;
+    uint64_t maxNanoseconds;
+    uint64_t startTime;
+    uint64_t bytesHashed;
+    int filesDeferred;
+} HashBudget;
+
+// Called on a hash worker thread. hashString is NULL unless result is BRIDGE_SUCCESS.
+typedef void (*HashResultCallback)(const char *filePath, int result, const char *hashString, void *context);
+
+// Code signing identity of a running process, read from the kernel (csops),
+// so no file I/O is needed. Strings are empty when not present.
+typedef struct {
+    uint32_t flags;             // CS_* status flags
+    int isSigned;               // kernel holds a valid signature for the process
+    int isPlatformBinary;       // signed by Apple as part of the OS
+    char cdHash[41];            // 40 hex chars + null terminator
+    char signingIdentifier[128];
+    char teamIdentifier[32];
+} CodeSigningIdentity;
+
+typedef enum {
+    SOCKET_PROTOCOL_TCP = 1,
+    SOCKET_PROTOCOL_UDP = 2
+} SocketProtocol;
+
+// One internet socket of a process. Addresses are in network byte order
+// (IPv4 in the first 4 bytes); ports are in host byte order.
+typedef struct {
+    pid_t pid;
+    uint8_t protocol;           // SocketProtocol
+    uint8_t family;             // AF_INET or AF_INET6
+    uint16_t localPort;
+    uint16_t remotePort;
+    int32_t state;              // TSI_S_* for TCP, -1 for UDP
+    uint8_t localAddress[16];
+    uint8_t remoteAddress[16];
+} SocketConnectionInfo;
+
+typedef struct {
+    SocketConnectionInfo *connections;
+    int count;
+} SocketSnapshot;
+
+typedef enum {
+    CONNECTION_OPENED = 1,
+    CONNECTION_CLOSED = 2
+} ConnectionChangeType;
+
+typedef struct {
+    ConnectionChangeType type;
+    SocketConnectionInfo connection;
+} ConnectionChange;
+
+typedef struct {
+    ConnectionChange *changes;  // closes first, then opens
+    int count;
+} ConnectionDelta;
+
+// Per-owner window counters collected from a single window list copy
+typedef struct {
+    pid_t pid;
+    int windowCount;            // on-screen windows
+    int screenEvasionCount;     // off-screen/degenerate bounds + capture-excluded windows
+    int elevatedLayerCount;     // windows above the normal application layer
+    int sharingDisabledCount;   // windows with kCGWindowSharingNone
+} WindowOwnerEntry;
+
+typedef struct {
+    WindowOwnerEntry *entries;  // one entry per window-owning PID
+    int count;
+    int *slots;                 // open-addressed PID index into entries, -1 = empty
+    int slotMask;
+} WindowSnapshot;
+
+// Decoded state of one window, cached by kCGWindowNumber across window scans
+typedef struct {
+    uint32_t windowNumber;
+    pid_t ownerPid;
+    int layer;                  // kCGWindowLayer; above 2 is over normal app windows
+    int sharingState;           // kCGWindowSharingState; 0 = excluded from capture
+    int isOnScreen;
+    int isOffScreen;            // positioned off-screen or degenerate bounds
+    CGRect bounds;
+} WindowState;
+
+typedef enum {
+    WINDOW_EVENT_CREATED = 1,
+    WINDOW_EVENT_CLOSED = 2,
+    WINDOW_EVENT_MOVED_OFFSCREEN = 3,
+    WINDOW_EVENT_SHARING_DISABLED = 4,
+    WINDOW_EVENT_LAYER_ELEVATED = 5
+} WindowEventType;
+
+typedef struct {
+    WindowEventType type;
+    WindowState window;         // state after the change (last known state for CLOSED)
+} WindowEvent;
+
+typedef struct {
+    WindowEvent *events;        // closes first, then the rest in window list order
+    int count;
+    int droppedCount;           // events lost because nobody drained them in time (CREATED/CLOSED go first)
+} WindowEventDelta;
+
+// Aho-Corasick automaton over ASCII case-folded bytes, compiled once from a
+// rule list so one pass over a name finds every rule it contains. Bytes that
+// appear in no rule share one transition column, so a state costs 4 bytes per
+// distinct rule byte (about 40 for name rules) rather than 4 per byte value.
+typedef struct {
+    uint8_t byteClasses[256];   // text byte -> transition column; 0 = in no pattern
+    int classCount;
+    int32_t *transitions;       // stateCount x classCount goto/failure transitions, flattened
+    int32_t *outputs;           // per state: first pattern ending here, -1 = none
+    int32_t *outputLinks;       // per state: nearest suffix state with an output, -1 = none
+    int32_t *nextPattern;       // per pattern: next pattern ending at the same state, -1 = none
+    int stateCount;
+    int patternCount;
+} PatternAutomaton;
+
+// Cumulative scan costs since launch; diff two reads for an interval.
+// Durations are CLOCK_UPTIME_RAW nanoseconds.
+typedef struct {
+    uint64_t processScans;          // process table walks
+    uint64_t sharedScans;           // callers served by a recent or in-flight walk
+    uint64_t processesScanned;      // kinfo_proc entries seen, summed over walks
+    uint64_t processesResolved;     // name/path lookups for new or exec'd processes
+    uint64_t scanNanoseconds;
+    uint64_t sysctlNanoseconds;
+    uint64_t resolveNanoseconds;
+    uint64_t windowCopies;          // CGWindowListCopyWindowInfo round-trips
+    uint64_t windowCopyNanoseconds;
+    uint64_t socketScans;
+    uint64_t socketScanNanoseconds;
+    uint64_t hashCacheHits;
+    uint64_t hashCacheMisses;
+    uint64_t filesHashed;           // files actually read
+    uint64_t bytesHashed;
+    uint64_t hashNanoseconds;
+} BridgeMetrics;
+
 // Function declarations
-int getAllProcesses(SystemProcessInfo **processes);
-void freeProcessList(SystemProcessInfo *processes);
+int getAllProcesses(ProcessSnapshot *snapshot);
+// Shares a scan that is in progress or finished within maxAgeMilliseconds
+// instead of walking the process table again
+int getAllProcessesWithMaxAge(ProcessSnapshot *snapshot, uint32_t maxAgeMilliseconds);
+void freeProcessSnapshot(ProcessSnapshot *snapshot);
+const char *getSnapshotString(const ProcessSnapshot *snapshot, uint32_t offset);
+
+// Internet sockets of every process, read with proc_pidinfo/proc_pidfdinfo.
+// connectedOnly keeps established TCP and connected UDP sockets (like
+// lsof -i -sTCP:ESTABLISHED with a remote end).
+int getSocketConnections(SocketSnapshot *snapshot, int connectedOnly);
+void freeSocketSnapshot(SocketSnapshot *snapshot);
+
+// Connected sockets opened/closed since the previous getConnectionChanges
+// call, tracked by (pid, protocol, local, remote) in the bridge (single consumer)
+int getConnectionChanges(ConnectionDelta *delta);
+void freeConnectionDelta(ConnectionDelta *delta);
+void resetConnectionChanges(void);
+
+// Incremental scans against the bridge's persistent process cache. Changes are
+// relative to the previous getProcessChanges call (single consumer).
+int getProcessChanges(ProcessDelta *delta);
+// Computes the changes against a scan at most maxAgeMilliseconds old (see
+// getAllProcessesWithMaxAge), so a tick's snapshot and delta share one walk
+int getProcessChangesWithMaxAge(ProcessDelta *delta, uint32_t maxAgeMilliseconds);
+void freeProcessDelta(ProcessDelta *delta);
+void resetProcessChanges(void);
+
+// kqueue-based spawn/exec/exit notifications for every cached PID. PIDs found
+// by later scans are tracked automatically while the watcher is running.
+int startProcessWatcher(ProcessEventCallback callback, void *context);
+void stopProcessWatcher(void);
 int getProcessName(pid_t pid, char *name, size_t nameSize);
 int getProcessPath(pid_t pid, char *path, size_t pathSize);
 int calculateFileSHA256(const char *filePath, char *hashString, size_t hashStringSize);
+int calculateFileSHA256WithBudget(const char *filePath, char *hashString, size_t hashStringSize, HashBudget *budget);
+// Always reads the file; neither consults nor fills the hash cache
+int calculateFileSHA256Uncached(const char *filePath, char *hashString, size_t hashStringSize);
+void beginHashBudget(HashBudget *budget, uint64_t maxBytes, uint64_t maxMilliseconds);
+
+// Bundle-aware identity. Bundle directories resolve to their main executable;
+// the CDHash is read from the host slice's code signature, not the whole file.
+int resolveBundleExecutable(const char *bundlePath, char *executablePath, size_t executablePathSize);
+int getExecutableCDHash(const char *filePath, char *hashString, size_t hashStringSize);
+int getProcessCodeIdentity(pid_t pid, CodeSigningIdentity *identity);
+
+// SHA-256 cache persistence (optional; the cache works in memory without it).
+// The file is authenticated with HMAC-SHA256 under key; a file that fails the
+// check loads nothing and returns BRIDGE_ERROR_AUTHENTICATION.
+int loadHashCache(const char *filePath, const uint8_t *key, size_t keyLength);
+int saveHashCache(const char *filePath, const uint8_t *key, size_t keyLength);
+void clearHashCache(void);
+
+// Background hash workers. workerCount <= 0 picks one per two cores (max 4).
+// Every accepted submission gets exactly one callback, including on stop.
+int startHashWorkers(int workerCount, int queueCapacity);
+void stopHashWorkers(void);
+int submitHashJob(const char *filePath, HashResultCallback callback, void *context);
+
+// Substring rule matching. Empty patterns never match; non-ASCII bytes
+// compare exactly. Results are pattern indexes into the build list.
+int buildPatternAutomaton(PatternAutomaton *automaton, const char *const *patterns, int patternCount);
+void freePatternAutomaton(PatternAutomaton *automaton);
+int findFirstPattern(const PatternAutomaton *automaton, const uint8_t *text, size_t length);
+int findAllPatterns(const PatternAutomaton *automaton, const uint8_t *text, size_t length, int *matches, int maxMatches);
 
 // Thread safety functions
 int initializeProcessBridge(void);
 void cleanupProcessBridge(void);
 
+// Scan cost counters. Each phase is also an os_signpost interval in the
+// com.truely.bridge subsystem, for Instruments.
+void getBridgeMetrics(BridgeMetrics *metrics);
+
+// Counts heap allocation calls (including ones freed again) process-wide
+// between begin and end, for benchmarks. Not reentrant: one count at a time.
+void beginAllocationCounting(void);
+uint64_t endAllocationCounting(void);
+
 // Window property detection functions
 int getWindowProperties(pid_t pid, WindowProperties *properties);
 int detectScreenEvasion(pid_t pid);
 int detectElevatedLayers(pid_t pid);
 int getWindowCount(pid_t pid);
 
+// Window snapshot functions (one CGWindowListCopyWindowInfo per snapshot)
+int createWindowSnapshot(WindowSnapshot *snapshot);
+// Per-owner counters for a list already in CGWindowListCopyWindowInfo format.
+// Unlike createWindowSnapshot it leaves the window state cache alone.
+int decodeWindowSnapshot(CFArrayRef windowList, WindowSnapshot *snapshot);
+void freeWindowSnapshot(WindowSnapshot *snapshot);
+const WindowOwnerEntry *lookupWindowOwner(const WindowSnapshot *snapshot, pid_t pid);
+int getWindowPropertiesFromSnapshot(const WindowSnapshot *snapshot, pid_t pid, WindowProperties *properties);
+
+// Window-level changes seen by window scans since the previous call (single
+// consumer). Every createWindowSnapshot - including the one in each process
+// scan - diffs the window list against the per-window state cache.
+int getWindowEvents(WindowEventDelta *delta);
+void freeWindowEventDelta(WindowEventDelta *delta);
+void resetWindowEvents(void);
+
+// A private window state cache for diffing caller-supplied window lists
+// (CGWindowListCopyWindowInfo format) apart from the shared one. One owner,
+// no locking.
+typedef struct WindowStateCache WindowStateCache;
+WindowStateCache *createWindowStateCache(void);
+void freeWindowStateCache(WindowStateCache *cache);
+int updateWindowStateCacheFromList(WindowStateCache *cache, CFArrayRef windowList);
+int getWindowStateCacheEvents(WindowStateCache *cache, WindowEventDelta *delta);
+
 #endif /* ProcessBridge_h */
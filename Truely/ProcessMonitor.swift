@@ -8,23 +8,42 @@ class ProcessMonitor: ObservableObject {
     @Published var advancedDetectionResults: [AdvancedDetectionResult] = []
     @Published var networkDetections: [NetworkDetectionResult] = []
     
-    private var forbiddenAppNames: [String] = []
-    private var basicMonitoringTimer: Timer?
-    private var advancedMonitoringTimer: Timer?
+    private var forbiddenAppMatcher = NameMatcher(patterns: [])
+    private let scheduler = MonitoringScheduler.shared
     private var isActive = false
     private var suspiciousDetector = SuspiciousProcessDetector()
     private var networkMonitor = NetworkMonitor()
     private var cancellables = Set<AnyCancellable>()
     private var planType: PlanType = .free
     
+    // Event-driven basic detection: kqueue process events and NSWorkspace
+    // launches trigger the basic phase early; its interval only reconciles
+    private let eventScanQueue = DispatchQueue(label: "com.truely.processmonitor.events", qos: .userInitiated)
+    private var isProcessWatcherActive = false
+    private var watcherContext: Unmanaged<WatcherContext>?
+    private var workspaceObservers: [NSObjectProtocol] = []
+    private let eventScanDelay: TimeInterval = 0.25
+    private let reconciliationInterval: TimeInterval = 15.0
+    private let pollingInterval: TimeInterval = 2.0
+    
+    // Hash worker start/stop and warm-start load/save run in order here, so a
+    // session started right after a stop can't have its workers (or its loaded
+    // caches) torn down by the previous session's delayed stop
+    private let lifecycleQueue = DispatchQueue(label: "com.truely.processmonitor.lifecycle", qos: .userInitiated)
+    
+    // What each phase last found, so the scheduler is only told about new
+    // detections (each is touched only by its own phase)
+    private var reportedForbiddenApps = Set<String>()
+    private var reportedSuspiciousPids = Set<pid_t>()
+    
     func configure(forbiddenApps: [String], planType: PlanType = .free) {
-        self.forbiddenAppNames = forbiddenApps
+        self.forbiddenAppMatcher = NameMatcher(patterns: forbiddenApps.map { $0.lowercased() })
         self.planType = planType
         print("🔧 ProcessMonitor configured for \(planType.displayName) plan")
     }
     
-    func configureSuspiciousProcesses(processNames: [String], paths: [String], hashes: [String]) {
-        suspiciousDetector.configure(processNames: processNames, paths: paths, hashes: hashes)
+    func configureSuspiciousProcesses(processNames: [String], paths: [String], hashes: [String], signatures: [SignatureRule] = []) {
+        suspiciousDetector.configure(processNames: processNames, paths: paths, hashes: hashes, signatures: signatures)
     }
     
     func enableAdvancedDetection(windowThreshold: Int = 3, screenEvasionThreshold: Int = 2) {
@@ -35,24 +54,52 @@ class ProcessMonitor: ObservableObject {
         guard !isActive else { return }
         isActive = true
         
-        // Basic detection every 2 seconds (both plans)
-        basicMonitoringTimer = Timer.scheduledTimer(withTimeInterval: 2.0, repeats: true) { _ in
-            DispatchQueue.global(qos: .userInitiated).async {
-                self.checkBasicForbiddenApps()
+        // Hashes run on background workers; matches are published as they
+        // complete. Waits out a previous session's stop if one is still joining.
+        lifecycleQueue.sync {
+            startHashWorkers(0, 256)
+        }
+        
+        // Warm start: the previous session's hash cache and clean executables
+        // load off the main thread while the first basic scan fills the bridge's
+        // process and window caches; the first advanced pass follows right after
+        let warmStart = DispatchGroup()
+        lifecycleQueue.async(group: warmStart) {
+            self.suspiciousDetector.loadWarmStartState()
+        }
+        
+        suspiciousDetector.onBackgroundDetection = { [weak self] result in
+            DispatchQueue.main.async {
+                guard let self = self, !self.suspiciousProcesses.contains(result) else { return }
+                self.suspiciousProcesses.append(result)
+            }
+        }
+        
+        // Basic detection on process events, with a slow reconciliation scan
+        // (both plans). Falls back to 2-second polling without the watcher.
+        startProcessEventWatching()
+        let basicInterval = isProcessWatcherActive ? reconciliationInterval : pollingInterval
+        scheduler.register("basic", interval: basicInterval, needsSnapshot: true) { snapshot in
+            ScanTelemetry.shared.measure(.basic) {
+                self.checkBasicForbiddenApps(snapshot: snapshot)
             }
         }
         
         // Advanced features only for PRO plan
         if planType == .pro {
-            // Slower advanced detection every 30 seconds
-            advancedMonitoringTimer = Timer.scheduledTimer(withTimeInterval: 30.0, repeats: true) { _ in
-                DispatchQueue.global(qos: .utility).async {
-                    self.checkAdvancedSuspiciousProcesses()
+            // Slower advanced detection every 30 seconds; the first pass runs
+            // as soon as the warm-start state is in, instead of on a fixed delay
+            warmStart.notify(queue: .main) {
+                guard self.isActive else { return }
+                self.scheduler.register("advanced", interval: 30.0, expensive: true, needsSnapshot: true) { snapshot in
+                    ScanTelemetry.shared.measure(.advanced) {
+                        self.checkAdvancedSuspiciousProcesses(snapshot: snapshot)
+                    }
                 }
             }
             
             // Start network monitoring
-            networkMonitor.startNetworkMonitoring()
+            networkMonitor.startNetworkMonitoring(scheduler: scheduler)
             
             // Setup network detection binding
             networkMonitor.$networkDetections
@@ -64,26 +111,19 @@ class ProcessMonitor: ObservableObject {
         } else {
             print("✅ Free plan: Basic process monitoring only")
         }
-        
-        // Run basic check immediately on start
-        DispatchQueue.global(qos: .userInitiated).async {
-            self.checkBasicForbiddenApps()
-        }
-        
-        // Run advanced check immediately if PRO plan
-        if planType == .pro {
-            DispatchQueue.global(qos: .utility).async {
-                self.checkAdvancedSuspiciousProcesses()
-            }
-        }
     }
     
     func stopMonitoring() {
         isActive = false
-        basicMonitoringTimer?.invalidate()
-        advancedMonitoringTimer?.invalidate()
-        basicMonitoringTimer = nil
-        advancedMonitoringTimer = nil
+        scheduler.unregister("basic")
+        scheduler.unregister("advanced")
+        stopProcessEventWatching()
+        
+        // Joining the workers can wait on an in-flight hash, so keep it off the main thread
+        lifecycleQueue.async {
+            stopHashWorkers()
+            self.suspiciousDetector.saveWarmStartState()
+        }
         
         // Stop network monitoring
         networkMonitor.stopNetworkMonitoring()
@@ -93,6 +133,65 @@ class ProcessMonitor: ObservableObject {
         networkDetections.removeAll()
     }
     
+    // MARK: - Process Event Watching
+    
+    // Handed to the C watcher thread, which can outlive the monitor; retained
+    // until stopProcessWatcher has joined that thread
+    private final class WatcherContext {
+        weak var monitor: ProcessMonitor?
+        
+        init(monitor: ProcessMonitor) {
+            self.monitor = monitor
+        }
+    }
+    
+    private func startProcessEventWatching() {
+        let context = Unmanaged.passRetained(WatcherContext(monitor: self))
+        let result = startProcessWatcher({ _, _, context in
+            guard let context = context else { return }
+            Unmanaged<WatcherContext>.fromOpaque(context).takeUnretainedValue().monitor?.scheduleEventScan()
+        }, context.toOpaque())
+        
+        isProcessWatcherActive = (result == 0)
+        if isProcessWatcherActive {
+            watcherContext = context
+            print("✅ Process watcher active - reconciling every \(Int(reconciliationInterval))s")
+        } else {
+            context.release()
+            print("⚠️ Process watcher unavailable (\(String(cString: getBridgeErrorDescription(result)))) - polling every \(Int(pollingInterval))s")
+        }
+        
+        // GUI launches and quits arrive through NSWorkspace even when kqueue
+        // registration was refused for that process
+        let center = NSWorkspace.shared.notificationCenter
+        for name in [NSWorkspace.didLaunchApplicationNotification, NSWorkspace.didTerminateApplicationNotification] {
+            let observer = center.addObserver(forName: name, object: nil, queue: nil) { [weak self] _ in
+                self?.scheduleEventScan()
+            }
+            workspaceObservers.append(observer)
+        }
+    }
+    
+    private func stopProcessEventWatching() {
+        if isProcessWatcherActive {
+            stopProcessWatcher()
+            isProcessWatcherActive = false
+            watcherContext?.release()
+            watcherContext = nil
+        }
+        
+        let center = NSWorkspace.shared.notificationCenter
+        workspaceObservers.forEach { center.removeObserver($0) }
+        workspaceObservers.removeAll()
+    }
+    
+    // Coalesces bursts (an Electron app spawns dozens of helpers) into one scan.
+    // Called from the watcher thread; once stopped, the scheduler ignores the
+    // trigger because the phase is no longer registered.
+    private func scheduleEventScan() {
+        scheduler.trigger("basic", after: eventScanDelay)
+    }
+    
     // MARK: - Public Access to Internal Services
     
     var getNetworkMonitor: NetworkMonitor {
@@ -107,74 +206,56 @@ class ProcessMonitor: ObservableObject {
         return isActive
     }
     
-    private func checkBasicForbiddenApps() {
+    private func checkBasicForbiddenApps(snapshot sharedSnapshot: ScanSnapshot?) {
         var detected: [String] = []
         
-        // Check forbidden apps (existing functionality)
-        var processes: UnsafeMutablePointer<SystemProcessInfo>?
-        let processCount = getAllProcesses(&processes)
-        
-        if processCount > 0, let processArray = processes {
-            for i in 0..<Int(processCount) {
-                let process = processArray[i]
-                let processName = withUnsafeBytes(of: process.name) { bytes in
-                    String(cString: bytes.bindMemory(to: CChar.self).baseAddress!)
+        // Check forbidden apps (existing functionality) against the tick's snapshot,
+        // one automaton pass per name and path for all rules
+        let matcher = forbiddenAppMatcher
+        if !matcher.isEmpty, let snapshot = sharedSnapshot ?? ScanSnapshot.capture() {
+            // Apps first, then bundled helpers, so a helper is only reported when its app wasn't
+            var matchedPids = Set<pid_t>()
+            let ordered = snapshot.filter { !$0.isBundledHelper } + snapshot.filter { $0.isBundledHelper }
+            for process in ordered {
+                if process.isBundledHelper && matchedPids.contains(process.root.pid) {
+                    continue
                 }
-                let processPath = withUnsafeBytes(of: process.path) { bytes in
-                    String(cString: bytes.bindMemory(to: CChar.self).baseAddress!)
+                
+                // Matched on the snapshot's borrowed bytes; Strings only for hits
+                let nameMatches = matcher.allMatches(in: process.nameBytes)
+                if !nameMatches.isEmpty {
+                    detected.append("\(process.name) (PID: \(process.pid))")
+                    matchedPids.insert(process.pid)
                 }
-                let pid = process.pid
                 
-                // Check against forbidden app names
-                for forbiddenName in forbiddenAppNames {
-                    let forbiddenLower = forbiddenName.lowercased()
-                    
-                    // Check process name
-                    if processName.lowercased().contains(forbiddenLower) {
-                        detected.append("\(processName) (PID: \(pid))")
-                        continue
-                    }
-                    
-                    // Check process path
-                    if !processPath.isEmpty && processPath.lowercased().contains(forbiddenLower) {
-                        detected.append("\(processName) (Path: \(processPath))")
-                        continue
-                    }
-                    
-                    // Check if path contains app bundle
-                    if processPath.lowercased().contains("/\(forbiddenLower).app/") {
-                        detected.append("\(processName) (App: \(forbiddenName))")
+                // Check process path (including app bundles) for rules the name didn't match
+                if process.hasPath {
+                    let pathMatches = matcher.allMatches(in: process.pathBytes)
+                    if pathMatches.contains(where: { !nameMatches.contains($0) }) {
+                        detected.append("\(process.name) (Path: \(process.path))")
+                        matchedPids.insert(process.pid)
                     }
                 }
             }
-            
-            // Free the allocated memory
-            freeProcessList(processArray)
         }
         
         // Also check NSWorkspace for GUI applications
         let runningApps = NSWorkspace.shared.runningApplications
-        for app in runningApps {
+        for app in runningApps where !matcher.isEmpty {
             guard let appName = app.localizedName else { continue }
             
-            for forbiddenName in forbiddenAppNames {
-                if appName.lowercased().contains(forbiddenName.lowercased()) {
-                    let entry = "\(appName) (GUI App - PID: \(app.processIdentifier))"
-                    if !detected.contains(entry) {
-                        detected.append(entry)
-                    }
+            if matcher.matches(appName.lowercased()) {
+                let entry = "\(appName) (GUI App - PID: \(app.processIdentifier))"
+                if !detected.contains(entry) {
+                    detected.append(entry)
                 }
             }
             
             // Check bundle identifier
-            if let bundleId = app.bundleIdentifier {
-                for forbiddenName in forbiddenAppNames {
-                    if bundleId.lowercased().contains(forbiddenName.lowercased()) {
-                        let entry = "\(appName) (Bundle: \(bundleId))"
-                        if !detected.contains(entry) {
-                            detected.append(entry)
-                        }
-                    }
+            if let bundleId = app.bundleIdentifier, matcher.matches(bundleId.lowercased()) {
+                let entry = "\(appName) (Bundle: \(bundleId))"
+                if !detected.contains(entry) {
+                    detected.append(entry)
                 }
             }
         }
@@ -187,6 +268,12 @@ class ProcessMonitor: ObservableObject {
         // Log any active LLM network connections alongside forbidden apps
         logActiveNetworkConnections()
         
+        let detectedSet = Set(detected)
+        if !detectedSet.isSubset(of: reportedForbiddenApps) {
+            scheduler.reportDetection()
+        }
+        reportedForbiddenApps = detectedSet
+        
         DispatchQueue.main.async {
             if detected != self.detectedForbiddenApps {
                 self.detectedForbiddenApps = Array(Set(detected))
@@ -194,13 +281,19 @@ class ProcessMonitor: ObservableObject {
         }
     }
     
-    private func checkAdvancedSuspiciousProcesses() {
+    private func checkAdvancedSuspiciousProcesses(snapshot: ScanSnapshot?) {
         // Check for suspicious processes (legacy functionality)
-        let (suspiciousResults, newAlertedPids) = suspiciousDetector.detectSuspiciousProcesses()
+        let (suspiciousResults, newAlertedPids) = suspiciousDetector.detectSuspiciousProcesses(snapshot: snapshot)
         suspiciousDetector.updateLastAlertedPids(newAlertedPids)
         
         // Check for advanced suspicious processes (new functionality)
-        let advancedResults = suspiciousDetector.detectAdvancedSuspiciousProcesses()
+        let advancedResults = suspiciousDetector.detectAdvancedSuspiciousProcesses(snapshot: snapshot)
+        
+        let suspiciousPids = Set(suspiciousResults.map { $0.pid } + advancedResults.filter { $0.confidence == .definitive }.map { $0.pid })
+        if !suspiciousPids.isSubset(of: reportedSuspiciousPids) {
+            scheduler.reportDetection()
+        }
+        reportedSuspiciousPids = suspiciousPids
         
         DispatchQueue.main.async {
             if suspiciousResults != self.suspiciousProcesses {
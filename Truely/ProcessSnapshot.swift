@@ -0,0 +1,267 @@
+import Foundation
+
+// Swift accessors for the C bridge's ProcessSnapshot. Records are small and
+// fixed size; names and paths are decoded from the shared string arena only
+// when asked for.
+extension ProcessSnapshot {
+    var records: UnsafeBufferPointer<SystemProcessInfo> {
+        UnsafeBufferPointer(start: processes, count: Int(max(count, 0)))
+    }
+    
+    func name(of process: SystemProcessInfo) -> String {
+        String(decoding: nameBytes(of: process), as: UTF8.self)
+    }
+    
+    func path(of process: SystemProcessInfo) -> String {
+        String(decoding: pathBytes(of: process), as: UTF8.self)
+    }
+    
+    // Borrowed UTF-8 bytes (no terminator), valid until the snapshot is freed
+    func nameBytes(of process: SystemProcessInfo) -> UnsafeBufferPointer<UInt8> {
+        bytes(at: process.nameOffset, length: process.nameLength)
+    }
+    
+    func pathBytes(of process: SystemProcessInfo) -> UnsafeBufferPointer<UInt8> {
+        bytes(at: process.pathOffset, length: process.pathLength)
+    }
+    
+    private func bytes(at offset: UInt32, length: UInt16) -> UnsafeBufferPointer<UInt8> {
+        guard length > 0, let strings = strings, Int(offset) + Int(length) < stringsSize else { return UnsafeBufferPointer(start: nil, count: 0) }
+        let start = UnsafeRawPointer(strings + Int(offset)).assumingMemoryBound(to: UInt8.self)
+        return UnsafeBufferPointer(start: start, count: Int(length))
+    }
+}
+
+extension ProcessDelta {
+    var records: UnsafeBufferPointer<ProcessChange> {
+        UnsafeBufferPointer(start: changes, count: Int(max(count, 0)))
+    }
+    
+    func name(of process: SystemProcessInfo) -> String {
+        string(at: process.nameOffset, length: process.nameLength)
+    }
+    
+    func path(of process: SystemProcessInfo) -> String {
+        string(at: process.pathOffset, length: process.pathLength)
+    }
+    
+    private func string(at offset: UInt32, length: UInt16) -> String {
+        guard length > 0, let strings = strings, Int(offset) + Int(length) < stringsSize else { return "" }
+        let bytes = UnsafeRawBufferPointer(start: UnsafeRawPointer(strings + Int(offset)), count: Int(length))
+        return String(decoding: bytes, as: UTF8.self)
+    }
+}
+
+extension CodeSigningIdentity {
+    var cdHashString: String { Self.string(from: cdHash) }
+    var signingIdentifierString: String { Self.string(from: signingIdentifier) }
+    var teamIdentifierString: String { Self.string(from: teamIdentifier) }
+    
+    // Fixed-size C arrays import as tuples; read up to the null terminator
+    private static func string<T>(from tuple: T) -> String {
+        withUnsafeBytes(of: tuple) { bytes in
+            String(decoding: bytes.prefix { $0 != 0 }, as: UTF8.self)
+        }
+    }
+}
+
+extension SocketSnapshot {
+    var records: UnsafeBufferPointer<SocketConnectionInfo> {
+        UnsafeBufferPointer(start: connections, count: Int(max(count, 0)))
+    }
+}
+
+extension ConnectionDelta {
+    var records: UnsafeBufferPointer<ConnectionChange> {
+        UnsafeBufferPointer(start: changes, count: Int(max(count, 0)))
+    }
+}
+
+extension WindowEventDelta {
+    var records: UnsafeBufferPointer<WindowEvent> {
+        UnsafeBufferPointer(start: events, count: Int(max(count, 0)))
+    }
+}
+
+extension SocketConnectionInfo {
+    var localAddressString: String { Self.string(from: localAddress, family: family) }
+    var remoteAddressString: String { Self.string(from: remoteAddress, family: family) }
+    
+    private static func string<T>(from address: T, family: UInt8) -> String {
+        withUnsafeBytes(of: address) { bytes in
+            var buffer = [CChar](repeating: 0, count: Int(INET6_ADDRSTRLEN))
+            guard inet_ntop(Int32(family), bytes.baseAddress, &buffer, socklen_t(buffer.count)) != nil else { return "" }
+            return String(cString: buffer)
+        }
+    }
+}
+
+// One process in a ScanSnapshot. A view into the snapshot's buffers: the
+// record and the name/path bytes are borrowed, and Strings are only built
+// when name or path is read (typically for the few processes that match).
+struct ScannedProcess {
+    private let owner: ScanSnapshot         // keeps the borrowed buffers alive
+    private let record: UnsafePointer<SystemProcessInfo>
+    
+    fileprivate init(owner: ScanSnapshot, record: UnsafePointer<SystemProcessInfo>) {
+        self.owner = owner
+        self.record = record
+    }
+    
+    var info: SystemProcessInfo { record.pointee }
+    var pid: pid_t { record.pointee.pid }
+    var parentPid: pid_t { record.pointee.parentPid }
+    
+    var nameBytes: UnsafeBufferPointer<UInt8> { owner.snapshot.nameBytes(of: record.pointee) }
+    var pathBytes: UnsafeBufferPointer<UInt8> { owner.snapshot.pathBytes(of: record.pointee) }
+    
+    var name: String { String(decoding: nameBytes, as: UTF8.self) }
+    var path: String { String(decoding: pathBytes, as: UTF8.self) }
+    var hasPath: Bool { record.pointee.pathLength > 0 }
+    
+    func nameEquals(_ other: String) -> Bool {
+        nameBytes.elementsEqual(other.utf8)
+    }
+    
+    // Topmost app this process belongs to (itself for an app or a daemon)
+    var root: ScannedProcess { owner[owner.rootIndex(of: record)] }
+    var parent: ScannedProcess? { owner.process(pid: parentPid) }
+    
+    // A helper shipped inside its root app's bundle (Electron/Chromium
+    // "Helper (Renderer)" and friends). Its binary, signature and name come
+    // with the app, so detection attributes it to the root instead.
+    var isBundledHelper: Bool { owner.isBundledHelper(at: owner.position(of: record)) }
+}
+
+// Immutable process table walk shared by everything that runs in a scheduler
+// tick. The bridge buffers are never written after capture, so the snapshot
+// can be read from any queue; they are freed when the last reader lets go.
+// Iterating yields ScannedProcess views without copying records or strings.
+// A process tree is indexed at capture: parent and root lookups are O(1).
+final class ScanSnapshot: RandomAccessCollection {
+    fileprivate let snapshot: ProcessSnapshot
+    let capturedAt: Date
+    private let indexByPid: [pid_t: Int]
+    private let rootIndexes: [Int]
+    private let bundledHelpers: [Bool]
+    
+    private init(snapshot: ProcessSnapshot) {
+        self.snapshot = snapshot
+        self.capturedAt = Date()
+        
+        let records = snapshot.records
+        var indexByPid: [pid_t: Int] = [:]
+        indexByPid.reserveCapacity(records.count)
+        for (index, record) in records.enumerated() {
+            indexByPid[record.pid] = index
+        }
+        self.indexByPid = indexByPid
+        
+        let roots = Self.resolveRoots(records, indexByPid: indexByPid)
+        var bundledHelpers = [Bool](repeating: false, count: records.count)
+        for index in records.indices where roots[index] != index {
+            bundledHelpers[index] = Self.isInsideBundle(records[index], of: records[roots[index]], in: snapshot)
+        }
+        self.rootIndexes = roots
+        self.bundledHelpers = bundledHelpers
+    }
+    
+    deinit {
+        var snapshot = self.snapshot
+        freeProcessSnapshot(&snapshot)
+    }
+    
+    // maxAgeMilliseconds > 0 reuses a bridge scan that recent (see getAllProcessesWithMaxAge)
+    static func capture(maxAgeMilliseconds: UInt32 = 0) -> ScanSnapshot? {
+        var snapshot = ProcessSnapshot()
+        guard getAllProcessesWithMaxAge(&snapshot, maxAgeMilliseconds) >= 0 else { return nil }
+        return ScanSnapshot(snapshot: snapshot)
+    }
+    
+    // Takes ownership of a snapshot built outside the bridge (benchmark
+    // fixtures); its buffers must be malloc'd, as freeProcessSnapshot frees them
+    static func adopting(_ snapshot: ProcessSnapshot) -> ScanSnapshot {
+        ScanSnapshot(snapshot: snapshot)
+    }
+    
+    var startIndex: Int { 0 }
+    var endIndex: Int { Int(max(snapshot.count, 0)) }
+    
+    subscript(position: Int) -> ScannedProcess {
+        ScannedProcess(owner: self, record: UnsafePointer(snapshot.processes + position))
+    }
+    
+    func process(pid: pid_t) -> ScannedProcess? {
+        indexByPid[pid].map { self[$0] }
+    }
+    
+    fileprivate func position(of record: UnsafePointer<SystemProcessInfo>) -> Int {
+        UnsafePointer(snapshot.processes).distance(to: record)
+    }
+    
+    fileprivate func rootIndex(of record: UnsafePointer<SystemProcessInfo>) -> Int {
+        rootIndexes[position(of: record)]
+    }
+    
+    fileprivate func isBundledHelper(at index: Int) -> Bool {
+        bundledHelpers[index]
+    }
+    
+    // MARK: - Process Tree
+    
+    // The responsible pid (what TCC attributes the process to) wins when it is
+    // in the table; otherwise the parent chain is followed up to just below
+    // launchd. Roots are memoized, so the whole table resolves in O(n).
+    private static func resolveRoots(_ records: UnsafeBufferPointer<SystemProcessInfo>, indexByPid: [pid_t: Int]) -> [Int] {
+        var roots = [Int](repeating: -1, count: records.count)
+        var chain: [Int] = []
+        
+        for start in records.indices where roots[start] < 0 {
+            var current = start
+            chain.removeAll(keepingCapacity: true)
+            
+            while roots[current] < 0 {
+                let record = records[current]
+                if record.responsiblePid > 1, record.responsiblePid != record.pid,
+                   let responsible = indexByPid[record.responsiblePid], !chain.contains(responsible) {
+                    chain.append(current)
+                    current = responsible
+                } else if record.parentPid > 1, record.parentPid != record.pid,
+                          let parent = indexByPid[record.parentPid], !chain.contains(parent) {
+                    chain.append(current)
+                    current = parent
+                } else {
+                    // Child of launchd, orphan, or a cycle from a recycled pid
+                    roots[current] = current
+                }
+            }
+            
+            let root = roots[current]
+            for index in chain {
+                roots[index] = root
+            }
+        }
+        return roots
+    }
+    
+    // Electron/Chromium helpers live under the app's bundle, e.g.
+    // Foo.app/Contents/Frameworks/Foo Helper (Renderer).app/...
+    private static func isInsideBundle(_ process: SystemProcessInfo, of root: SystemProcessInfo, in snapshot: ProcessSnapshot) -> Bool {
+        let rootPath = snapshot.pathBytes(of: root)
+        let path = snapshot.pathBytes(of: process)
+        guard let bundleEnd = appBundleEnd(in: rootPath), path.count > bundleEnd else { return false }
+        return path.prefix(bundleEnd).elementsEqual(rootPath.prefix(bundleEnd))
+    }
+    
+    // Length of the outermost "something.app/" prefix, if the path has one
+    private static func appBundleEnd(in path: UnsafeBufferPointer<UInt8>) -> Int? {
+        let marker = Array(".app/".utf8)
+        guard path.count >= marker.count else { return nil }
+        for start in 0...(path.count - marker.count) where path[start] == UInt8(ascii: ".") {
+            if path[start..<(start + marker.count)].elementsEqual(marker) {
+                return start + marker.count
+            }
+        }
+        return nil
+    }
+}
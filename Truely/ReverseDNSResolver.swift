@@ -0,0 +1,205 @@
+import Foundation
+import Darwin
+
+// Non-blocking PTR lookups for NetworkMonitor. Callers get whatever is cached
+// right away; misses are resolved in the background with getnameinfo (which,
+// unlike gethostbyaddr, is thread-safe) and reported through onResolved.
+final class ReverseDNSResolver {
+    // Called on a background queue with (ip, name) when a lookup finds a name.
+    // Can be set from any thread; lookups read it under the lock.
+    var onResolved: ((String, String) -> Void)? {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return resolvedHandler
+        }
+        set {
+            lock.lock()
+            resolvedHandler = newValue
+            lock.unlock()
+        }
+    }
+    
+    private let capacity: Int
+    private let positiveTTL: TimeInterval
+    private let negativeTTL: TimeInterval
+    private let maxConcurrentLookups: Int
+    
+    private final class Entry {
+        let ip: String
+        var name: String?       // nil = no usable PTR record (negative entry)
+        var expiry: Date
+        var previous: Entry?
+        var next: Entry?
+        
+        init(ip: String, name: String?, expiry: Date) {
+            self.ip = ip
+            self.name = name
+            self.expiry = expiry
+        }
+    }
+    
+    // LRU cache: most recently used at head
+    private var entries: [String: Entry] = [:]
+    private var head: Entry?
+    private var tail: Entry?
+    
+    private var pendingLookups: [String] = []
+    private var queuedLookups: Set<String> = []     // pending or in flight
+    private var activeLookups = 0
+    private var resolvedHandler: ((String, String) -> Void)?
+    private let lock = NSLock()
+    private let lookupQueue = DispatchQueue(label: "com.truely.reversedns", qos: .utility, attributes: .concurrent)
+    
+    init(capacity: Int = 4096, positiveTTL: TimeInterval = 600, negativeTTL: TimeInterval = 120, maxConcurrentLookups: Int = 4) {
+        self.capacity = capacity
+        self.positiveTTL = positiveTTL
+        self.negativeTTL = negativeTTL
+        self.maxConcurrentLookups = maxConcurrentLookups
+    }
+    
+    // Returns the cached name, or nil while unresolved or without a PTR
+    // record. A miss or an expired entry schedules a lookup.
+    func cachedName(for ip: String) -> String? {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        if let entry = entries[ip] {
+            ScanTelemetry.shared.count(.dnsCacheHits)
+            moveToHead(entry)
+            if entry.expiry < Date() {
+                scheduleLookupLocked(ip)
+            }
+            // Serve the stale name until the refresh lands
+            return entry.name
+        }
+        
+        scheduleLookupLocked(ip)
+        return nil
+    }
+    
+    func removeAll() {
+        lock.lock()
+        entries.removeAll()
+        head = nil
+        tail = nil
+        pendingLookups.removeAll()
+        queuedLookups.removeAll()
+        lock.unlock()
+    }
+    
+    // MARK: - Lookups
+    
+    private func scheduleLookupLocked(_ ip: String) {
+        guard !queuedLookups.contains(ip) else { return }
+        queuedLookups.insert(ip)
+        pendingLookups.append(ip)
+        startLookupsLocked()
+    }
+    
+    private func startLookupsLocked() {
+        while activeLookups < maxConcurrentLookups && !pendingLookups.isEmpty {
+            let ip = pendingLookups.removeFirst()
+            activeLookups += 1
+            lookupQueue.async {
+                ScanTelemetry.shared.count(.dnsLookups)
+                let name = Self.reverseLookup(ip)
+                self.finishLookup(ip, name: name)
+            }
+        }
+    }
+    
+    private func finishLookup(_ ip: String, name: String?) {
+        lock.lock()
+        activeLookups -= 1
+        queuedLookups.remove(ip)
+        
+        let expiry = Date().addingTimeInterval(name != nil ? positiveTTL : negativeTTL)
+        let previousName = entries[ip]?.name
+        store(ip, name: name, expiry: expiry)
+        startLookupsLocked()
+        let callback = resolvedHandler
+        lock.unlock()
+        
+        if let name = name, name != previousName {
+            callback?(ip, name)
+        }
+    }
+    
+    private static func reverseLookup(_ ip: String) -> String? {
+        var host = [CChar](repeating: 0, count: Int(NI_MAXHOST))
+        var status: Int32 = -1
+        
+        var address4 = sockaddr_in()
+        var address6 = sockaddr_in6()
+        if inet_pton(AF_INET, ip, &address4.sin_addr) == 1 {
+            address4.sin_family = sa_family_t(AF_INET)
+            address4.sin_len = UInt8(MemoryLayout<sockaddr_in>.size)
+            status = withUnsafePointer(to: &address4) {
+                $0.withMemoryRebound(to: sockaddr.self, capacity: 1) {
+                    getnameinfo($0, socklen_t(MemoryLayout<sockaddr_in>.size), &host, socklen_t(host.count), nil, 0, NI_NAMEREQD)
+                }
+            }
+        } else if inet_pton(AF_INET6, ip, &address6.sin6_addr) == 1 {
+            address6.sin6_family = sa_family_t(AF_INET6)
+            address6.sin6_len = UInt8(MemoryLayout<sockaddr_in6>.size)
+            status = withUnsafePointer(to: &address6) {
+                $0.withMemoryRebound(to: sockaddr.self, capacity: 1) {
+                    getnameinfo($0, socklen_t(MemoryLayout<sockaddr_in6>.size), &host, socklen_t(host.count), nil, 0, NI_NAMEREQD)
+                }
+            }
+        }
+        
+        guard status == 0 else { return nil }
+        
+        // Only return if it's a meaningful domain (not just reverse IP)
+        let domain = String(cString: host)
+        guard domain.contains("."), !domain.hasSuffix(".in-addr.arpa"), !domain.hasSuffix(".ip6.arpa") else { return nil }
+        return domain
+    }
+    
+    // MARK: - LRU
+    
+    private func store(_ ip: String, name: String?, expiry: Date) {
+        if let entry = entries[ip] {
+            entry.name = name
+            entry.expiry = expiry
+            moveToHead(entry)
+            return
+        }
+        
+        let entry = Entry(ip: ip, name: name, expiry: expiry)
+        entries[ip] = entry
+        insertAtHead(entry)
+        
+        if entries.count > capacity, let oldest = tail {
+            unlink(oldest)
+            entries.removeValue(forKey: oldest.ip)
+        }
+    }
+    
+    private func moveToHead(_ entry: Entry) {
+        guard head !== entry else { return }
+        unlink(entry)
+        insertAtHead(entry)
+    }
+    
+    private func insertAtHead(_ entry: Entry) {
+        entry.previous = nil
+        entry.next = head
+        head?.previous = entry
+        head = entry
+        if tail == nil {
+            tail = entry
+        }
+    }
+    
+    private func unlink(_ entry: Entry) {
+        entry.previous?.next = entry.next
+        entry.next?.previous = entry.previous
+        if head === entry { head = entry.next }
+        if tail === entry { tail = entry.previous }
+        entry.previous = nil
+        entry.next = nil
+    }
+}
@@ -0,0 +1,203 @@
+import Foundation
+import os
+
+// Per-interval scan cost, uploaded with the detection log so scan CPU and
+// latency can be compared across the fleet by macOS version. Bridge fields
+// are deltas of getBridgeMetrics since the previous report.
+struct ScanMetrics: Codable {
+    let intervalMs: Int64
+    let osVersion: String
+    let cpuMs: Int64                    // this process, user + system
+    
+    let processScans: UInt64
+    let sharedScans: UInt64
+    let processesScanned: UInt64
+    let processesResolved: UInt64
+    let scanMs: Double
+    let sysctlMs: Double
+    let resolveMs: Double
+    let windowCopies: UInt64
+    let windowCopyMs: Double
+    let socketScans: UInt64
+    let socketScanMs: Double
+    let hashCacheHits: UInt64
+    let hashCacheMisses: UInt64
+    let filesHashed: UInt64
+    let bytesHashed: UInt64
+    let hashMs: Double
+    
+    let basicPasses: Int
+    let basicPassMs: Double
+    let advancedPasses: Int
+    let advancedPassMs: Double
+    let advancedProcessesExamined: Int
+    let networkPasses: Int
+    let networkPassMs: Double
+    let dnsLookups: Int
+    let dnsCacheHits: Int
+    
+    enum CodingKeys: String, CodingKey {
+        case intervalMs = "interval_ms"
+        case osVersion = "os_version"
+        case cpuMs = "cpu_ms"
+        case processScans = "process_scans"
+        case sharedScans = "shared_scans"
+        case processesScanned = "processes_scanned"
+        case processesResolved = "processes_resolved"
+        case scanMs = "scan_ms"
+        case sysctlMs = "sysctl_ms"
+        case resolveMs = "resolve_ms"
+        case windowCopies = "window_copies"
+        case windowCopyMs = "window_copy_ms"
+        case socketScans = "socket_scans"
+        case socketScanMs = "socket_scan_ms"
+        case hashCacheHits = "hash_cache_hits"
+        case hashCacheMisses = "hash_cache_misses"
+        case filesHashed = "files_hashed"
+        case bytesHashed = "bytes_hashed"
+        case hashMs = "hash_ms"
+        case basicPasses = "basic_passes"
+        case basicPassMs = "basic_pass_ms"
+        case advancedPasses = "advanced_passes"
+        case advancedPassMs = "advanced_pass_ms"
+        case advancedProcessesExamined = "advanced_processes_examined"
+        case networkPasses = "network_passes"
+        case networkPassMs = "network_pass_ms"
+        case dnsLookups = "dns_lookups"
+        case dnsCacheHits = "dns_cache_hits"
+    }
+}
+
+// Signposts and counters for the Swift side of a scan. Detector passes are
+// os_signpost intervals (subsystem com.truely, category Detection) next to the
+// bridge's own; takeMetrics() folds both into one ScanMetrics per interval.
+final class ScanTelemetry {
+    static let shared = ScanTelemetry()
+    
+    enum Pass {
+        case basic
+        case advanced
+        case network
+    }
+    
+    enum Counter {
+        case advancedProcessesExamined
+        case dnsLookups
+        case dnsCacheHits
+    }
+    
+    private struct PassTotals {
+        var count = 0
+        var nanoseconds: UInt64 = 0
+    }
+    
+    private let signposter = OSSignposter(subsystem: "com.truely", category: "Detection")
+    private let lock = NSLock()
+    
+    // Only touched under lock
+    private var passes: [Pass: PassTotals] = [:]
+    private var counters: [Counter: Int] = [:]
+    private var lastBridgeMetrics = BridgeMetrics()
+    private var lastCPUMicroseconds = ScanTelemetry.cpuMicroseconds()
+    private var lastReport = DispatchTime.now().uptimeNanoseconds
+    
+    private static let osVersion = ProcessInfo.processInfo.operatingSystemVersionString
+    
+    private init() {
+        getBridgeMetrics(&lastBridgeMetrics)
+    }
+    
+    // Runs body as a signposted interval and adds its duration to the pass totals
+    func measure<T>(_ pass: Pass, _ body: () throws -> T) rethrows -> T {
+        let name: StaticString
+        switch pass {
+        case .basic: name = "BasicPass"
+        case .advanced: name = "AdvancedPass"
+        case .network: name = "NetworkPass"
+        }
+        
+        let state = signposter.beginInterval(name, id: signposter.makeSignpostID())
+        let start = DispatchTime.now().uptimeNanoseconds
+        defer {
+            let elapsed = DispatchTime.now().uptimeNanoseconds - start
+            signposter.endInterval(name, state)
+            
+            lock.lock()
+            passes[pass, default: PassTotals()].count += 1
+            passes[pass, default: PassTotals()].nanoseconds += elapsed
+            lock.unlock()
+        }
+        return try body()
+    }
+    
+    func count(_ counter: Counter, by amount: Int = 1) {
+        guard amount != 0 else { return }
+        lock.lock()
+        counters[counter, default: 0] += amount
+        lock.unlock()
+    }
+    
+    // Costs since the previous call; starts the next interval
+    func takeMetrics() -> ScanMetrics {
+        var bridge = BridgeMetrics()
+        getBridgeMetrics(&bridge)
+        let now = DispatchTime.now().uptimeNanoseconds
+        let cpu = Self.cpuMicroseconds()
+        
+        lock.lock()
+        let previous = lastBridgeMetrics
+        let passes = self.passes
+        let counters = self.counters
+        let intervalNanoseconds = now >= lastReport ? now - lastReport : 0
+        let cpuMicroseconds = cpu >= lastCPUMicroseconds ? cpu - lastCPUMicroseconds : 0
+        lastBridgeMetrics = bridge
+        lastReport = now
+        lastCPUMicroseconds = cpu
+        self.passes.removeAll()
+        self.counters.removeAll()
+        lock.unlock()
+        
+        func ms(_ nanoseconds: UInt64) -> Double {
+            (Double(nanoseconds) / 1_000_000 * 100).rounded() / 100
+        }
+        
+        return ScanMetrics(
+            intervalMs: Int64(intervalNanoseconds / 1_000_000),
+            osVersion: Self.osVersion,
+            cpuMs: Int64(cpuMicroseconds / 1000),
+            processScans: bridge.processScans &- previous.processScans,
+            sharedScans: bridge.sharedScans &- previous.sharedScans,
+            processesScanned: bridge.processesScanned &- previous.processesScanned,
+            processesResolved: bridge.processesResolved &- previous.processesResolved,
+            scanMs: ms(bridge.scanNanoseconds &- previous.scanNanoseconds),
+            sysctlMs: ms(bridge.sysctlNanoseconds &- previous.sysctlNanoseconds),
+            resolveMs: ms(bridge.resolveNanoseconds &- previous.resolveNanoseconds),
+            windowCopies: bridge.windowCopies &- previous.windowCopies,
+            windowCopyMs: ms(bridge.windowCopyNanoseconds &- previous.windowCopyNanoseconds),
+            socketScans: bridge.socketScans &- previous.socketScans,
+            socketScanMs: ms(bridge.socketScanNanoseconds &- previous.socketScanNanoseconds),
+            hashCacheHits: bridge.hashCacheHits &- previous.hashCacheHits,
+            hashCacheMisses: bridge.hashCacheMisses &- previous.hashCacheMisses,
+            filesHashed: bridge.filesHashed &- previous.filesHashed,
+            bytesHashed: bridge.bytesHashed &- previous.bytesHashed,
+            hashMs: ms(bridge.hashNanoseconds &- previous.hashNanoseconds),
+            basicPasses: passes[.basic]?.count ?? 0,
+            basicPassMs: ms(passes[.basic]?.nanoseconds ?? 0),
+            advancedPasses: passes[.advanced]?.count ?? 0,
+            advancedPassMs: ms(passes[.advanced]?.nanoseconds ?? 0),
+            advancedProcessesExamined: counters[.advancedProcessesExamined] ?? 0,
+            networkPasses: passes[.network]?.count ?? 0,
+            networkPassMs: ms(passes[.network]?.nanoseconds ?? 0),
+            dnsLookups: counters[.dnsLookups] ?? 0,
+            dnsCacheHits: counters[.dnsCacheHits] ?? 0
+        )
+    }
+    
+    private static func cpuMicroseconds() -> UInt64 {
+        var usage = rusage()
+        guard getrusage(RUSAGE_SELF, &usage) == 0 else { return 0 }
+        let user = UInt64(usage.ru_utime.tv_sec) * 1_000_000 + UInt64(usage.ru_utime.tv_usec)
+        let system = UInt64(usage.ru_stime.tv_sec) * 1_000_000 + UInt64(usage.ru_stime.tv_usec)
+        return user + system
+    }
+}
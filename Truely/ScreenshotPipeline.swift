@@ -0,0 +1,193 @@
+import Foundation
+import CoreGraphics
+import ImageIO
+import UniformTypeIdentifiers
+
+// Screenshot encoding off the main thread. Frames are downsampled to a
+// bounded size, compared tile by tile against the last frame that went out,
+// and encoded once as HEIC through ImageIO, which uses the hardware HEVC
+// encoder where the Mac has one.
+final class ScreenshotPipeline {
+    struct EncodedScreenshot {
+        let data: Data
+        let fileExtension: String       // "heic", or "jpg" where HEIC encoding is unavailable
+        let pixelWidth: Int
+        let pixelHeight: Int
+        let changedTiles: Int
+        let totalTiles: Int
+    }
+    
+    enum Outcome {
+        case encoded(EncodedScreenshot)
+        case unchanged(totalTiles: Int)
+        case failed
+    }
+    
+    private let maxPixelDimension: Int
+    private let quality: Double
+    private let maxConsecutiveSkips: Int
+    private let queue = DispatchQueue(label: "com.truely.screenshotpipeline", qos: .utility)
+    
+    // Change detection runs on a small luminance thumbnail cut into square tiles;
+    // quantizing to 32 levels keeps compression noise from counting as a change
+    private static let hashWidth = 256
+    private static let tileSize = 16
+    private static let luminanceShift: UInt8 = 3
+    
+    // Only touched on queue
+    private var lastTileHashes: [UInt64] = []
+    private var consecutiveSkips = 0
+    
+    init(maxPixelDimension: Int = 2560, quality: Double = 0.5, maxConsecutiveSkips: Int = 4) {
+        self.maxPixelDimension = max(maxPixelDimension, 256)
+        self.quality = quality
+        self.maxConsecutiveSkips = maxConsecutiveSkips
+    }
+    
+    // With skipUnchanged, `reference` (the capture without the cursor, so pointer
+    // movement alone is not a change) is hashed and the frame is dropped when no
+    // tile differs from the last encoded one. At most maxConsecutiveSkips frames
+    // are dropped in a row so the server still sees a periodic frame.
+    // Completion runs on the main queue.
+    func process(frame: CGImage, reference: CGImage? = nil, skipUnchanged: Bool, completion: @escaping (Outcome) -> Void) {
+        queue.async {
+            let outcome = self.run(frame: frame, reference: reference ?? frame, skipUnchanged: skipUnchanged)
+            DispatchQueue.main.async {
+                completion(outcome)
+            }
+        }
+    }
+    
+    // Forgets the last uploaded frame so the next one is always encoded
+    func resetChangeTracking() {
+        queue.async {
+            self.lastTileHashes = []
+            self.consecutiveSkips = 0
+        }
+    }
+    
+    private func run(frame: CGImage, reference: CGImage, skipUnchanged: Bool) -> Outcome {
+        var hashes: [UInt64] = []
+        var changedTiles = 0
+        
+        if skipUnchanged {
+            hashes = Self.tileHashes(of: reference)
+            changedTiles = Self.changedTileCount(hashes, lastTileHashes)
+            
+            if changedTiles == 0, !hashes.isEmpty, consecutiveSkips < maxConsecutiveSkips {
+                consecutiveSkips += 1
+                return .unchanged(totalTiles: hashes.count)
+            }
+        }
+        
+        let scaled = downsample(frame)
+        guard let encoded = encode(scaled) else { return .failed }
+        
+        if skipUnchanged {
+            lastTileHashes = hashes
+            consecutiveSkips = 0
+        }
+        
+        return .encoded(EncodedScreenshot(
+            data: encoded.data,
+            fileExtension: encoded.fileExtension,
+            pixelWidth: scaled.width,
+            pixelHeight: scaled.height,
+            changedTiles: changedTiles,
+            totalTiles: hashes.count
+        ))
+    }
+    
+    // MARK: - Downsampling
+    
+    // Caps the long edge using high-quality interpolation, which keeps small
+    // text readable where nearest/bilinear scaling would alias it
+    private func downsample(_ image: CGImage) -> CGImage {
+        let longEdge = max(image.width, image.height)
+        guard longEdge > maxPixelDimension else { return image }
+        
+        let scale = Double(maxPixelDimension) / Double(longEdge)
+        let width = max(Int((Double(image.width) * scale).rounded()), 1)
+        let height = max(Int((Double(image.height) * scale).rounded()), 1)
+        
+        guard let context = CGContext(
+            data: nil,
+            width: width,
+            height: height,
+            bitsPerComponent: 8,
+            bytesPerRow: 0,
+            space: image.colorSpace ?? CGColorSpaceCreateDeviceRGB(),
+            bitmapInfo: CGImageAlphaInfo.noneSkipLast.rawValue
+        ) else { return image }
+        
+        context.interpolationQuality = .high
+        context.draw(image, in: CGRect(x: 0, y: 0, width: width, height: height))
+        return context.makeImage() ?? image
+    }
+    
+    // MARK: - Tile Hashing
+    
+    private static func tileHashes(of image: CGImage) -> [UInt64] {
+        guard image.width > 0, image.height > 0 else { return [] }
+        let width = hashWidth
+        let height = max(Int((Double(image.height) * Double(width) / Double(image.width)).rounded()), 1)
+        
+        guard let context = CGContext(
+            data: nil,
+            width: width,
+            height: height,
+            bitsPerComponent: 8,
+            bytesPerRow: width,
+            space: CGColorSpaceCreateDeviceGray(),
+            bitmapInfo: CGImageAlphaInfo.none.rawValue
+        ) else { return [] }
+        
+        context.interpolationQuality = .medium
+        context.draw(image, in: CGRect(x: 0, y: 0, width: width, height: height))
+        guard let data = context.data else { return [] }
+        let pixels = data.assumingMemoryBound(to: UInt8.self)
+        let bytesPerRow = context.bytesPerRow
+        
+        let columns = (width + tileSize - 1) / tileSize
+        let rows = (height + tileSize - 1) / tileSize
+        var hashes = [UInt64](repeating: 0xcbf29ce484222325, count: columns * rows)
+        
+        // FNV-1a per tile, fed row by row
+        for y in 0..<height {
+            let row = pixels + y * bytesPerRow
+            let tileRow = (y / tileSize) * columns
+            for x in 0..<width {
+                let tile = tileRow + x / tileSize
+                hashes[tile] = (hashes[tile] ^ UInt64(row[x] >> luminanceShift)) &* 0x100000001b3
+            }
+        }
+        return hashes
+    }
+    
+    // A different tile layout (display added or removed) counts as all changed
+    private static func changedTileCount(_ current: [UInt64], _ previous: [UInt64]) -> Int {
+        guard current.count == previous.count else { return current.count }
+        return zip(current, previous).reduce(0) { $0 + ($1.0 != $1.1 ? 1 : 0) }
+    }
+    
+    // MARK: - Encoding
+    
+    private func encode(_ image: CGImage) -> (data: Data, fileExtension: String)? {
+        if let data = Self.encode(image, as: .heic, quality: quality) {
+            return (data, "heic")
+        }
+        return Self.encode(image, as: .jpeg, quality: quality).map { (data: $0, fileExtension: "jpg") }
+    }
+    
+    private static func encode(_ image: CGImage, as type: UTType, quality: Double) -> Data? {
+        let data = NSMutableData()
+        guard let destination = CGImageDestinationCreateWithData(data as CFMutableData, type.identifier as CFString, 1, nil) else {
+            return nil
+        }
+        
+        let options: [CFString: Any] = [kCGImageDestinationLossyCompressionQuality: quality]
+        CGImageDestinationAddImage(destination, image, options as CFDictionary)
+        guard CGImageDestinationFinalize(destination) else { return nil }
+        return data as Data
+    }
+}
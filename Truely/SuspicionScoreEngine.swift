@@ -0,0 +1,237 @@
+import Foundation
+
+// Running suspicion scores keyed by process lifetime (pid + start time, so a
+// recycled PID starts from zero). Each evidence item counts once and decays
+// with a half-life unless it is seen again, and a bounded min-heap holds the
+// top `capacity` processes, so readers get the ranking without regrouping
+// results or sorting every score.
+//
+// Scores are stored scaled by 2^(t / halfLife). Decay then multiplies every
+// score by the same factor, so it never reorders the heap; only new or
+// re-seen evidence moves an entry.
+final class SuspicionScoreEngine {
+    struct ProcessKey: Hashable {
+        let pid: pid_t
+        let startTime: UInt64
+    }
+    
+    struct RankedProcess {
+        let processName: String
+        let pid: pid_t
+        let score: Int
+        let detectionTypes: [String]
+        let evidence: [String]
+    }
+    
+    private struct Entry {
+        var processName: String
+        var scaledScore: Double
+        var evidenceSeenAt: [String: Double]   // evidence -> exponent when last seen
+        var detectionTypes: Set<String>
+        var hasNameBonus = false
+        var heapIndex: Int?
+    }
+    
+    private let capacity: Int
+    private let halfLife: TimeInterval
+    private let evidenceWeight = 2.0
+    private let nameBonusWeight = 5.0
+    private let minimumScore = 0.5          // entries decayed below this are dropped
+    private let lock = NSLock()
+    
+    // Only touched under lock
+    private var entries: [ProcessKey: Entry] = [:]
+    private var heap: [ProcessKey] = []      // min-heap by scaledScore
+    private var epoch = ProcessInfo.processInfo.systemUptime
+    
+    init(capacity: Int = 20, halfLife: TimeInterval = 600) {
+        self.capacity = max(capacity, 1)
+        self.halfLife = max(halfLife, 1)
+    }
+    
+    // Adds one pass's detections for a process. Evidence already counted is
+    // refreshed to full weight rather than added again.
+    func record(_ key: ProcessKey, processName: String, results: [AdvancedDetectionResult], hasSuspiciousName: Bool) {
+        guard !results.isEmpty else { return }
+        
+        lock.lock()
+        defer { lock.unlock() }
+        
+        let now = currentExponent()
+        let scale = pow(2.0, now)
+        var entry = entries[key] ?? Entry(processName: processName, scaledScore: 0, evidenceSeenAt: [:], detectionTypes: [])
+        entry.processName = processName
+        
+        for result in results {
+            entry.detectionTypes.insert(result.type.description)
+            for item in result.evidence {
+                // Swap the item's decayed contribution for a fresh one
+                if let seenAt = entry.evidenceSeenAt[item] {
+                    entry.scaledScore -= evidenceWeight * pow(2.0, seenAt)
+                }
+                entry.scaledScore += evidenceWeight * scale
+                entry.evidenceSeenAt[item] = now
+            }
+        }
+        
+        // Name bonus counts once per lifetime and decays with the rest
+        if hasSuspiciousName && !entry.hasNameBonus {
+            entry.hasNameBonus = true
+            entry.scaledScore += nameBonusWeight * scale
+        }
+        
+        entries[key] = entry
+        updateHeap(for: key)
+    }
+    
+    // Closes a scan pass: forgets processes that are gone or whose evidence has
+    // decayed away, then refills the heap if that opened slots in it
+    func endPass(liveKeys: Set<ProcessKey>) {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        let floor = minimumScore * pow(2.0, currentExponent())
+        let expired = entries.filter { !liveKeys.contains($0.key) || $0.value.scaledScore < floor }.map { $0.key }
+        guard !expired.isEmpty else { return }
+        
+        var removedFromHeap = false
+        for key in expired {
+            if let index = entries[key]?.heapIndex {
+                removeFromHeap(at: index)
+                removedFromHeap = true
+            }
+            entries.removeValue(forKey: key)
+        }
+        
+        if removedFromHeap {
+            refillHeap()
+        }
+    }
+    
+    // Highest score first; O(K log K) over the heap only
+    func topProcesses(_ limit: Int? = nil) -> [RankedProcess] {
+        lock.lock()
+        defer { lock.unlock() }
+        
+        let unscale = pow(2.0, -currentExponent())
+        let ranked = heap.compactMap { key -> (ProcessKey, Entry)? in
+            entries[key].map { (key, $0) }
+        }.sorted { $0.1.scaledScore > $1.1.scaledScore }
+        
+        return ranked.prefix(limit ?? capacity).map { key, entry in
+            RankedProcess(
+                processName: entry.processName,
+                pid: key.pid,
+                score: Int((entry.scaledScore * unscale).rounded()),
+                detectionTypes: entry.detectionTypes.sorted(),
+                evidence: entry.evidenceSeenAt.sorted { $0.value > $1.value }.map { $0.key }
+            )
+        }
+    }
+    
+    func reset() {
+        lock.lock()
+        entries.removeAll()
+        heap.removeAll()
+        epoch = ProcessInfo.processInfo.systemUptime
+        lock.unlock()
+    }
+    
+    // MARK: - Decay
+    
+    // Half-lives since the epoch. Scaled scores grow as 2^exponent, so the
+    // epoch is moved forward (scaling everything down by the same factor,
+    // which keeps the order) before they can overflow.
+    private func currentExponent() -> Double {
+        let exponent = (ProcessInfo.processInfo.systemUptime - epoch) / halfLife
+        guard exponent > 512 else { return exponent }
+        
+        let factor = pow(2.0, -exponent)
+        entries = entries.mapValues { entry in
+            var entry = entry
+            entry.scaledScore *= factor
+            entry.evidenceSeenAt = entry.evidenceSeenAt.mapValues { $0 - exponent }
+            return entry
+        }
+        epoch += exponent * halfLife
+        return 0
+    }
+    
+    // MARK: - Heap
+    
+    private func score(at index: Int) -> Double {
+        entries[heap[index]]?.scaledScore ?? 0
+    }
+    
+    private func updateHeap(for key: ProcessKey) {
+        guard let entry = entries[key] else { return }
+        
+        if let index = entry.heapIndex {
+            // Scores only rise through record(), so the entry can only move down
+            siftDown(from: index)
+        } else if heap.count < capacity {
+            heap.append(key)
+            entries[key]?.heapIndex = heap.count - 1
+            siftUp(from: heap.count - 1)
+        } else if entry.scaledScore > score(at: 0) {
+            // Displaces the lowest of the current top K
+            entries[heap[0]]?.heapIndex = nil
+            heap[0] = key
+            entries[key]?.heapIndex = 0
+            siftDown(from: 0)
+        }
+    }
+    
+    private func removeFromHeap(at index: Int) {
+        entries[heap[index]]?.heapIndex = nil
+        let last = heap.removeLast()
+        guard index < heap.count else { return }
+        
+        heap[index] = last
+        entries[last]?.heapIndex = index
+        siftDown(from: index)
+        siftUp(from: index)
+    }
+    
+    // After removals, promote the best entries outside the heap (rare: process exits)
+    private func refillHeap() {
+        let outside = entries.filter { $0.value.heapIndex == nil }
+            .sorted { $0.value.scaledScore > $1.value.scaledScore }
+            .prefix(capacity - heap.count)
+        for (key, _) in outside {
+            heap.append(key)
+            entries[key]?.heapIndex = heap.count - 1
+            siftUp(from: heap.count - 1)
+        }
+    }
+    
+    private func siftUp(from index: Int) {
+        var child = index
+        while child > 0 {
+            let parent = (child - 1) / 2
+            guard score(at: child) < score(at: parent) else { return }
+            swapAt(child, parent)
+            child = parent
+        }
+    }
+    
+    private func siftDown(from index: Int) {
+        var parent = index
+        while true {
+            let left = parent * 2 + 1
+            let right = left + 1
+            var smallest = parent
+            if left < heap.count && score(at: left) < score(at: smallest) { smallest = left }
+            if right < heap.count && score(at: right) < score(at: smallest) { smallest = right }
+            guard smallest != parent else { return }
+            swapAt(parent, smallest)
+            parent = smallest
+        }
+    }
+    
+    private func swapAt(_ i: Int, _ j: Int) {
+        heap.swapAt(i, j)
+        entries[heap[i]]?.heapIndex = i
+        entries[heap[j]]?.heapIndex = j
+    }
+}
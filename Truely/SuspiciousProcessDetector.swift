@@ -29,6 +29,7 @@ struct AdvancedDetectionResult: Equatable {
         case name
         case path
         case hash
+        case signature
         case windowProperty      // NEW
         case screenEvasion       // NEW
         case elevatedLayer       // NEW
@@ -39,6 +40,7 @@ struct AdvancedDetectionResult: Equatable {
             case .name: return "name"
             case .path: return "path"
             case .hash: return "hash"
+            case .signature: return "signature"
             case .windowProperty: return "window_property"
             case .screenEvasion: return "screen_evasion"
             case .elevatedLayer: return "elevated_layer"
@@ -59,6 +61,19 @@ struct SuspiciousProcessResult: Equatable {
         case name
         case path
         case hash
+        case signature
+    }
+}
+
+// Matches a process by its code signature. A nil field matches anything, so a
+// team ID alone covers every binary that developer signs.
+struct SignatureRule: Hashable {
+    let teamIdentifier: String?
+    let signingIdentifier: String?
+    
+    init(teamIdentifier: String? = nil, signingIdentifier: String? = nil) {
+        self.teamIdentifier = teamIdentifier
+        self.signingIdentifier = signingIdentifier
     }
 }
 
@@ -66,20 +81,74 @@ class SuspiciousProcessDetector: ObservableObject {
     @Published var suspiciousProcesses: [SuspiciousProcessResult] = []
     @Published var advancedDetectionResults: [AdvancedDetectionResult] = []
     
-    private var suspiciousProcessNames: Set<String> = []
+    private var suspiciousNameMatcher = NameMatcher(patterns: [])
     private var suspiciousPaths: Set<String> = []
     private var suspiciousHashes: Set<String> = []
+    private var suspiciousCDHashes: Set<String> = [] // the CDHash-length (40 hex digit) subset
+    private var suspiciousTeamIdentifiers: Set<String> = []
+    private var suspiciousSigningIdentifiers: Set<String> = []
+    private var suspiciousSignatures: Set<SignatureRule> = [] // rules with both fields set
     private var lastAlertedPids: Set<pid_t> = []
+    private var processResults: [pid_t: [SuspiciousProcessResult]] = [:] // Live processes from the table, with their matches
+    private var bundledHelperRoots: [pid_t: pid_t] = [:] // Helper -> root app, for helpers inside their app's bundle
+    private let stateLock = NSLock() // Guards processResults against hash worker callbacks
+    
+    // Called from a hash worker when a background hash matches a known binary
+    var onBackgroundDetection: ((SuspiciousProcessResult) -> Void)?
     
     // Advanced detection settings
     private var enableAdvancedDetection: Bool = false
     private var windowPropertyThreshold: Int = 3
     private var screenEvasionThreshold: Int = 2
     
-    func configure(processNames: [String], paths: [String], hashes: [String]) {
-        self.suspiciousProcessNames = Set(processNames.map { $0.lowercased() })
+    // Hashing limits per advanced scan; deferred files are hashed on a later pass
+    private let advancedHashByteBudget: UInt64 = 512 * 1024 * 1024
+    private let advancedHashTimeBudgetMs: UInt64 = 2000
+    private let sharedScanMaxAgeMs: UInt32 = 1000
+    
+    // Evasive window changes per owner, drained from the bridge's window state cache
+    private struct WindowEventSummary {
+        var movedOffScreen = 0
+        var sharingDisabled = 0
+        var layerElevated = 0
+    }
+    
+    // Per-process scores, updated as each advanced pass finds evidence
+    private let scoreEngine = SuspicionScoreEngine()
+    
+    // Executables that passed the signature and hash checks, persisted with
+    // the hash cache so a new session doesn't re-check every running binary.
+    // Starts under the empty rule set; configure() moves it to the real rules.
+    private let cleanExecutables = CleanExecutableCache(
+        url: SuspiciousProcessDetector.supportFileURL("clean-executables.json"),
+        rulesFingerprint: CleanExecutableCache.fingerprint(of: [])
+    )
+    
+    // Name fragments that make window behaviour more suspicious (heuristic, not a rule)
+    private static let suspiciousNameHints = NameMatcher(patterns: ["cluely", "cheat", "hack", "overlay", "inject", "bot", "auto", "trainer", "mod"])
+    
+    func configure(processNames: [String], paths: [String], hashes: [String], signatures: [SignatureRule] = []) {
+        // Compiled on every launch rather than persisted: building is linear in
+        // the total rule text, tens of milliseconds even for thousands of rules,
+        // and a stored table would need the same authentication as the caches
+        self.suspiciousNameMatcher = NameMatcher(patterns: Array(Set(processNames.map { $0.lowercased() })))
         self.suspiciousPaths = Set(paths)
         self.suspiciousHashes = Set(hashes.map { $0.lowercased() })
+        self.suspiciousCDHashes = suspiciousHashes.filter { $0.count == 40 }
+        
+        // Split rules by shape so each match is a set lookup
+        self.suspiciousTeamIdentifiers = Set(signatures.filter { $0.signingIdentifier == nil }.compactMap { $0.teamIdentifier })
+        self.suspiciousSigningIdentifiers = Set(signatures.filter { $0.teamIdentifier == nil }.compactMap { $0.signingIdentifier })
+        self.suspiciousSignatures = Set(signatures.filter { $0.teamIdentifier != nil && $0.signingIdentifier != nil })
+        cleanExecutables.setRules(fingerprint: signatureRulesFingerprint())
+        
+        // New rules: re-examine every running process on the next scan
+        stateLock.lock()
+        processResults.removeAll()
+        bundledHelperRoots.removeAll()
+        stateLock.unlock()
+        resetProcessChanges()
+        scoreEngine.reset()
     }
     
     func configureAdvancedDetection(enabled: Bool, windowThreshold: Int = 3, screenEvasionThreshold: Int = 2) {
@@ -88,45 +157,89 @@ class SuspiciousProcessDetector: ObservableObject {
         self.screenEvasionThreshold = screenEvasionThreshold
     }
     
-    func detectSuspiciousProcesses() -> ([SuspiciousProcessResult], Set<pid_t>) {
+    func detectSuspiciousProcesses(snapshot: ScanSnapshot? = nil) -> ([SuspiciousProcessResult], Set<pid_t>) {
         var suspicious: [SuspiciousProcessResult] = []
         var newAlertedPids: Set<pid_t> = []
         
-        // Get all system processes using C bridge
-        var processes: UnsafeMutablePointer<SystemProcessInfo>?
-        let processCount = getAllProcesses(&processes)
+        // Only processes spawned or exited since the last scan are examined;
+        // results for processes that are still running carry over. With a
+        // tick snapshot, the delta comes from the same bridge scan.
+        var delta = ProcessDelta()
+        let changeCount = snapshot != nil ? getProcessChangesWithMaxAge(&delta, sharedScanMaxAgeMs) : getProcessChanges(&delta)
         
-        if processCount > 0, let processArray = processes {
-            for i in 0..<Int(processCount) {
-                let process = processArray[i]
-                let processName = withUnsafeBytes(of: process.name) { bytes in
-                    String(cString: bytes.bindMemory(to: CChar.self).baseAddress!)
-                }
-                let processPath = withUnsafeBytes(of: process.path) { bytes in
-                    String(cString: bytes.bindMemory(to: CChar.self).baseAddress!)
-                }
-                let pid = process.pid
-                
-                // Check name
-                if checkProcessName(processName, pid: pid, suspicious: &suspicious) {
-                    newAlertedPids.insert(pid)
-                }
-                
-                // Check path
-                if !processPath.isEmpty && checkProcessPath(processPath, processName: processName, pid: pid, suspicious: &suspicious) {
-                    newAlertedPids.insert(pid)
-                }
+        // Process tree for attributing spawned helpers to their app (same bridge scan)
+        let tree = changeCount > 0 ? (snapshot ?? ScanSnapshot.capture(maxAgeMilliseconds: sharedScanMaxAgeMs)) : nil
+        
+        stateLock.lock()
+        if changeCount > 0 {
+            for change in delta.records {
+                let pid = change.process.pid
                 
-                // Check hash
-                if !processPath.isEmpty && checkProcessHash(processPath, processName: processName, pid: pid, suspicious: &suspicious) {
-                    newAlertedPids.insert(pid)
+                switch change.type {
+                case PROCESS_CHANGE_EXITED:
+                    processResults.removeValue(forKey: pid)
+                    bundledHelperRoots.removeValue(forKey: pid)
+                    
+                case PROCESS_CHANGE_SPAWNED:
+                    let processName = delta.name(of: change.process)
+                    let processPath = delta.path(of: change.process)
+                    var results: [SuspiciousProcessResult] = []
+                    
+                    // Helpers inside an app's bundle alert as part of the app
+                    var helperRoot: pid_t?
+                    if let scanned = tree?.process(pid: pid), scanned.info.startTime == change.process.startTime, scanned.isBundledHelper {
+                        helperRoot = scanned.root.pid
+                        bundledHelperRoots[pid] = scanned.root.pid
+                    }
+                    
+                    // Check name
+                    _ = checkProcessName(processName, pid: pid, suspicious: &results)
+                    
+                    // Check path
+                    if !processPath.isEmpty {
+                        _ = checkProcessPath(processPath, processName: processName, pid: pid, suspicious: &results)
+                    }
+                    
+                    // Executables that already passed (this session or a previous one) are not re-checked
+                    let isKnownClean = !processPath.isEmpty && cleanExecutables.isClean(processPath)
+                    
+                    // Check the kernel's code signing identity; a match makes the file hash unnecessary
+                    let signatureMatched = !isKnownClean && checkProcessSignature(pid: pid, processName: processName, processPath: processPath, suspicious: &results)
+                    
+                    // A helper signed as its app is covered by the app's own hash;
+                    // any other binary in the bundle is hashed like a standalone one
+                    let coveredByRoot = helperRoot.map { sharesCodeIdentity(pid, with: $0) } ?? false
+                    
+                    // Check hash in the background; inline only if the pool is unavailable
+                    if !isKnownClean && !coveredByRoot && !signatureMatched && !processPath.isEmpty && !submitProcessHash(processPath, processName: processName, pid: pid) {
+                        _ = checkProcessHash(processPath, processName: processName, pid: pid, suspicious: &results)
+                    }
+                    
+                    processResults[pid] = results
+                    
+                default:
+                    // Window state changes don't affect name/path/hash checks
+                    break
                 }
             }
             
             // Free the allocated memory
-            freeProcessList(processArray)
+            freeProcessDelta(&delta)
         }
         
+        // One alert per application tree for what a helper shares with its app
+        // (name, path); its own signature and hash matches always count
+        for pid in processResults.keys.sorted() {
+            guard var results = processResults[pid], !results.isEmpty else { continue }
+            if let root = bundledHelperRoots[pid], processResults[root]?.isEmpty == false {
+                results.removeAll { $0.type == .name || $0.type == .path }
+                if results.isEmpty { continue }
+            }
+            suspicious.append(contentsOf: results)
+            newAlertedPids.insert(pid)
+        }
+        stateLock.unlock()
+        
         // Also check NSWorkspace for GUI applications
         let runningApps = NSWorkspace.shared.runningApplications
         for app in runningApps {
@@ -143,8 +256,16 @@ class SuspiciousProcessDetector: ObservableObject {
                 if checkProcessPath(bundlePath, processName: appName, pid: pid, suspicious: &suspicious) {
                     newAlertedPids.insert(pid)
                 }
-                
-                if checkProcessHash(bundlePath, processName: appName, pid: pid, suspicious: &suspicious) {
+            }
+            
+            // Hash the bundle's executable, not its directory. Processes the
+            // delta scan already saw had their executable hashed there.
+            stateLock.lock()
+            let isKnownProcess = processResults[pid] != nil
+            stateLock.unlock()
+            
+            if !isKnownProcess, let executablePath = app.executableURL?.path {
+                if checkProcessHash(executablePath, processName: appName, pid: pid, suspicious: &suspicious) {
                     newAlertedPids.insert(pid)
                 }
             }
@@ -153,114 +274,130 @@ class SuspiciousProcessDetector: ObservableObject {
         return (suspicious, newAlertedPids)
     }
     
-    func detectAdvancedSuspiciousProcesses() -> [AdvancedDetectionResult] {
+    func detectAdvancedSuspiciousProcesses(snapshot sharedSnapshot: ScanSnapshot? = nil) -> [AdvancedDetectionResult] {
         guard enableAdvancedDetection else { 
             return [] 
         }
         
         let startTime = Date()
         var advancedResults: [AdvancedDetectionResult] = []
-        var processScores: [(String, Int, pid_t)] = [] // (processName, score, pid)
+        var liveKeys = Set<SuspicionScoreEngine.ProcessKey>()
+        var examinedCount = 0
+        var hashBudget = HashBudget()
+        beginHashBudget(&hashBudget, advancedHashByteBudget, advancedHashTimeBudgetMs)
         
-        // Get all system processes using C bridge
-        var processes: UnsafeMutablePointer<SystemProcessInfo>?
-        let processCount = getAllProcesses(&processes)
+        // Window changes seen by every scan since the previous advanced pass
+        let windowEvents = collectWindowEvents()
         
-        if processCount > 0, let processArray = processes {
-            for i in 0..<Int(processCount) {
-                let process = processArray[i]
-                let processName = withUnsafeBytes(of: process.name) { bytes in
-                    String(cString: bytes.bindMemory(to: CChar.self).baseAddress!)
-                }
-                let processPath = withUnsafeBytes(of: process.path) { bytes in
-                    String(cString: bytes.bindMemory(to: CChar.self).baseAddress!)
-                }
-                let pid = process.pid
+        // Use the scheduler tick's snapshot, or share the scan that
+        // detectSuspiciousProcesses (or a concurrent basic check) just ran
+        if let snapshot = sharedSnapshot ?? ScanSnapshot.capture(maxAgeMilliseconds: sharedScanMaxAgeMs) {
+            for scanned in snapshot {
+                let pid = scanned.pid
+                let scoreKey = SuspicionScoreEngine.ProcessKey(pid: pid, startTime: scanned.info.startTime)
+                liveKeys.insert(scoreKey)
                 
                 // FAST FILTERING: Skip obviously system processes early
-                if shouldSkipProcess(processName: processName, processPath: processPath) {
+                if shouldSkipProcess(scanned) {
                     continue
                 }
                 
+                examinedCount += 1
                 let beforeCount = advancedResults.count
                 
-                // Fast name check first (no expensive window operations)
-                let hasSuspiciousName = checkSuspiciousName(processName)
+                // Helpers inside an app's bundle share its name and path, which are
+                // checked once on the app. Their own signature (a per-pid kernel
+                // lookup) and windows are looked at, and the evidence goes to the
+                // app's score.
+                if scanned.isBundledHelper {
+                    _ = checkProcessSignatureAdvanced(scanned, results: &advancedResults)
+                    checkWindowPropertiesLightweight(scanned, results: &advancedResults)
+                    if let events = windowEvents[pid] {
+                        checkWindowEvents(scanned, events: events, results: &advancedResults)
+                    }
+                    
+                    if advancedResults.count > beforeCount {
+                        let root = scanned.root
+                        let rootKey = SuspicionScoreEngine.ProcessKey(pid: root.pid, startTime: root.info.startTime)
+                        scoreEngine.record(rootKey, processName: root.name, results: Array(advancedResults[beforeCount...]), hasSuspiciousName: false)
+                    }
+                    continue
+                }
+                
+                // Fast name check first (no expensive window operations), on the borrowed name bytes
+                let hasSuspiciousName = checkSuspiciousName(scanned)
                 if hasSuspiciousName {
                     // For suspicious names, do full analysis
-                    _ = checkProcessNameAdvanced(processName, pid: pid, results: &advancedResults)
+                    let process = scanned.info
+                    let processName = scanned.name
+                    let processPath = scanned.path
+                    
+                    _ = checkProcessNameAdvanced(scanned, results: &advancedResults)
+                    let signatureMatched = checkProcessSignatureAdvanced(scanned, results: &advancedResults)
                     if !processPath.isEmpty {
-                        _ = checkProcessPathAdvanced(processPath, processName: processName, pid: pid, results: &advancedResults)
-                        _ = checkProcessHashAdvanced(processPath, processName: processName, pid: pid, results: &advancedResults)
+                        _ = checkProcessPathAdvanced(scanned, results: &advancedResults)
+                        if !signatureMatched && !cleanExecutables.isClean(processPath) {
+                            _ = checkProcessHashAdvanced(processPath, processName: processName, pid: pid, budget: &hashBudget, results: &advancedResults)
+                        }
                     }
                     
-                    // Full window analysis for suspicious names
-                    checkWindowProperties(pid: pid, processName: processName, processPath: processPath, results: &advancedResults)
-                    checkScreenEvasion(pid: pid, processName: processName, processPath: processPath, results: &advancedResults)
-                    checkElevatedLayers(pid: pid, processName: processName, processPath: processPath, results: &advancedResults)
+                    // Full window analysis for suspicious names (window counters come from the scan's window snapshot)
+                    checkWindowProperties(process: process, processName: processName, processPath: processPath, results: &advancedResults)
+                    checkScreenEvasion(process: process, processName: processName, processPath: processPath, results: &advancedResults)
+                    checkElevatedLayers(process: process, processName: processName, processPath: processPath, results: &advancedResults)
                 } else {
-                    // For non-suspicious names, only do lightweight checks
-                    _ = checkProcessNameAdvanced(processName, pid: pid, results: &advancedResults)
-                    if !processPath.isEmpty {
-                        _ = checkProcessPathAdvanced(processPath, processName: processName, pid: pid, results: &advancedResults)
-                        // Skip hash checking for performance unless suspicious name
-                    }
+                    // For non-suspicious names, only do lightweight checks; name and
+                    // path Strings are only built if one of them finds something
+                    _ = checkProcessNameAdvanced(scanned, results: &advancedResults)
+                    _ = checkProcessSignatureAdvanced(scanned, results: &advancedResults)
+                    _ = checkProcessPathAdvanced(scanned, results: &advancedResults)
+                    // Skip hash checking for performance unless suspicious name
                     
                     // Only basic window property check using pre-computed data
-                    checkWindowPropertiesLightweight(process: process, processName: processName, processPath: processPath, results: &advancedResults)
+                    checkWindowPropertiesLightweight(scanned, results: &advancedResults)
                 }
                 
-                // Calculate total score for this process
+                // Windows that started hiding since the last pass
+                if let events = windowEvents[pid] {
+                    checkWindowEvents(scanned, events: events, results: &advancedResults)
+                }
+                
+                // Fold this pass's evidence into the process's running score
                 if advancedResults.count > beforeCount {
                     let processResults = Array(advancedResults[beforeCount...])
-                    let totalScore = calculateProcessScore(processName: processName, results: processResults)
-                    processScores.append((processName, totalScore, pid))
+                    scoreEngine.record(scoreKey, processName: processResults[0].processName, results: processResults, hasSuspiciousName: hasSuspiciousName)
                 }
             }
-            
-            freeProcessList(processArray)
+            scoreEngine.endPass(liveKeys: liveKeys)
         }
+        ScanTelemetry.shared.count(.advancedProcessesExamined, by: examinedCount)
         
         let scanTime = Date().timeIntervalSince(startTime)
         print("📋 Advanced detection scan completed in \(String(format: "%.2f", scanTime))s - Found \(advancedResults.count) detections")
+        if hashBudget.filesDeferred > 0 {
+            print("📋 Hash budget reached after \(hashBudget.bytesHashed / 1_048_576) MB - deferred \(hashBudget.filesDeferred) files to the next scan")
+        }
         
         // Show top 10 highest scoring processes
-        let topProcesses = processScores.sorted { $0.1 > $1.1 }.prefix(10)
         print("📋 TOP 10 HIGHEST SUSPICION SCORES:")
-        for (index, (processName, score, pid)) in topProcesses.enumerated() {
-            print("📋 \(index + 1). \(processName) (PID: \(pid)) - Score: \(score)")
+        for (index, ranked) in scoreEngine.topProcesses(10).enumerated() {
+            print("📋 \(index + 1). \(ranked.processName) (PID: \(ranked.pid)) - Score: \(ranked.score)")
         }
         
         return advancedResults
     }
     
-    private func calculateProcessScore(processName: String, results: [AdvancedDetectionResult]) -> Int {
-        var totalScore = 0
-        
-        // Base scoring from evidence
-        for result in results {
-            totalScore += result.evidence.count * 2
-        }
-        
-        // Bonus for suspicious names
-        let suspiciousNames = ["cluely", "cheat", "hack", "overlay", "inject", "bot", "auto", "trainer", "mod"]
-        let lowerName = processName.lowercased()
-        for suspiciousName in suspiciousNames {
-            if lowerName.contains(suspiciousName) {
-                totalScore += 5
-                break
-            }
-        }
-        
-        return totalScore
+    // Ranked, decayed scores from the advanced passes (highest first)
+    func topSuspicionScores(_ limit: Int? = nil) -> [SuspicionScoreEngine.RankedProcess] {
+        scoreEngine.topProcesses(limit)
     }
     
-    private func shouldSkipProcess(processName: String, processPath: String) -> Bool {
+    private func shouldSkipProcess(_ process: ScannedProcess) -> Bool {
         // Only skip the most basic kernel/system processes
         let coreSystemProcesses = ["kernel_task", "launchd"]
         
         for systemProcess in coreSystemProcesses {
-            if processName == systemProcess {  // Exact match only
+            if process.nameEquals(systemProcess) {  // Exact match only
                 return true
             }
         }
@@ -268,13 +405,68 @@ class SuspiciousProcessDetector: ObservableObject {
         return false
     }
     
-    private func checkSuspiciousName(_ processName: String) -> Bool {
-        let suspiciousNames = ["cluely", "cheat", "hack", "overlay", "inject", "bot", "auto", "trainer", "mod"]
-        let lowerName = processName.lowercased()
-        return suspiciousNames.contains { lowerName.contains($0) }
+    private func checkSuspiciousName(_ process: ScannedProcess) -> Bool {
+        return Self.suspiciousNameHints.matches(process.nameBytes)
     }
     
-    private func checkWindowPropertiesLightweight(process: SystemProcessInfo, processName: String, processPath: String, results: inout [AdvancedDetectionResult]) {
+    private func collectWindowEvents() -> [pid_t: WindowEventSummary] {
+        var delta = WindowEventDelta()
+        guard getWindowEvents(&delta) >= 0 else { return [:] }
+        defer { freeWindowEventDelta(&delta) }
+        
+        if delta.droppedCount > 0 {
+            print("📋 Window event queue overflowed - \(delta.droppedCount) events dropped")
+        }
+        
+        var summaries: [pid_t: WindowEventSummary] = [:]
+        for event in delta.records {
+            let pid = event.window.ownerPid
+            switch event.type {
+            case WINDOW_EVENT_MOVED_OFFSCREEN:
+                summaries[pid, default: WindowEventSummary()].movedOffScreen += 1
+            case WINDOW_EVENT_SHARING_DISABLED:
+                summaries[pid, default: WindowEventSummary()].sharingDisabled += 1
+            case WINDOW_EVENT_LAYER_ELEVATED:
+                summaries[pid, default: WindowEventSummary()].layerElevated += 1
+            default:
+                // Creation and close alone say nothing about evasion
+                break
+            }
+        }
+        return summaries
+    }
+    
+    private func checkWindowEvents(_ process: ScannedProcess, events: WindowEventSummary, results: inout [AdvancedDetectionResult]) {
+        // A window that hides after it was first seen points at a reaction to screen sharing
+        guard events.sharingDisabled > 0 || events.movedOffScreen > 0 else { return }
+        
+        var evidence: [String] = []
+        if events.sharingDisabled > 0 {
+            evidence.append("Window excluded from screen capture after it was shown: \(events.sharingDisabled)")
+        }
+        if events.movedOffScreen > 0 {
+            evidence.append("Window moved off-screen: \(events.movedOffScreen)")
+        }
+        if events.layerElevated > 0 {
+            evidence.append("Window raised above normal windows: \(events.layerElevated)")
+        }
+        
+        let processName = process.name
+        let processPath = process.path
+        let detectionResult = AdvancedDetectionResult(
+            confidence: .suspicious,
+            type: .screenEvasion,
+            processName: processName,
+            processPath: processPath,
+            pid: process.pid,
+            message: "[SUSPICIOUS] Window started evading capture: \(processName) (PID: \(process.pid))",
+            evidence: evidence
+        )
+        results.append(detectionResult)
+    }
+    
+    private func checkWindowPropertiesLightweight(_ scanned: ScannedProcess, results: inout [AdvancedDetectionResult]) {
+        let process = scanned.info
         var suspiciousEvidence: [String] = []
         var suspiciousScore = 0
         
@@ -301,6 +493,8 @@ class SuspiciousProcessDetector: ObservableObject {
         
         // Lower threshold for lightweight detection
         if suspiciousScore >= 3 && !suspiciousEvidence.isEmpty {
+            let processName = scanned.name
+            let processPath = scanned.path
             let detectionResult = AdvancedDetectionResult(
                 confidence: .suspicious,
                 type: .windowProperty,
@@ -315,22 +509,17 @@ class SuspiciousProcessDetector: ObservableObject {
     }
     
     private func checkProcessName(_ processName: String, pid: pid_t, suspicious: inout [SuspiciousProcessResult]) -> Bool {
-        let lowerName = processName.lowercased()
-        
-        for suspiciousName in suspiciousProcessNames {
-            if lowerName.contains(suspiciousName) {
-                let result = SuspiciousProcessResult(
-                    type: .name,
-                    processName: processName,
-                    processPath: "",
-                    pid: pid,
-                    message: "[NAME] \(processName) (PID: \(pid))"
-                )
-                suspicious.append(result)
-                return true
-            }
-        }
-        return false
+        guard suspiciousNameMatcher.matches(processName.lowercased()) else { return false }
+        
+        let result = SuspiciousProcessResult(
+            type: .name,
+            processName: processName,
+            processPath: "",
+            pid: pid,
+            message: "[NAME] \(processName) (PID: \(pid))"
+        )
+        suspicious.append(result)
+        return true
     }
     
     private func checkProcessPath(_ processPath: String, processName: String, pid: pid_t, suspicious: inout [SuspiciousProcessResult]) -> Bool {
@@ -362,7 +551,7 @@ class SuspiciousProcessDetector: ObservableObject {
         
         let fileHash = String(cString: hashBuffer).lowercased()
         
-        if suspiciousHashes.contains(fileHash) {
+        if isSuspiciousExecutable(fileHash: fileHash, pid: pid) {
             let suspiciousResult = SuspiciousProcessResult(
                 type: .hash,
                 processName: processName,
@@ -377,6 +566,215 @@ class SuspiciousProcessDetector: ObservableObject {
         return false
     }
     
+    private func checkProcessSignature(pid: pid_t, processName: String, processPath: String, suspicious: inout [SuspiciousProcessResult]) -> Bool {
+        guard let evidence = matchProcessSignature(pid: pid) else { return false }
+        
+        let result = SuspiciousProcessResult(
+            type: .signature,
+            processName: processName,
+            processPath: processPath,
+            pid: pid,
+            message: "[SIGNATURE] \(processName) (PID: \(pid)) - \(evidence)"
+        )
+        suspicious.append(result)
+        return true
+    }
+    
+    // Looks up the running process's signing identity against the signature
+    // rules and CDHash list. Returns a description of the match, if any.
+    private func matchProcessSignature(pid: pid_t) -> String? {
+        guard !suspiciousTeamIdentifiers.isEmpty || !suspiciousSigningIdentifiers.isEmpty ||
+              !suspiciousSignatures.isEmpty || !suspiciousHashes.isEmpty else { return nil }
+        
+        var identity = CodeSigningIdentity()
+        guard getProcessCodeIdentity(pid, &identity) == 0, identity.isSigned != 0 else { return nil }
+        
+        let cdHash = identity.cdHashString
+        let teamIdentifier = identity.teamIdentifierString
+        let signingIdentifier = identity.signingIdentifierString
+        
+        if !cdHash.isEmpty && suspiciousCDHashes.contains(cdHash) {
+            return "CDHash \(cdHash)"
+        }
+        if !teamIdentifier.isEmpty && suspiciousTeamIdentifiers.contains(teamIdentifier) {
+            return "team \(teamIdentifier)"
+        }
+        if !signingIdentifier.isEmpty && suspiciousSigningIdentifiers.contains(signingIdentifier) {
+            return "identifier \(signingIdentifier)"
+        }
+        if suspiciousSignatures.contains(SignatureRule(teamIdentifier: teamIdentifier, signingIdentifier: signingIdentifier)) {
+            return "\(teamIdentifier)/\(signingIdentifier)"
+        }
+        return nil
+    }
+    
+    // Same CDHash, or signed by the same team, as the process at rootPid
+    private func sharesCodeIdentity(_ pid: pid_t, with rootPid: pid_t) -> Bool {
+        var helper = CodeSigningIdentity()
+        var root = CodeSigningIdentity()
+        guard getProcessCodeIdentity(pid, &helper) == 0, helper.isSigned != 0,
+              getProcessCodeIdentity(rootPid, &root) == 0, root.isSigned != 0 else { return false }
+        
+        let cdHash = helper.cdHashString
+        if !cdHash.isEmpty && cdHash == root.cdHashString {
+            return true
+        }
+        let teamIdentifier = helper.teamIdentifierString
+        return !teamIdentifier.isEmpty && teamIdentifier == root.teamIdentifierString
+    }
+    
+    // Matches either the whole-file SHA-256 or the code signature's CDHash,
+    // which stays the same across re-packaging of a signed binary. The CDHash
+    // is the running process's, from the kernel, so a SHA-256 answered by the
+    // hash cache doesn't lead to the file being opened and parsed anyway.
+    private func isSuspiciousExecutable(fileHash: String, pid: pid_t) -> Bool {
+        if suspiciousHashes.contains(fileHash) {
+            return true
+        }
+        
+        guard !suspiciousCDHashes.isEmpty else { return false }
+        var identity = CodeSigningIdentity()
+        guard getProcessCodeIdentity(pid, &identity) == 0, identity.isSigned != 0 else { return false }
+        return suspiciousCDHashes.contains(identity.cdHashString)
+    }
+    
+    // MARK: - Background Hashing
+    
+    private final class HashJobContext {
+        weak var detector: SuspiciousProcessDetector?
+        let processName: String
+        let processPath: String
+        let pid: pid_t
+        let fileIdentity: CleanExecutableCache.FileIdentity?    // taken before hashing
+        
+        init(detector: SuspiciousProcessDetector, processName: String, processPath: String, pid: pid_t) {
+            self.detector = detector
+            self.processName = processName
+            self.processPath = processPath
+            self.pid = pid
+            self.fileIdentity = CleanExecutableCache.identity(of: processPath)
+        }
+    }
+    
+    private func submitProcessHash(_ processPath: String, processName: String, pid: pid_t) -> Bool {
+        let job = HashJobContext(detector: self, processName: processName, processPath: processPath, pid: pid)
+        let context = Unmanaged.passRetained(job).toOpaque()
+        
+        let result = submitHashJob(processPath, { _, result, hashString, context in
+            guard let context = context else { return }
+            let job = Unmanaged<HashJobContext>.fromOpaque(context).takeRetainedValue()
+            guard result == 0, let hashString = hashString else { return }
+            job.detector?.handleHashResult(String(cString: hashString).lowercased(), for: job)
+        }, context)
+        
+        if result != 0 {
+            // Not accepted, so no callback will release the context
+            Unmanaged<HashJobContext>.fromOpaque(context).release()
+            return false
+        }
+        return true
+    }
+    
+    private func handleHashResult(_ fileHash: String, for job: HashJobContext) {
+        // Only submitted after the signature check found nothing, so no match here means clean
+        guard isSuspiciousExecutable(fileHash: fileHash, pid: job.pid) else {
+            if let identity = job.fileIdentity {
+                cleanExecutables.markClean(job.processPath, checkedAs: identity)
+            }
+            return
+        }
+        
+        let result = SuspiciousProcessResult(
+            type: .hash,
+            processName: job.processName,
+            processPath: job.processPath,
+            pid: job.pid,
+            message: "[HASH] \(job.processPath) (PID: \(job.pid))"
+        )
+        
+        // Drop results for processes that exited while being hashed
+        stateLock.lock()
+        let isLive = processResults[job.pid] != nil
+        if isLive {
+            processResults[job.pid]?.append(result)
+        }
+        stateLock.unlock()
+        
+        if isLive {
+            onBackgroundDetection?(result)
+        }
+    }
+    
+    // MARK: - Warm Start Persistence
+    
+    private static func supportFileURL(_ name: String) -> URL? {
+        guard let supportDirectory = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first else {
+            return nil
+        }
+        return supportDirectory.appendingPathComponent("Truely", isDirectory: true).appendingPathComponent(name)
+    }
+    
+    private var hashCacheURL: URL? {
+        Self.supportFileURL("hash-cache.bin")
+    }
+    
+    // Only the rules a clean verdict depends on; name and path rules are re-checked every scan
+    private func signatureRulesFingerprint() -> UInt64 {
+        let signatureRules = (suspiciousSignatures.map { "sig|\($0.teamIdentifier ?? "")|\($0.signingIdentifier ?? "")" }
+            + suspiciousTeamIdentifiers.map { "team|\($0)" }
+            + suspiciousSigningIdentifiers.map { "id|\($0)" })
+        return CleanExecutableCache.fingerprint(of: signatureRules + suspiciousHashes.map { "hash|\($0)" })
+    }
+    
+    // The previous session's hash cache and clean executables; both are
+    // independent files, so they load in parallel
+    func loadWarmStartState() {
+        DispatchQueue.concurrentPerform(iterations: 2) { index in
+            if index == 0 {
+                loadPersistedHashCache()
+            } else {
+                cleanExecutables.load()
+            }
+        }
+    }
+    
+    func saveWarmStartState() {
+        savePersistedHashCache()
+        cleanExecutables.save()
+    }
+    
+    private func loadPersistedHashCache() {
+        guard let url = hashCacheURL, FileManager.default.fileExists(atPath: url.path) else { return }
+        guard let key = WarmStartKey.key() else {
+            print("🔐 Ignoring hash cache: no key to authenticate it")
+            return
+        }
+        
+        let loaded = key.withUnsafeBytes { loadHashCache(url.path, $0.bindMemory(to: UInt8.self).baseAddress, key.count) }
+        if loaded >= 0 {
+            print("🔐 Loaded \(loaded) cached file hashes")
+        } else {
+            // Unreadable, from an older format or failed authentication; it is rewritten on save
+            print("🔐 Ignoring hash cache: \(String(cString: getBridgeErrorDescription(loaded)))")
+        }
+    }
+    
+    private func savePersistedHashCache() {
+        guard let url = hashCacheURL, let key = WarmStartKey.key() else { return }
+        
+        do {
+            try FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+        } catch {
+            print("🔐 Failed to create hash cache directory: \(error)")
+            return
+        }
+        
+        let saved = key.withUnsafeBytes { saveHashCache(url.path, $0.bindMemory(to: UInt8.self).baseAddress, key.count) }
+        if saved < 0 {
+            print("🔐 Failed to save hash cache: \(String(cString: getBridgeErrorDescription(saved)))")
+        }
+    }
+    
     func updateLastAlertedPids(_ pids: Set<pid_t>) {
         lastAlertedPids = pids
     }
@@ -387,33 +785,34 @@ class SuspiciousProcessDetector: ObservableObject {
     
     // MARK: - Advanced Detection Methods
     
-    private func checkProcessNameAdvanced(_ processName: String, pid: pid_t, results: inout [AdvancedDetectionResult]) -> Bool {
-        let lowerName = processName.lowercased()
-        
-        for suspiciousName in suspiciousProcessNames {
-            if lowerName.contains(suspiciousName) {
-                let result = AdvancedDetectionResult(
-                    confidence: .definitive,
-                    type: .name,
-                    processName: processName,
-                    processPath: "",
-                    pid: pid,
-                    message: "[DEFINITIVE] Process name match: \(processName) (PID: \(pid))",
-                    evidence: ["Process name contains '\(suspiciousName)'"]
-                )
-                results.append(result)
-                return true
-            }
-        }
-        return false
+    private func checkProcessNameAdvanced(_ process: ScannedProcess, results: inout [AdvancedDetectionResult]) -> Bool {
+        guard let suspiciousName = suspiciousNameMatcher.firstMatch(in: process.nameBytes) else { return false }
+        
+        let processName = process.name
+        let pid = process.pid
+        let result = AdvancedDetectionResult(
+            confidence: .definitive,
+            type: .name,
+            processName: processName,
+            processPath: "",
+            pid: pid,
+            message: "[DEFINITIVE] Process name match: \(processName) (PID: \(pid))",
+            evidence: ["Process name contains '\(suspiciousName)'"]
+        )
+        results.append(result)
+        return true
     }
     
-    private func checkProcessPathAdvanced(_ processPath: String, processName: String, pid: pid_t, results: inout [AdvancedDetectionResult]) -> Bool {
+    private func checkProcessPathAdvanced(_ process: ScannedProcess, results: inout [AdvancedDetectionResult]) -> Bool {
+        guard process.hasPath, !suspiciousPaths.isEmpty else { return false }
+        
+        let processPath = process.path
+        let pid = process.pid
         if suspiciousPaths.contains(processPath) {
             let result = AdvancedDetectionResult(
                 confidence: .definitive,
                 type: .path,
-                processName: processName,
+                processName: process.name,
                 processPath: processPath,
                 pid: pid,
                 message: "[DEFINITIVE] Path match: \(processPath) (PID: \(pid))",
@@ -425,19 +824,38 @@ class SuspiciousProcessDetector: ObservableObject {
         return false
     }
     
-    private func checkProcessHashAdvanced(_ processPath: String, processName: String, pid: pid_t, results: inout [AdvancedDetectionResult]) -> Bool {
+    private func checkProcessSignatureAdvanced(_ process: ScannedProcess, results: inout [AdvancedDetectionResult]) -> Bool {
+        let pid = process.pid
+        guard let evidence = matchProcessSignature(pid: pid) else { return false }
+        
+        let processName = process.name
+        let processPath = process.path
+        let advancedResult = AdvancedDetectionResult(
+            confidence: .definitive,
+            type: .signature,
+            processName: processName,
+            processPath: processPath,
+            pid: pid,
+            message: "[DEFINITIVE] Signature match: \(processName) (PID: \(pid))",
+            evidence: ["Code signature matches known suspicious software: \(evidence)"]
+        )
+        results.append(advancedResult)
+        return true
+    }
+    
+    private func checkProcessHashAdvanced(_ processPath: String, processName: String, pid: pid_t, budget: inout HashBudget, results: inout [AdvancedDetectionResult]) -> Bool {
         guard FileManager.default.fileExists(atPath: processPath) else { return false }
         
         let hashBufferSize = 65
         let hashBuffer = UnsafeMutablePointer<CChar>.allocate(capacity: hashBufferSize)
         defer { hashBuffer.deallocate() }
         
-        let result = calculateFileSHA256(processPath, hashBuffer, hashBufferSize)
+        let result = calculateFileSHA256WithBudget(processPath, hashBuffer, hashBufferSize, &budget)
         guard result == 0 else { return false }
         
         let fileHash = String(cString: hashBuffer).lowercased()
         
-        if suspiciousHashes.contains(fileHash) {
+        if isSuspiciousExecutable(fileHash: fileHash, pid: pid) {
             let advancedResult = AdvancedDetectionResult(
                 confidence: .definitive,
                 type: .hash,
@@ -454,7 +872,9 @@ class SuspiciousProcessDetector: ObservableObject {
         return false
     }
     
-    private func checkWindowProperties(pid: pid_t, processName: String, processPath: String, results: inout [AdvancedDetectionResult]) {
+    private func checkWindowProperties(process: SystemProcessInfo, processName: String, processPath: String, results: inout [AdvancedDetectionResult]) {
+        let pid = process.pid
+        
         // Only skip truly system-critical processes
         let systemCritical = ["kernel_task", "launchd", "WindowServer"]
         for critical in systemCritical {
@@ -464,9 +884,10 @@ class SuspiciousProcessDetector: ObservableObject {
         }
         
         var properties = WindowProperties()
-        let result = getWindowProperties(pid, &properties)
-        
-        guard result == 0 else { return }
+        properties.windowCount = process.windowCount
+        properties.sharingStateDisabled = process.sharingDisabledCount
+        properties.elevatedLayers = process.elevatedLayerCount
+        properties.suspiciousPatterns = process.screenEvasionCount
         
         var suspiciousEvidence: [String] = []
         var suspiciousScore = 0
@@ -489,14 +910,9 @@ class SuspiciousProcessDetector: ObservableObject {
         }
         
         // 3. NAME-BASED HEURISTICS - Suspicious process names
-        let suspiciousNames = ["cluely", "cheat", "hack", "overlay", "inject", "bot", "auto", "trainer", "mod"]
-        let lowerName = processName.lowercased()
-        for suspiciousName in suspiciousNames {
-            if lowerName.contains(suspiciousName) {
-                suspiciousEvidence.append("Suspicious process name contains '\(suspiciousName)'")
-                suspiciousScore += 5
-                break
-            }
+        if let suspiciousName = Self.suspiciousNameHints.firstMatch(in: processName.lowercased()) {
+            suspiciousEvidence.append("Suspicious process name contains '\(suspiciousName)'")
+            suspiciousScore += 5
         }
         
         // 4. RATIO ANALYSIS - High evasion-to-window ratio
@@ -533,8 +949,9 @@ class SuspiciousProcessDetector: ObservableObject {
         }
     }
     
-    private func checkScreenEvasion(pid: pid_t, processName: String, processPath: String, results: inout [AdvancedDetectionResult]) {
-        let evasionCount = detectScreenEvasion(pid)
+    private func checkScreenEvasion(process: SystemProcessInfo, processName: String, processPath: String, results: inout [AdvancedDetectionResult]) {
+        let pid = process.pid
+        let evasionCount = Int(process.screenEvasionCount)
         
         // Skip if no evasion detected
         if evasionCount == 0 {
@@ -545,9 +962,7 @@ class SuspiciousProcessDetector: ObservableObject {
         var suspiciousEvidence: [String] = []
         
         // Check for suspicious name patterns first
-        let suspiciousNames = ["cluely", "cheat", "hack", "overlay", "inject", "bot", "auto", "trainer", "mod"]
-        let lowerName = processName.lowercased()
-        let hasSuspiciousName = suspiciousNames.contains { lowerName.contains($0) }
+        let hasSuspiciousName = Self.suspiciousNameHints.matches(processName.lowercased())
         
         if hasSuspiciousName {
             // Any evasion from suspicious-named process is highly suspicious
@@ -580,8 +995,9 @@ class SuspiciousProcessDetector: ObservableObject {
         }
     }
     
-    private func checkElevatedLayers(pid: pid_t, processName: String, processPath: String, results: inout [AdvancedDetectionResult]) {
-        let elevatedCount = detectElevatedLayers(pid)
+    private func checkElevatedLayers(process: SystemProcessInfo, processName: String, processPath: String, results: inout [AdvancedDetectionResult]) {
+        let pid = process.pid
+        let elevatedCount = Int(process.elevatedLayerCount)
         
         if elevatedCount == 0 {
             return
@@ -591,9 +1007,7 @@ class SuspiciousProcessDetector: ObservableObject {
         var suspiciousEvidence: [String] = []
         
         // Check for suspicious name patterns first
-        let suspiciousNames = ["cluely", "cheat", "hack", "overlay", "inject", "bot", "auto", "trainer", "mod"]
-        let lowerName = processName.lowercased()
-        let hasSuspiciousName = suspiciousNames.contains { lowerName.contains($0) }
+        let hasSuspiciousName = Self.suspiciousNameHints.matches(processName.lowercased())
         
         if hasSuspiciousName {
             // Any elevated layers from suspicious-named process
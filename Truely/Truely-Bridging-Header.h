@@ -34,6 +34,14 @@ static inline const char* getBridgeErrorDescription(int errorCode) {
             return "System call failed";
         case BRIDGE_ERROR_FILE_ACCESS:
             return "File access error";
+        case BRIDGE_ERROR_BUDGET_EXHAUSTED:
+            return "Scan budget exhausted";
+        case BRIDGE_ERROR_QUEUE_FULL:
+            return "Work queue full";
+        case BRIDGE_ERROR_CANCELLED:
+            return "Operation cancelled";
+        case BRIDGE_ERROR_AUTHENTICATION:
+            return "Authentication failed";
         default:
             return "Unknown error";
     }
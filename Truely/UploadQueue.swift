@@ -0,0 +1,268 @@
+import Foundation
+
+// The one path every upload goes through. Jobs are kept in an on-disk
+// manifest, so pending evidence survives a crash or quit. They run in
+// priority order (detection log, then screenshots, then video) with one job
+// per kind and maxConcurrentUploads overall in flight, and are paced to a
+// byte budget that follows the current link: payloads go out through
+// sendPaced, a slice at a time, so even a large file never takes the whole link.
+final class UploadQueue {
+    // Raw value is the priority: lower runs first
+    enum Kind: Int, Codable {
+        case log = 0
+        case screenshot
+        case video
+    }
+    
+    struct Job: Codable {
+        let id: UUID
+        let kind: Kind
+        let filePath: String
+        let folderName: String
+        let fileName: String
+        let coalesceKey: String?        // a pending job with the same key is superseded
+        let enqueuedAt: Date
+        var attempts: Int
+        var notBefore: Date
+    }
+    
+    // Performs one transfer, sending its payload through sendPaced; reports
+    // success and an error message
+    typealias Performer = (Job, @escaping (Bool, String?) -> Void) -> Void
+    
+    // Sends one slice of a payload
+    typealias SliceSender = (Data, @escaping (Bool, String?) -> Void) -> Void
+    
+    private let manifestURL: URL?
+    private let maxConcurrentUploads: Int
+    private let maxAttempts: Int
+    private let bytesPerSecond: () -> Int
+    private let performer: Performer
+    private let queue = DispatchQueue(label: "com.truely.uploadqueue", qos: .utility)
+    
+    // Only touched on queue
+    private var jobs: [Job] = []
+    private var inFlight: [UUID: Kind] = [:]
+    private var completions: [UUID: [(Bool, String?) -> Void]] = [:]
+    private var budgetAvailableAt = Date.distantPast
+    private var wakeAt: Date?
+    
+    private static let offlineRecheckInterval: TimeInterval = 15.0
+    private static let maxRetryDelay: TimeInterval = 300.0
+    
+    // A slice is this long at the current rate, so a rate change applies
+    // within a fraction of a second
+    private static let sliceInterval: TimeInterval = 0.25
+    private static let minimumSliceBytes = 4 * 1024
+    
+    init(manifestURL: URL?, maxConcurrentUploads: Int = 2, maxAttempts: Int = 8, bytesPerSecond: @escaping () -> Int, performer: @escaping Performer) {
+        self.manifestURL = manifestURL
+        self.maxConcurrentUploads = max(maxConcurrentUploads, 1)
+        self.maxAttempts = max(maxAttempts, 1)
+        self.bytesPerSecond = bytesPerSecond
+        self.performer = performer
+        
+        queue.async {
+            self.loadManifest()
+        }
+    }
+    
+    // Completion runs on the main queue once the job uploads or is given up on
+    func enqueue(_ kind: Kind, filePath: String, folderName: String, fileName: String, coalesceKey: String? = nil, completion: ((Bool, String?) -> Void)? = nil) {
+        queue.async {
+            if let key = coalesceKey,
+               let index = self.jobs.firstIndex(where: { $0.coalesceKey == key && self.inFlight[$0.id] == nil }) {
+                // The queued job will pick up the newer state when it runs
+                if let completion = completion {
+                    self.completions[self.jobs[index].id, default: []].append(completion)
+                }
+                self.pump()
+                return
+            }
+            
+            let now = Date()
+            let job = Job(id: UUID(), kind: kind, filePath: filePath, folderName: folderName, fileName: fileName,
+                          coalesceKey: coalesceKey, enqueuedAt: now, attempts: 0, notBefore: now)
+            self.jobs.append(job)
+            if let completion = completion {
+                self.completions[job.id] = [completion]
+            }
+            self.saveManifest()
+            self.pump()
+        }
+    }
+    
+    // Re-evaluates the queue, e.g. after the link comes back
+    func resume() {
+        queue.async {
+            self.wakeAt = nil
+            self.pump()
+        }
+    }
+    
+    // MARK: - Scheduling
+    
+    private func pump() {
+        let now = Date()
+        
+        while inFlight.count < maxConcurrentUploads {
+            let rate = bytesPerSecond()
+            guard rate > 0 else {
+                scheduleWake(at: now.addingTimeInterval(Self.offlineRecheckInterval))
+                return
+            }
+            guard budgetAvailableAt <= now else {
+                scheduleWake(at: budgetAvailableAt)
+                return
+            }
+            
+            let busyKinds = Set(inFlight.values)
+            let candidates = jobs.indices.filter { inFlight[jobs[$0].id] == nil && !busyKinds.contains(jobs[$0].kind) }
+            let ready = candidates.filter { jobs[$0].notBefore <= now }
+            
+            // Highest priority first, oldest first within a kind
+            guard let index = ready.min(by: { (jobs[$0].kind.rawValue, jobs[$0].enqueuedAt) < (jobs[$1].kind.rawValue, jobs[$1].enqueuedAt) }) else {
+                if let next = candidates.map({ jobs[$0].notBefore }).min() {
+                    scheduleWake(at: next)
+                }
+                return
+            }
+            
+            let job = jobs[index]
+            inFlight[job.id] = job.kind
+            performer(job) { success, error in
+                self.queue.async {
+                    self.finish(job, success: success, error: error)
+                }
+            }
+        }
+    }
+    
+    // MARK: - Pacing
+    
+    // Sends data in slices sized to sliceInterval at the current rate. Each
+    // slice waits for the link budget and is charged to it before it goes
+    // out, so concurrent transfers together stay under bytesPerSecond.
+    // Completion reports success and an error message.
+    func sendPaced(_ data: Data, slice send: @escaping SliceSender, completion: @escaping (Bool, String?) -> Void) {
+        queue.async {
+            self.sendSlice(of: data, from: 0, send: send, completion: completion)
+        }
+    }
+    
+    private func sendSlice(of data: Data, from offset: Int, send: @escaping SliceSender, completion: @escaping (Bool, String?) -> Void) {
+        guard offset < data.count else {
+            completion(true, nil)
+            return
+        }
+        
+        // An interrupted link pauses the transfer rather than failing it
+        let rate = bytesPerSecond()
+        let now = Date()
+        let resumeAt = rate > 0 ? budgetAvailableAt : now.addingTimeInterval(Self.offlineRecheckInterval)
+        guard resumeAt <= now else {
+            queue.asyncAfter(deadline: .now() + resumeAt.timeIntervalSince(now)) {
+                self.sendSlice(of: data, from: offset, send: send, completion: completion)
+            }
+            return
+        }
+        
+        let length = min(max(Int(Double(rate) * Self.sliceInterval), Self.minimumSliceBytes), data.count - offset)
+        budgetAvailableAt = now.addingTimeInterval(Double(length) / Double(rate))
+        
+        send(data.subdata(in: (data.startIndex + offset)..<(data.startIndex + offset + length))) { success, error in
+            self.queue.async {
+                guard success else {
+                    completion(false, error)
+                    return
+                }
+                self.sendSlice(of: data, from: offset + length, send: send, completion: completion)
+            }
+        }
+    }
+    
+    private func finish(_ job: Job, success: Bool, error: String?) {
+        inFlight[job.id] = nil
+        
+        guard let index = jobs.firstIndex(where: { $0.id == job.id }) else {
+            pump()
+            return
+        }
+        
+        if success {
+            jobs.remove(at: index)
+            complete(job.id, success: true, error: nil)
+        } else {
+            jobs[index].attempts += 1
+            let attempts = jobs[index].attempts
+            
+            if attempts >= maxAttempts || !FileManager.default.fileExists(atPath: job.filePath) {
+                jobs.remove(at: index)
+                print("❌ UploadQueue: Gave up on \(job.fileName) after \(attempts) attempts: \(error ?? "Unknown error")")
+                complete(job.id, success: false, error: error)
+            } else {
+                let delay = min(pow(2.0, Double(attempts)), Self.maxRetryDelay)
+                jobs[index].notBefore = Date().addingTimeInterval(delay)
+                print("⚠️ UploadQueue: \(job.fileName) failed - retrying in \(Int(delay))s (\(error ?? "Unknown error"))")
+            }
+        }
+        
+        saveManifest()
+        pump()
+    }
+    
+    private func complete(_ id: UUID, success: Bool, error: String?) {
+        guard let callbacks = completions.removeValue(forKey: id) else { return }
+        DispatchQueue.main.async {
+            callbacks.forEach { $0(success, error) }
+        }
+    }
+    
+    private func scheduleWake(at date: Date) {
+        // Keep only the earliest pending wakeup
+        if let pending = wakeAt, pending <= date { return }
+        wakeAt = date
+        
+        queue.asyncAfter(deadline: .now() + max(date.timeIntervalSinceNow, 0)) {
+            guard self.wakeAt == date else { return }
+            self.wakeAt = nil
+            self.pump()
+        }
+    }
+    
+    // MARK: - Manifest
+    
+    private func loadManifest() {
+        guard let url = manifestURL, let data = try? Data(contentsOf: url) else { return }
+        
+        guard let saved = try? JSONDecoder().decode([Job].self, from: data) else {
+            print("⚠️ UploadQueue: Ignoring unreadable manifest")
+            return
+        }
+        
+        // Files removed since the last run can't be sent; everything else is due now
+        let now = Date()
+        let restored = saved.filter { FileManager.default.fileExists(atPath: $0.filePath) }.map { job -> Job in
+            var job = job
+            job.notBefore = min(job.notBefore, now)
+            return job
+        }
+        jobs.insert(contentsOf: restored, at: 0)
+        if !restored.isEmpty {
+            print("📤 UploadQueue: Resuming \(restored.count) uploads from the last session")
+        }
+        saveManifest()
+        pump()
+    }
+    
+    private func saveManifest() {
+        guard let url = manifestURL else { return }
+        
+        do {
+            try FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+            try JSONEncoder().encode(jobs).write(to: url, options: .atomic)
+        } catch {
+            print("⚠️ UploadQueue: Failed to save manifest: \(error)")
+        }
+    }
+}
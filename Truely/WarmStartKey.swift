@@ -0,0 +1,66 @@
+import Foundation
+import Security
+
+// Key that authenticates the state carried between sessions (the bridge's hash
+// cache, the clean executable list). Those files live in Application Support,
+// where the user can edit them, so each is MAC'd with this key; the key itself
+// is a random per-install secret kept in the Keychain and created on first use.
+enum WarmStartKey {
+    private static let service = "com.truely.warmstart"
+    private static let account = "integrity-key"
+    private static let keyLength = 32
+    private static let lock = NSLock()
+
+    // Only touched under lock
+    private static var cached: Data?
+
+    // nil when the Keychain can't be used; callers then neither trust nor write persisted state
+    static func key() -> Data? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let cached = cached { return cached }
+        cached = readKey() ?? createKey()
+        return cached
+    }
+
+    private static func readKey() -> Data? {
+        let query: [String: Any] = [
+            kSecClass as String: kSecClassGenericPassword,
+            kSecAttrService as String: service,
+            kSecAttrAccount as String: account,
+            kSecReturnData as String: true,
+            kSecMatchLimit as String: kSecMatchLimitOne
+        ]
+
+        var item: CFTypeRef?
+        guard SecItemCopyMatching(query as CFDictionary, &item) == errSecSuccess,
+              let data = item as? Data, data.count == keyLength else { return nil }
+        return data
+    }
+
+    private static func createKey() -> Data? {
+        var bytes = [UInt8](repeating: 0, count: keyLength)
+        guard SecRandomCopyBytes(kSecRandomDefault, bytes.count, &bytes) == errSecSuccess else { return nil }
+        let data = Data(bytes)
+
+        // Replaces a malformed item; anything signed under it is no longer trusted anyway
+        let match: [String: Any] = [
+            kSecClass as String: kSecClassGenericPassword,
+            kSecAttrService as String: service,
+            kSecAttrAccount as String: account
+        ]
+        SecItemDelete(match as CFDictionary)
+
+        var attributes = match
+        attributes[kSecValueData as String] = data
+        attributes[kSecAttrAccessible as String] = kSecAttrAccessibleAfterFirstUnlockThisDeviceOnly
+
+        let status = SecItemAdd(attributes as CFDictionary, nil)
+        guard status == errSecSuccess else {
+            print("🔐 Failed to store warm start key: \(status)")
+            return nil
+        }
+        return data
+    }
+}
@@ -0,0 +1,398 @@
+import XCTest
+import Darwin
+@testable import Truely
+
+// Performance coverage for the scan and detection hot paths. Each test uses
+// XCTest's measure with wall clock, CPU, peak memory and an allocation count,
+// so Xcode's per-machine baselines (Set Baseline, stored under
+// xcshareddata/xcbaselines) flag a regression in any of them.
+//
+// Live tests time the bridge against this Mac's real process and window
+// tables, one phase at a time. Fixture tests run over synthetic tables of
+// 500, 2,000 and 10,000 processes or windows, so their cost does not depend
+// on what happens to be running.
+final class BridgeBenchmarks: XCTestCase {
+    private static let fixtureSizes = [500, 2_000, 10_000]
+    private static let hashFileBytes = 64 * 1024 * 1024
+    
+    private var options: XCTMeasureOptions {
+        let options = XCTMeasureOptions()
+        options.iterationCount = 10
+        return options
+    }
+    
+    private var manualOptions: XCTMeasureOptions {
+        let options = self.options
+        options.invocationOptions = [.manuallyStart, .manuallyStop]
+        return options
+    }
+    
+    private var metrics: [XCTMetric] {
+        [XCTClockMetric(), XCTCPUMetric(), XCTMemoryMetric(), AllocationCountMetric()]
+    }
+    
+    override func setUp() {
+        super.setUp()
+        XCTAssertEqual(initializeProcessBridge(), BRIDGE_SUCCESS)
+    }
+    
+    // MARK: - Live Scans
+    
+    // Full bridge scan as the scheduler runs it: sysctl, names/paths for new
+    // processes, window copy and the snapshot copy-out
+    func testFullScan() {
+        measure(metrics: metrics, options: options) {
+            var snapshot = ProcessSnapshot()
+            XCTAssertGreaterThanOrEqual(getAllProcesses(&snapshot), 0)
+            freeProcessSnapshot(&snapshot)
+        }
+    }
+    
+    // A tick that reuses a recent scan (max-age path)
+    func testSharedScan() {
+        var warm = ProcessSnapshot()
+        XCTAssertGreaterThanOrEqual(getAllProcesses(&warm), 0)
+        freeProcessSnapshot(&warm)
+        
+        measure(metrics: metrics, options: options) {
+            var snapshot = ProcessSnapshot()
+            XCTAssertGreaterThanOrEqual(getAllProcessesWithMaxAge(&snapshot, 60_000), 0)
+            freeProcessSnapshot(&snapshot)
+        }
+    }
+    
+    // The sysctl(KERN_PROC_ALL) the scan starts with
+    func testPhaseSysctl() {
+        measure(metrics: metrics, options: options) {
+            XCTAssertFalse(Self.copyProcessTable().isEmpty)
+        }
+    }
+    
+    // Per-process name and path lookups, which a cold scan does for every
+    // process and a steady-state scan only for new ones
+    func testPhaseProcessInfo() {
+        let pids = Self.copyProcessTable().map { $0.kp_proc.p_pid }
+        var name = [CChar](repeating: 0, count: 256)
+        var path = [CChar](repeating: 0, count: Int(MAXPATHLEN) * 4)
+        
+        measure(metrics: metrics, options: options) {
+            for pid in pids {
+                _ = getProcessName(pid, &name, name.count)
+                _ = getProcessPath(pid, &path, path.count)
+            }
+        }
+    }
+    
+    // One WindowServer copy plus per-owner aggregation
+    func testPhaseWindowCopy() {
+        measure(metrics: metrics, options: options) {
+            var snapshot = WindowSnapshot()
+            XCTAssertEqual(createWindowSnapshot(&snapshot), BRIDGE_SUCCESS)
+            freeWindowSnapshot(&snapshot)
+        }
+    }
+    
+    // Bridge snapshot to ScanSnapshot, tree index and every name/path String
+    func testPhaseSwiftConversion() {
+        measure(metrics: metrics, options: options) {
+            guard let snapshot = ScanSnapshot.capture() else {
+                XCTFail("Snapshot capture failed")
+                return
+            }
+            var characters = 0
+            for process in snapshot {
+                characters += process.name.utf8.count + process.path.utf8.count
+            }
+            XCTAssertGreaterThan(characters, 0)
+        }
+    }
+    
+    // MARK: - Hashing
+    
+    // Streaming SHA256 past the cache, i.e. the first sighting of a binary.
+    // The cache is the host app's, so it is bypassed rather than cleared.
+    func testHashUncached() throws {
+        let url = try Self.makeHashFile()
+        defer { try? FileManager.default.removeItem(at: url) }
+        var hash = [CChar](repeating: 0, count: 65)
+        
+        measure(metrics: metrics, options: options) {
+            XCTAssertEqual(calculateFileSHA256Uncached(url.path, &hash, hash.count), BRIDGE_SUCCESS)
+        }
+    }
+    
+    // Same file again: the file-identity cache should answer without reading it
+    func testHashCached() throws {
+        let url = try Self.makeHashFile()
+        defer { try? FileManager.default.removeItem(at: url) }
+        var hash = [CChar](repeating: 0, count: 65)
+        XCTAssertEqual(calculateFileSHA256(url.path, &hash, hash.count), BRIDGE_SUCCESS)
+        
+        measure(metrics: metrics, options: options) {
+            for _ in 0..<1_000 {
+                XCTAssertEqual(calculateFileSHA256(url.path, &hash, hash.count), BRIDGE_SUCCESS)
+            }
+        }
+    }
+    
+    // MARK: - Synthetic Fixtures
+    
+    func testTreeIndex500() { measureTreeIndex(processCount: Self.fixtureSizes[0]) }
+    func testTreeIndex2000() { measureTreeIndex(processCount: Self.fixtureSizes[1]) }
+    func testTreeIndex10000() { measureTreeIndex(processCount: Self.fixtureSizes[2]) }
+    
+    func testNameMatching500() { measureNameMatching(processCount: Self.fixtureSizes[0]) }
+    func testNameMatching2000() { measureNameMatching(processCount: Self.fixtureSizes[1]) }
+    func testNameMatching10000() { measureNameMatching(processCount: Self.fixtureSizes[2]) }
+    
+    func testAdvancedPass500() { measureAdvancedPass(processCount: Self.fixtureSizes[0]) }
+    func testAdvancedPass2000() { measureAdvancedPass(processCount: Self.fixtureSizes[1]) }
+    func testAdvancedPass10000() { measureAdvancedPass(processCount: Self.fixtureSizes[2]) }
+    
+    func testWindowColumns500() { measureWindowColumns(windowCount: Self.fixtureSizes[0]) }
+    func testWindowColumns2000() { measureWindowColumns(windowCount: Self.fixtureSizes[1]) }
+    func testWindowColumns10000() { measureWindowColumns(windowCount: Self.fixtureSizes[2]) }
+    
+    func testWindowStateDiff500() { measureWindowStateDiff(windowCount: Self.fixtureSizes[0]) }
+    func testWindowStateDiff2000() { measureWindowStateDiff(windowCount: Self.fixtureSizes[1]) }
+    func testWindowStateDiff10000() { measureWindowStateDiff(windowCount: Self.fixtureSizes[2]) }
+    
+    // ScanSnapshot construction: pid index, root resolution, bundle checks
+    private func measureTreeIndex(processCount: Int) {
+        measure(metrics: metrics, options: manualOptions) {
+            let fixture = Self.makeFixture(processCount: processCount)
+            startMeasuring()
+            let snapshot = ScanSnapshot.adopting(fixture)
+            stopMeasuring()
+            XCTAssertEqual(snapshot.count, processCount)
+        }
+    }
+    
+    private func measureNameMatching(processCount: Int) {
+        let snapshot = ScanSnapshot.adopting(Self.makeFixture(processCount: processCount))
+        let matcher = NameMatcher(patterns: Self.rulePatterns)
+        
+        measure(metrics: metrics, options: options) {
+            var hits = 0
+            for process in snapshot {
+                hits += matcher.allMatches(in: process.nameBytes).count
+                hits += matcher.allMatches(in: process.pathBytes).count
+            }
+            XCTAssertGreaterThan(hits, 0)
+        }
+    }
+    
+    // Everything detectAdvancedSuspiciousProcesses does per process: name,
+    // path and signature checks, window checks, helper attribution and scoring.
+    // Fixture pids are above the kernel's pid range, so signature lookups miss
+    // and hashing of the (nonexistent) fixture paths fails fast.
+    private func measureAdvancedPass(processCount: Int) {
+        let snapshot = ScanSnapshot.adopting(Self.makeFixture(processCount: processCount))
+        let detector = SuspiciousProcessDetector()
+        detector.configure(processNames: Self.rulePatterns, paths: [], hashes: [])
+        detector.configureAdvancedDetection(enabled: true)
+        
+        measure(metrics: metrics, options: options) {
+            XCTAssertFalse(detector.detectAdvancedSuspiciousProcesses(snapshot: snapshot).isEmpty)
+        }
+    }
+    
+    // Everything after the WindowServer copy that builds a snapshot: column
+    // decode, off-screen marking and per-owner counters. decodeWindowSnapshot
+    // leaves the host app's window state cache alone.
+    private func measureWindowColumns(windowCount: Int) {
+        let windowList = Self.makeWindowList(windowCount: windowCount)
+        
+        measure(metrics: metrics, options: options) {
+            var snapshot = WindowSnapshot()
+            XCTAssertEqual(decodeWindowSnapshot(windowList, &snapshot), BRIDGE_SUCCESS)
+            freeWindowSnapshot(&snapshot)
+        }
+    }
+    
+    // The state diff against a private cache, alternating between two lists
+    // that differ in a tenth of their windows, so every iteration emits and
+    // drains window events
+    private func measureWindowStateDiff(windowCount: Int) {
+        let windowLists = [Self.makeWindowList(windowCount: windowCount), Self.makeWindowList(windowCount: windowCount, variant: 1)]
+        guard let cache = createWindowStateCache() else {
+            XCTFail("Window state cache allocation failed")
+            return
+        }
+        defer { freeWindowStateCache(cache) }
+        
+        XCTAssertEqual(updateWindowStateCacheFromList(cache, windowLists[0]), BRIDGE_SUCCESS)
+        Self.drainWindowEvents(from: cache)
+        
+        var next = 1
+        measure(metrics: metrics, options: options) {
+            XCTAssertEqual(updateWindowStateCacheFromList(cache, windowLists[next]), BRIDGE_SUCCESS)
+            XCTAssertGreaterThan(Self.drainWindowEvents(from: cache), 0)
+            next = 1 - next
+        }
+    }
+    
+    @discardableResult
+    private static func drainWindowEvents(from cache: OpaquePointer) -> Int {
+        var delta = WindowEventDelta()
+        let count = getWindowStateCacheEvents(cache, &delta)
+        freeWindowEventDelta(&delta)
+        return Int(count)
+    }
+    
+    // MARK: - Fixture Builders
+    
+    private static let rulePatterns = ["cluely", "interview coder", "final round", "leetcode wizard", "overlay"]
+    
+    // A plausible process table: daemons, apps, and Electron-style apps with
+    // several bundled helpers each. About 1 in 50 apps has an evasive window
+    // and 1 in 100 a suspicious name.
+    static func makeFixture(processCount: Int) -> ProcessSnapshot {
+        var strings: [UInt8] = [0]
+        var records: [SystemProcessInfo] = []
+        records.reserveCapacity(processCount)
+        
+        func intern(_ string: String) -> (UInt32, UInt16) {
+            let offset = UInt32(strings.count)
+            strings.append(contentsOf: string.utf8)
+            strings.append(0)
+            return (offset, UInt16(string.utf8.count))
+        }
+        
+        func append(name: String, path: String, parentPid: pid_t, windows: Int, evasive: Int) -> pid_t {
+            let pid = pid_t(100_000 + records.count)
+            let (nameOffset, nameLength) = intern(name)
+            let (pathOffset, pathLength) = intern(path)
+            
+            var record = SystemProcessInfo()
+            record.pid = pid
+            record.nameOffset = nameOffset
+            record.nameLength = nameLength
+            record.pathOffset = pathOffset
+            record.pathLength = pathLength
+            record.windowCount = Int32(windows)
+            record.screenEvasionCount = Int32(evasive)
+            record.sharingDisabledCount = Int32(evasive)
+            record.startTime = 1_700_000_000_000_000 + UInt64(records.count)
+            record.parentPid = parentPid
+            records.append(record)
+            return pid
+        }
+        
+        var appIndex = 0
+        while records.count < processCount {
+            appIndex += 1
+            
+            if appIndex % 3 == 0 {
+                _ = append(name: "daemon\(appIndex)d", path: "/usr/libexec/daemon\(appIndex)d", parentPid: 1, windows: 0, evasive: 0)
+                continue
+            }
+            
+            let appName = appIndex % 100 == 0 ? "Cluely \(appIndex)" : "Synthetic App \(appIndex)"
+            let bundle = "/Applications/\(appName).app"
+            let evasive = appIndex % 50 == 0 ? 2 : 0
+            let appPid = append(name: appName, path: "\(bundle)/Contents/MacOS/\(appName)", parentPid: 1, windows: 1 + appIndex % 3, evasive: evasive)
+            
+            // Every other app is Electron-style
+            guard appIndex % 2 == 0 else { continue }
+            for helper in ["Helper", "Helper (GPU)", "Helper (Renderer)", "Helper (Renderer)", "Helper (Plugin)"] where records.count < processCount {
+                let helperName = "\(appName) \(helper)"
+                let helperPath = "\(bundle)/Contents/Frameworks/\(helperName).app/Contents/MacOS/\(helperName)"
+                _ = append(name: helperName, path: helperPath, parentPid: appPid, windows: helper == "Helper (Renderer)" ? 1 : 0, evasive: evasive)
+            }
+        }
+        
+        // Into malloc'd buffers, which is what freeProcessSnapshot releases
+        let processes = malloc(records.count * MemoryLayout<SystemProcessInfo>.stride)!.bindMemory(to: SystemProcessInfo.self, capacity: records.count)
+        processes.initialize(from: records, count: records.count)
+        let arena = malloc(strings.count)!.bindMemory(to: CChar.self, capacity: strings.count)
+        strings.withUnsafeBytes { bytes in
+            UnsafeMutableRawPointer(arena).copyMemory(from: bytes.baseAddress!, byteCount: bytes.count)
+        }
+        
+        var snapshot = ProcessSnapshot()
+        snapshot.processes = processes
+        snapshot.count = Int32(records.count)
+        snapshot.strings = arena
+        snapshot.stringsSize = strings.count
+        return snapshot
+    }
+    
+    // A window list in CGWindowListCopyWindowInfo format, four windows per
+    // owner, 1 in 20 above the normal app layer (menus, panels). Variant 1
+    // replaces every 10th window with a new one, moves every 25th off-screen
+    // and excludes every 50th from capture.
+    static func makeWindowList(windowCount: Int, variant: Int = 0) -> CFArray {
+        var windows: [[String: Any]] = []
+        windows.reserveCapacity(windowCount)
+        
+        for index in 0..<windowCount {
+            let isChanged = variant != 0
+            let isReplaced = isChanged && index % 10 == 0
+            let isOffScreen = isChanged && index % 25 == 0
+            let isCaptureExcluded = isChanged && index % 50 == 0
+            let bounds = isOffScreen
+                ? CGRect(x: -20_000, y: -20_000, width: 400, height: 300)
+                : CGRect(x: Double(index % 40) * 30, y: Double(index % 25) * 30, width: 800, height: 600)
+            
+            windows.append([
+                kCGWindowNumber as String: 10_000 + index + (isReplaced ? 1_000_000 : 0),
+                kCGWindowOwnerPID as String: 100_000 + index / 4,
+                kCGWindowLayer as String: index % 20 == 0 ? 101 : 0,
+                kCGWindowSharingState as String: isCaptureExcluded ? 0 : 1,
+                kCGWindowIsOnscreen as String: true,
+                kCGWindowBounds as String: bounds.dictionaryRepresentation
+            ])
+        }
+        return windows as CFArray
+    }
+    
+    private static func copyProcessTable() -> [kinfo_proc] {
+        var mib: [Int32] = [CTL_KERN, KERN_PROC, KERN_PROC_ALL, 0]
+        var size = 0
+        guard sysctl(&mib, 4, nil, &size, nil, 0) == 0, size > 0 else { return [] }
+        
+        var table = [kinfo_proc](repeating: kinfo_proc(), count: size / MemoryLayout<kinfo_proc>.stride + 16)
+        size = table.count * MemoryLayout<kinfo_proc>.stride
+        guard sysctl(&mib, 4, &table, &size, nil, 0) == 0 else { return [] }
+        return Array(table.prefix(size / MemoryLayout<kinfo_proc>.stride))
+    }
+    
+    private static func makeHashFile() throws -> URL {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("truely-hash-benchmark-\(UUID().uuidString).bin")
+        var data = Data(count: hashFileBytes)
+        data.withUnsafeMutableBytes { bytes in
+            arc4random_buf(bytes.baseAddress, bytes.count)
+        }
+        try data.write(to: url)
+        return url
+    }
+}
+
+// Net malloc blocks and bytes left allocated by one iteration, across all
+// zones. A rise shows up as a leak or a cache that stopped being reused.
+// Heap allocation calls during each iteration, counted by the bridge's
+// malloc_logger hook. Unlike net blocks in use, an allocation freed before the
+// iteration ends still counts, so a per-call buffer shows up as a regression.
+final class AllocationCountMetric: NSObject, XCTMetric {
+    private var count: UInt64 = 0
+    
+    func copy(with zone: NSZone? = nil) -> Any {
+        AllocationCountMetric()
+    }
+    
+    func willBeginMeasuring() {
+        beginAllocationCounting()
+    }
+    
+    func didStopMeasuring() {
+        count = endAllocationCounting()
+    }
+    
+    func reportMeasurements(from startTime: XCTPerformanceMeasurementTimestamp, to endTime: XCTPerformanceMeasurementTimestamp) throws -> [XCTPerformanceMeasurement] {
+        [
+            XCTPerformanceMeasurement(identifier: "com.truely.malloc.calls", displayName: "Allocations",
+                                      doubleValue: Double(count), unitSymbol: "allocations")
+        ]
+    }
+}